@@ -2,6 +2,7 @@ TEMPLATE = app
 CONFIG += c++14
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 QMAKE_CXXFLAGS_DEBUG += -pg
 QMAKE_LFLAGS_DEBUG += -pg
@@ -15,21 +16,59 @@ CONFIG += link_pkgconfig
 DESTDIR = $$PWD
 TARGET = Engine
 SOURCES += src/main.cpp \
+    chimp/src/ChimpAnimation.cpp \
+    chimp/src/ChimpAssetCache.cpp \
+    chimp/src/ChimpAssetLoader.cpp \
+    chimp/src/ChimpAssetPack.cpp \
+    chimp/src/ChimpAudio.cpp \
     chimp/src/ChimpCharacter.cpp \
+    chimp/src/ChimpCookedLevel.cpp \
+    chimp/src/ChimpFrameClock.cpp \
     chimp/src/ChimpGame.cpp \
+    chimp/src/ChimpInitGraph.cpp \
+    chimp/src/ChimpJobSystem.cpp \
     chimp/src/ChimpLuaInterface.cpp \
+    chimp/src/ChimpMappedFile.cpp \
     chimp/src/ChimpMobile.cpp \
+    chimp/src/ChimpNameTable.cpp \
     chimp/src/ChimpObject.cpp \
+    chimp/src/ChimpProfiler.cpp \
+    chimp/src/ChimpRenderPacket.cpp \
+    chimp/src/ChimpScreen.cpp \
+    chimp/src/ChimpStartupTrace.cpp \
+    chimp/src/ChimpTextRenderer.cpp \
+    chimp/src/ChimpTimerWheel.cpp \
+    chimp/src/ChimpVoiceManager.cpp \
+    chimp/src/ChimpXMLReader.cpp \
     ../src/tinyxml2.cpp
 
 HEADERS += \
+    chimp/include/ChimpAnimation.h \
+    chimp/include/ChimpAssetCache.h \
+    chimp/include/ChimpAssetLoader.h \
+    chimp/include/ChimpAssetPack.h \
+    chimp/include/ChimpAudio.h \
     chimp/include/ChimpCharacter.h \
+    chimp/include/ChimpCookedLevel.h \
+    chimp/include/ChimpFrameClock.h \
     chimp/include/ChimpGame.h \
+    chimp/include/ChimpInitGraph.h \
+    chimp/include/ChimpJobSystem.h \
     chimp/include/ChimpLuaInterface.h \
+    chimp/include/ChimpMappedFile.h \
     chimp/include/ChimpMobile.h \
+    chimp/include/ChimpNameTable.h \
     chimp/include/ChimpObject.h \
+    chimp/include/ChimpProfiler.h \
+    chimp/include/ChimpRenderPacket.h \
+    chimp/include/ChimpScreen.h \
+    chimp/include/ChimpStartupTrace.h \
     chimp/include/ChimpStructs.h \
+    chimp/include/ChimpTextRenderer.h \
     chimp/include/ChimpTile.h \
+    chimp/include/ChimpTimerWheel.h \
+    chimp/include/ChimpVoiceManager.h \
+    chimp/include/ChimpXMLReader.h \
     include/ChimpConstants.h \
     include/cleanup.h \
     ../include/tinyxml2.h
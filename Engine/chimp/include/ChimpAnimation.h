@@ -0,0 +1,66 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPANIMATION_H
+#define CHIMPANIMATION_H
+
+#include "ChimpTile.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace chimp
+{
+
+typedef size_t ClipId;
+
+/*
+ * One animation, shared by every Character that plays it. Frames point at the ChimpGame's tiles, so a clip never
+ * outlives the level it was loaded from.
+ */
+struct AnimationClip
+{
+    std::vector<const ChimpTile*> frames;
+    std::vector<Uint32> durations; // miliseconds per frame, for clips advanced by time
+    int distancePerFrame = 0;      // pixels per frame, for clips advanced by movement; 0 if advanced by time
+    
+    inline size_t size() const { return frames.size(); }
+    bool operator==(const AnimationClip& rhs) const
+        { return frames == rhs.frames && durations == rhs.durations && distancePerFrame == rhs.distancePerFrame; }
+};
+
+class ChimpAnimationRegistry
+{
+private:
+    std::vector<AnimationClip> clips;
+    std::unordered_multimap<size_t, ClipId> byHash; // ids of the clips by hash(), to find duplicates
+    
+public:
+    ClipId add(const AnimationClip& clip);
+    inline const AnimationClip& get(const ClipId id) const { return clips[id]; }
+    inline size_t size() const { return clips.size(); }
+    inline void clear() { clips.clear(); byHash.clear(); }
+    
+private:
+    static size_t hash(const AnimationClip& clip);
+};
+
+} // namespace chimp
+
+#endif // CHIMPANIMATION_H
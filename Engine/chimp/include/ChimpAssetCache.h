@@ -0,0 +1,91 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPASSETCACHE_H
+#define CHIMPASSETCACHE_H
+
+#include <SDL2/SDL.h>
+#if defined (__gnu_linux__) || defined (_WIN32)
+#include <SDL2/SDL_mixer.h>
+#endif
+#if defined (__APPLE__) && defined (__MACH__)
+#include <SDL2_mixer/SDL_mixer.h>
+#endif
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace chimp
+{
+
+enum AssetKind { ASSET_TEXTURE, ASSET_SOUND, ASSET_MUSIC };
+
+struct ChimpAssetKey
+{
+    AssetKind kind;
+    std::string file;
+    uint64_t hash; // of the file's contents, so an edited file is never mistaken for the cached one
+    
+    bool operator<(const ChimpAssetKey& other) const;
+};
+
+/*
+ * Decoded assets shared between levels. Each entry is keyed by file and content hash and counts the levels holding
+ * it; the last release frees it. Switching levels acquires the next level's assets before releasing the previous
+ * level's, so anything both levels use is never reloaded. Lookups may come from any thread, but textures are only
+ * created and destroyed on the thread owning the renderer.
+ */
+class ChimpAssetCache
+{
+private:
+    struct Entry
+    {
+        SDL_Texture* texture = nullptr;
+        Mix_Chunk* chunk = nullptr;
+        Mix_Music* music = nullptr;
+        int refs = 0;
+    };
+    
+    std::map<ChimpAssetKey, Entry> entries;
+    mutable std::mutex mutex;
+    
+public:
+    ChimpAssetCache() {}
+    ~ChimpAssetCache();
+    ChimpAssetCache(const ChimpAssetCache&) = delete;
+    ChimpAssetCache& operator=(const ChimpAssetCache&) = delete;
+    
+    bool contains(const ChimpAssetKey& key) const;
+    bool acquire(const ChimpAssetKey& key, SDL_Texture*& texture, Mix_Chunk*& chunk, Mix_Music*& music);
+    void insert(const ChimpAssetKey& key, SDL_Texture*& texture, Mix_Chunk*& chunk, Mix_Music*& music);
+    void release(const ChimpAssetKey& key);
+    size_t size() const;
+    
+    static bool hash(const std::string& file, uint64_t& hash);
+    static uint64_t hash(const char* const data, const size_t size);
+    
+private:
+    static void free(Entry& entry);
+};
+
+} // namespace chimp
+
+#endif // CHIMPASSETCACHE_H
@@ -0,0 +1,103 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPASSETLOADER_H
+#define CHIMPASSETLOADER_H
+
+#include "ChimpAssetCache.h"
+#include "ChimpJobSystem.h"
+
+#include <SDL2/SDL.h>
+#if defined (__gnu_linux__) || defined (_WIN32)
+#include <SDL2/SDL_mixer.h>
+#endif
+#if defined (__APPLE__) && defined (__MACH__)
+#include <SDL2_mixer/SDL_mixer.h>
+#endif
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace chimp
+{
+
+struct ChimpAssetTiming
+{
+    std::string name, file;
+    double decodeMs;  // on a worker thread
+    double uploadMs;  // on the render thread, textures only
+    bool cached;      // already loaded by an earlier level, so only hashed
+};
+
+/*
+ * Loads a level's textures, sounds and music in parallel. Files are queued first, then decode() hashes them all at once
+ * on the job system and decodes those not already in the asset cache: images into SDL_Surfaces and sound effects into
+ * PCM chunks. decode() can run on any thread, e.g. to preload the next level in the background. Only upload(), which
+ * turns surfaces into textures and takes the cache references, is left for the thread owning the renderer.
+ */
+class ChimpAssetLoader
+{
+private:
+    struct Asset
+    {
+        ChimpAssetKey key;
+        std::string name;
+        bool cached = false; // only has a cache reference once acquired
+        SDL_Surface* surface = nullptr;
+        SDL_Texture* texture = nullptr;
+        Mix_Chunk* chunk = nullptr;
+        Mix_Music* music = nullptr;
+        std::string error; // set by the worker if decoding failed
+        double decodeMs = 0, uploadMs = 0;
+    };
+    
+    ChimpJobSystem& jobs;
+    ChimpAssetCache& cache;
+    std::vector<Asset> assets;
+    
+public:
+    ChimpAssetLoader(ChimpJobSystem& jobSystem, ChimpAssetCache& assetCache) : jobs(jobSystem), cache(assetCache) {}
+    ~ChimpAssetLoader();
+    ChimpAssetLoader(const ChimpAssetLoader&) = delete;
+    ChimpAssetLoader& operator=(const ChimpAssetLoader&) = delete;
+    
+    void addTexture(const std::string& name, const std::string& file);
+    void addSound(const std::string& name, const std::string& file);
+    void addMusic(const std::string& name, const std::string& file);
+    void decode();
+    bool upload(SDL_Renderer* const renderer, std::vector<SDL_Texture*>& textures, std::vector<Mix_Chunk*>& sounds,
+                std::vector<Mix_Music*>& musics, std::vector<ChimpAssetKey>& keys,
+                std::vector<ChimpAssetTiming>& timings);
+    inline bool load(SDL_Renderer* const renderer, std::vector<SDL_Texture*>& textures, std::vector<Mix_Chunk*>& sounds,
+                     std::vector<Mix_Music*>& musics, std::vector<ChimpAssetKey>& keys,
+                     std::vector<ChimpAssetTiming>& timings)
+        { decode(); return upload(renderer, textures, sounds, musics, keys, timings); }
+    
+    static void report(const std::vector<ChimpAssetTiming>& timings, std::ostream& out);
+    
+private:
+    void add(const AssetKind kind, const std::string& name, const std::string& file);
+    static void decode(Asset& asset, const ChimpAssetCache* const skipCached);
+    void freeAll();
+};
+
+} // namespace chimp
+
+#endif // CHIMPASSETLOADER_H
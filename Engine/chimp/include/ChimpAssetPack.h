@@ -0,0 +1,101 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPASSETPACK_H
+#define CHIMPASSETPACK_H
+
+#include "ChimpMappedFile.h"
+
+#include <SDL2/SDL.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <lua.hpp>
+
+namespace chimp
+{
+
+/*
+ * Every asset in one file, so loading a level costs one open instead of one per texture, sound and script. A pack is a
+ * header, an index sorted by path, the paths, then one blob per file, each starting on a PACK_ALIGNMENT boundary.
+ * Blobs are stored raw or, if it makes them smaller, LZ4 block compressed.
+ *
+ * The pack is mapped once. Loaders ask for files by the same path they would open (e.g. "assets/monkey.png") and get
+ * memory backed SDL_RWops or Lua chunks. Anything not in the pack, or everything if there is no pack, is loaded from
+ * loose files, so assets can be edited during development without repacking.
+ */
+class ChimpAssetPack
+{
+public:
+    static constexpr uint32_t
+        PACK_MAGIC     = 0x4B415043, // "CPAK" read as a little endian uint32_t
+        PACK_VERSION   = 1,
+        PACK_ENDIAN    = 0x01020304,
+        PACK_ALIGNMENT = 16,
+        PACK_LZ4       = 1<<0;
+    
+    struct Header
+    {
+        uint32_t magic, version, endian, count;
+    };
+    
+    struct Entry
+    {
+        uint32_t path;       // offset of the NUL terminated path
+        uint32_t offset;     // offset of the blob
+        uint32_t storedSize; // size of the blob
+        uint32_t size;       // size of the file
+        uint32_t flags;
+    };
+    
+private:
+    ChimpMappedFile file;
+    const Entry* entries;
+    uint32_t count;
+    std::map<uint32_t, std::vector<char>> decompressed; // by entry index, kept until unmount()
+    std::mutex mutex;
+    
+    ChimpAssetPack() : entries(nullptr), count(0) {}
+    
+public:
+    static ChimpAssetPack& getPack();
+    ChimpAssetPack(const ChimpAssetPack&) = delete;
+    ChimpAssetPack& operator=(const ChimpAssetPack&) = delete;
+    
+    bool mount(const std::string& packFile);
+    void unmount();
+    inline bool isMounted() const { return file.isOpen(); }
+    inline bool contains(const std::string& path) const { return findEntry(path); }
+    bool find(const std::string& path, const char*& data, size_t& size);
+    SDL_RWops* openRW(const std::string& path);
+    int loadLua(lua_State* const luast, const std::string& path);
+    
+    static bool write(const std::string& packFile, std::vector<std::string> paths, const bool compress);
+    
+private:
+    const Entry* findEntry(const std::string& path) const;
+    bool validate() const;
+};
+
+} // namespace chimp
+
+#endif // CHIMPASSETPACK_H
@@ -0,0 +1,121 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPAUDIO_H
+#define CHIMPAUDIO_H
+
+#include "ChimpVoiceManager.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chimp
+{
+
+enum AudioOp { AUDIO_PLAY, AUDIO_STOP, AUDIO_POSITION, AUDIO_MUSIC, AUDIO_HALT };
+
+struct ChimpAudioCommand
+{
+    AudioOp op;
+    VoiceId voice;          // play, stop and position
+    Mix_Chunk* chunk;       // play
+    Mix_Music* music;       // music; null halts the music
+    VoicePriority priority; // play
+    float gain, pan;        // play and position
+};
+
+/*
+ * Fixed size ring of audio commands with one producer and one consumer. Each side only writes its own index, so
+ * push() and pop() never wait; push() fails if the ring is full.
+ */
+class ChimpAudioQueue
+{
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    
+    std::vector<ChimpAudioCommand> commands;
+    size_t mask;
+    std::atomic<size_t> head; // next to pop, written by the consumer
+    char padding[CACHE_LINE]; // keeps the indices apart, so each side's writes don't evict the other's
+    std::atomic<size_t> tail; // next to push, written by the producer
+    
+public:
+    explicit ChimpAudioQueue(const size_t capacity);
+    ChimpAudioQueue(const ChimpAudioQueue&) = delete;
+    ChimpAudioQueue& operator=(const ChimpAudioQueue&) = delete;
+    
+    bool push(const ChimpAudioCommand& command);
+    bool pop(ChimpAudioCommand& command);
+    inline bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+};
+
+/*
+ * Plays the game's sound and music on a thread of its own. The simulation sends commands through a ChimpAudioQueue and
+ * never takes SDL_mixer's audio lock; the audio thread runs them on a ChimpVoiceManager. Commands are dropped if the
+ * queue is full. The audio thread sleeps while the queue is empty and is only woken when a command is sent to it.
+ * Commands are plain values all sent through send(), which is where they would be recorded for replay. Nothing
+ * records them now: they name sounds by Mix_Chunk pointer, so a recording could only replay while the same level is
+ * loaded.
+ * 
+ * Everything but the destructor is called from the simulation thread.
+ */
+class ChimpAudioService
+{
+private:
+    ChimpAudioQueue queue;
+    ChimpVoiceManager voices; // only used by the audio thread
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping;
+    std::atomic<bool> sleeping; // the audio thread is waiting, or about to, and needs waking by the next command
+    std::atomic<Uint32> done; // commands run by the audio thread
+    Uint32 sent, dropped;
+    VoiceId nextVoice;
+    
+public:
+    ChimpAudioService(const int voiceCount, const size_t queueSize);
+    ~ChimpAudioService();
+    ChimpAudioService(const ChimpAudioService&) = delete;
+    ChimpAudioService& operator=(const ChimpAudioService&) = delete;
+    
+    VoiceId play(Mix_Chunk* const chunk, const VoicePriority priority = VOICE_NORMAL, const float gain = 1,
+                 const float pan = 0);
+    VoiceId playAt(Mix_Chunk* const chunk, const Box<float>& source, const IntBox& view, const int zone,
+                   const VoicePriority priority = VOICE_NORMAL);
+    void stop(const VoiceId voice);
+    void setPosition(const VoiceId voice, const float gain, const float pan);
+    void playMusic(Mix_Music* const music);
+    void halt();
+    void wait();
+    
+    inline Uint32 getDropped() const { return dropped; }
+    
+private:
+    void send(const ChimpAudioCommand& command);
+    void run();
+    void execute(const ChimpAudioCommand& command);
+};
+
+} // namespace chimp
+
+#endif // CHIMPAUDIO_H
@@ -22,6 +22,7 @@
 
 #include "ChimpObject.h"
 #include "ChimpMobile.h"
+#include "ChimpAnimation.h"
 
 #if defined (__gnu_linux__) || defined (_WIN32)
 #include <SDL2/SDL_mixer.h>
@@ -36,25 +37,25 @@ namespace chimp
 {
 
 class ChimpGame;
-
-typedef std::vector<ChimpTile> TileVec;
     
 class ChimpCharacter : public ChimpMobile
 {
 protected:
-    Uint32 idleTime; // 0 means not idleing
-    size_t tileIndex;
+    double animationTime; // game miliseconds this Character has been updated for; idle clips advance with it
+    double idleTime;      // animationTime the current idle frame started at; negative means not idleing
+    const ChimpAnimationRegistry& clips;
+    ClipId clipRun, clipJump, clipIdle, clipCurrent; // ids in clips
+    size_t frameCursor;
     bool vulnerable;
-    TileVec tilesRun, tilesJump, tilesIdle;
     Coordinate moveStart;
     int maxHealth, health;
     Mix_Chunk* soundJump;
     Mix_Chunk* soundMultijump;
     
 public:
-    ChimpCharacter(SDL_Renderer* const rend, const TileVec& tilRn, const TileVec& tilJmp, const TileVec& tilIdl,
-                   const int pX = 0, const int pY = 0, const int tilesX = 1, const int tilesY = 1,
-                   const Faction frnds = FACTION_VOID, const Faction enms = FACTION_VOID,
+    ChimpCharacter(SDL_Renderer* const rend, const ChimpAnimationRegistry& clps, const ClipId clpRn,
+                   const ClipId clpJmp, const ClipId clpIdl, const int pX = 0, const int pY = 0, const int tilesX = 1,
+                   const int tilesY = 1, const Faction frnds = FACTION_VOID, const Faction enms = FACTION_VOID,
                    const int maxH = HEALTH);
     ~ChimpCharacter() {}
     
@@ -62,12 +63,12 @@ public:
     
     inline bool getVulnerable() const { return vulnerable; }
     inline void setVulnerable(const bool vul) { vulnerable = vul; }
-    inline TileVec& getTilesIdle() { return tilesIdle; }
-    inline bool setTilesIdle(const TileVec& vec);
-    inline TileVec& getTilesRun() { return tilesRun; }
-    inline bool setTilesRun(const TileVec& vec);
-    inline TileVec& getTilesJump() { return tilesJump; }
-    inline bool setTilesJump(const TileVec& vec);
+    inline ClipId getClipIdle() const { return clipIdle; }
+    inline void setClipIdle(const ClipId clip) { clipIdle = clip; }
+    inline ClipId getClipRun() const { return clipRun; }
+    inline void setClipRun(const ClipId clip) { clipRun = clip; }
+    inline ClipId getClipJump() const { return clipJump; }
+    inline void setClipJump(const ClipId clip) { clipJump = clip; }
     inline void setSoundJump(Mix_Chunk* const sound) { soundJump = sound; }
     inline void setSoundMultijump(Mix_Chunk* const sound) { soundMultijump = sound; }
     
@@ -76,25 +77,19 @@ public:
     void jump(ChimpGame& game);
     void reset();
     
-    #pragma GCC diagnostic push
-    #pragma GCC diagnostic ignored "-Wunused-parameter"
-    static Uint32 vulnerableTimer(Uint32 interval, void* character)
-    {
-        ((ChimpCharacter*)character)->setVulnerable(true);
-        return 0;
-    }
-    #pragma GCC diagnostic pop
-    
     int getHealth() const { return health; }
     void setHealth(const int heal) { health = heal; }
     int getMaxHealth() const { return maxHealth; }
     bool setMaxHealth(const int heal);// { maxHealth = heal; }
     
-    void update(const ObjectVector& objects, ChimpGame& game, const Uint32 time);
+    void update(const ObjectVector& objects, ChimpGame& game, const double time);
     void render(const IntBox& screen);
+    void record(const IntBox& screen, ChimpRenderPacket& packet);
     
 protected:
-    inline void playSound(Mix_Chunk* const sound, const ChimpGame& game) const;
+    void animate();
+    void startClip(const ClipId clip);
+    void playSound(Mix_Chunk* const sound, ChimpGame& game) const;
 };
 
 } // namespace chimp
@@ -0,0 +1,182 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPCOOKEDLEVEL_H
+#define CHIMPCOOKEDLEVEL_H
+
+#include "ChimpMappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace chimp
+{
+
+/*
+ * Binary level format. A cooked level is one blob: a header, then flat arrays of the records below, then a name table.
+ * Every cross reference is an index, so turning a blob into a level never looks anything up by name. All records are
+ * made of 4 byte fields and every array starts on a 4 byte boundary, so a blob can be used in place straight from a
+ * mapped file. Blobs are written in the cooking machine's byte order, which the header records.
+ *
+ * The XML stays the authoring format. Loading an XML level cooks it in memory first, in a single streaming pass, so
+ * both paths build the level from the same records.
+ */
+
+static constexpr uint32_t
+    COOKED_MAGIC   = 0x4C564C43, // "CLVL" read as a little endian uint32_t
+    COOKED_VERSION = 2,
+    COOKED_ENDIAN  = 0x01020304,
+    COOKED_NONE    = 0xFFFFFFFF; // missing index
+
+enum CookedFlags : uint32_t
+{
+    COOKED_SCROLL_BACK   = 1<<0,
+    COOKED_SCROLL_FORE   = 1<<1,
+    COOKED_ACTIVE_ZONE   = 1<<2,
+    COOKED_INACTIVE_ZONE = 1<<3
+};
+
+enum CookedObjectType : uint32_t { COOKED_PLAYER, COOKED_CHARACTER, COOKED_OBJECT };
+enum CookedAnimation : uint32_t { COOKED_ANIM_NONE, COOKED_ANIM_IDLE, COOKED_ANIM_RUN, COOKED_ANIM_JUMP };
+
+/*
+ * Object properties, applied in the order they're stored, which is the order the XML loader always applied them in.
+ * _SCALE variants multiply the current value instead of replacing it.
+ */
+enum CookedOpCode : uint32_t
+{
+    OP_POSITION_X, OP_POSITION_Y, OP_TILES_X, OP_TILES_Y, OP_MAX_HEALTH, OP_RESPAWN,
+    OP_DAMAGE_LEFT, OP_DAMAGE_RIGHT, OP_DAMAGE_TOP, OP_DAMAGE_BOTTOM,
+    OP_BOUND_LEFT, OP_BOUND_RIGHT, OP_BOUND_TOP, OP_BOUND_BOTTOM,
+    OP_STOP_FACTOR, OP_STOP_FACTOR_SCALE, OP_SPRINT_FACTOR, OP_MAX_JUMPS,
+    OP_FRIEND, OP_ENEMY,
+    OP_RUN_ACCEL, OP_RUN_ACCEL_SCALE, OP_JUMP_ACCEL, OP_JUMP_ACCEL_SCALE,
+    OP_RUN_IMPULSE, OP_RUN_IMPULSE_SCALE, OP_JUMP_IMPULSE, OP_JUMP_IMPULSE_SCALE,
+    OP_MULTIJUMP_IMPULSE, OP_MULTIJUMP_IMPULSE_SCALE,
+    OP_RESISTANCE_X, OP_RESISTANCE_X_SCALE, OP_RESISTANCE_Y, OP_RESISTANCE_Y_SCALE,
+    OP_SCRIPT_BEHAVIOR, OP_SCRIPT_INIT, // operand is a name index
+    OP_SOUND_JUMP, OP_SOUND_MULTIJUMP,  // operand is a sound index
+    OP_COUNT
+};
+
+struct CookedArray
+{
+    uint32_t offset, count; // offset in bytes from the start of the blob
+};
+
+struct CookedHeader
+{
+    uint32_t magic, version, endian, size;
+    CookedArray names, textures, tiles, sounds, musics, objects, frames, ops, sections;
+    uint32_t flags;
+    int32_t edgeLeft, edgeRight, edgeTop, edgeBottom;
+    float scrollBack, scrollFore;
+    int32_t activeZone, inactiveZone;
+    uint32_t music; // music index or COOKED_NONE
+    int32_t streamDistance;
+};
+
+struct CookedAsset // textures, sounds and music
+{
+    uint32_t name, file; // name indices
+};
+
+struct CookedTile
+{
+    uint32_t name, texture; // texture index
+    int32_t x, y, width, height, drawWidth, drawHeight;
+    int32_t left, right, top, bottom;
+};
+
+struct CookedFrame // a <tile> child of an object
+{
+    uint32_t tile, animation, duration;
+};
+
+struct CookedObject
+{
+    uint32_t type, layer;
+    uint32_t firstFrame, frameCount;
+    uint32_t firstOp, opCount;
+};
+
+/*
+ * Objects streamed in and out together as the view nears or leaves [left, right]. Sections' objects follow the
+ * objects that are always loaded, in section order.
+ */
+struct CookedSection
+{
+    int32_t left, right;
+    uint32_t firstObject, objectCount;
+};
+
+struct CookedOp
+{
+    uint32_t code;
+    union
+    {
+        int32_t i;
+        uint32_t u;
+        float f;
+    };
+};
+
+/*
+ * A cooked level in memory: mapped from a file, held in a buffer, or borrowed from memory someone else owns (e.g. an
+ * asset pack). Only ever read through, so a mapped file is never copied.
+ */
+class ChimpCookedLevel
+{
+private:
+    const char* data;
+    size_t size;
+    ChimpMappedFile file;     // used when data is a mapped file
+    std::vector<char> buffer; // used when data was cooked here
+    
+public:
+    ChimpCookedLevel();
+    ~ChimpCookedLevel();
+    ChimpCookedLevel(const ChimpCookedLevel&) = delete;
+    ChimpCookedLevel& operator=(const ChimpCookedLevel&) = delete;
+    
+    bool map(const std::string& fileName);
+    bool use(const char* const blob, const size_t length);
+    bool cook(const char* const xml, const size_t length);
+    bool cookFile(const std::string& fileName);
+    bool write(const std::string& fileName) const;
+    void clear();
+    void listFiles(std::vector<std::string>& files) const;
+    
+    static bool isCooked(const std::string& fileName);
+    static bool isCooked(const char* const blob, const size_t length);
+    
+    inline const CookedHeader& header() const { return *reinterpret_cast<const CookedHeader*>(data); }
+    inline const char* name(const uint32_t index) const
+        { return data + array<uint32_t>(header().names)[index]; }
+    template<typename T> inline const T* array(const CookedArray& arr) const
+        { return reinterpret_cast<const T*>(data + arr.offset); }
+    
+private:
+    bool validate() const;
+};
+
+} // namespace chimp
+
+#endif // CHIMPCOOKEDLEVEL_H
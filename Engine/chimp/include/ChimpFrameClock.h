@@ -0,0 +1,52 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPFRAMECLOCK_H
+#define CHIMPFRAMECLOCK_H
+
+#include <SDL2/SDL.h>
+
+namespace chimp
+{
+
+/*
+ * Measures frame times with SDL's performance counter, so they have sub-millisecond resolution instead of jumping
+ * between whole milliseconds. Optionally limits the frame rate: limit() sleeps until shortly before the frame is due,
+ * since sleeping can overshoot by a millisecond or more, then spins the rest of the way.
+ */
+class ChimpFrameClock
+{
+private:
+    const double countsPerMs;
+    Uint64 last;     // counter at the last tick()
+    Uint64 interval; // counts per frame, or 0 if unlimited
+    
+public:
+    explicit ChimpFrameClock(const double rate = 0);
+    
+    void setRate(const double rate);
+    inline bool isLimited() const { return interval != 0; }
+    inline void restart() { last = SDL_GetPerformanceCounter(); }
+    double tick();
+    void limit() const;
+};
+
+} // namespace chimp
+
+#endif // CHIMPFRAMECLOCK_H
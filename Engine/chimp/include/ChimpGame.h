@@ -25,6 +25,14 @@
 #include "ChimpObject.h"
 #include "ChimpMobile.h"
 #include "ChimpCharacter.h"
+#include "ChimpAnimation.h"
+#include "ChimpAssetCache.h"
+#include "ChimpAssetLoader.h"
+#include "ChimpAudio.h"
+#include "ChimpCookedLevel.h"
+#include "ChimpJobSystem.h"
+#include "ChimpNameTable.h"
+#include "ChimpTimerWheel.h"
 #include "cleanup.h"
 
 #if defined (__gnu_linux__) || defined (_WIN32)
@@ -34,28 +42,83 @@
 #include <SDL2_mixer/SDL_mixer.h>
 #endif
 
+#include <atomic>
 #include <vector>
 #include <map>
+#include <memory>
+#include <thread>
 #include <tinyxml2.h>
 #include <lua.hpp>
 
 namespace chimp
 {
 
-typedef std::map<std::string, SDL_Texture*> TextureMap;
-typedef std::map<std::string, ChimpTile> TileMap;
-typedef std::map<std::string, Mix_Chunk*> SoundMap;
-typedef std::map<std::string, Mix_Music*> MusicMap;
 enum Layer { BACK, MID, FORE };
 
 class ChimpGame
 {
 private:
+    struct PreparedLevel // a level read and with its assets decoded, but not yet built
+    {
+        std::string file;
+        ChimpCookedLevel level;
+        ChimpAssetLoader loader;
+        tinyxml2::XMLError result;
+        
+        PreparedLevel(ChimpJobSystem& jobs, ChimpAssetCache& cache) : loader(jobs, cache) {}
+    };
+    
+    struct ObjectClips
+    {
+        ClipId idle, run, jump;
+        bool animated = false; // false if a Character just shows its first tile
+    };
+    
+    struct ObjectState // what's kept of a streamed out object until its section loads again
+    {
+        float x, y, velocityX, velocityY;
+        int health;
+        bool active;
+    };
+    
+    enum SectionState { SECTION_UNLOADED, SECTION_LOADING, SECTION_BUILT, SECTION_LOADED };
+    
+    struct LevelSection
+    {
+        const CookedSection* cooked;
+        std::atomic<int> state;
+        std::vector<std::pair<Layer, ObjectPointer>> built; // filled by a worker while loading
+        std::vector<ChimpObject*> live;   // while loaded
+        std::vector<ObjectState> saved;   // while unloaded, if it was loaded before
+        
+        explicit LevelSection(const CookedSection& section) : cooked(&section), state(SECTION_UNLOADED) {}
+    };
+    
     SDL_Renderer* renderer;
-    TextureMap textures;
-    TileMap tiles;
-    SoundMap sounds;
-    MusicMap musics;
+    std::vector<SDL_Texture*> textures; // all indexed by AssetId
+    std::vector<ChimpTile> tiles;       // only resized between levels, since objects and clips point into it
+    ChimpAnimationRegistry animations;
+    std::vector<Mix_Chunk*> sounds;
+    std::vector<Mix_Music*> musics;
+    ChimpNameTable textureNames, tileNames, soundNames, musicNames;
+    ChimpJobSystem& jobs; // owned by the engine; decodes assets while loading
+    ChimpTaskGroup sectionTasks; // sections being built while streaming
+    ChimpAssetCache assetCache;
+    ChimpAudioService audio; // stopped before assetCache frees the sounds and music it plays
+    std::vector<ChimpAssetKey> levelAssets; // cache references held by the current level
+    std::vector<ChimpAssetTiming> assetTimings;
+    std::string pendingLevel;  // switched to by switchLevel()
+    std::string preloadFile;   // level being prepared by preloader
+    std::unique_ptr<PreparedLevel> preloaded;
+    std::thread preloader;
+    std::unique_ptr<PreparedLevel> openedLevel;  // between openLevel() and buildOpenedLevel()
+    std::unique_ptr<PreparedLevel> currentLevel; // kept for building sections
+    std::vector<ObjectClips> objectClips;       // by cooked object index
+    ChimpTimerWheel timers; // game time; outlives the objects, which cancel theirs when destroyed
+    double timerTime;       // game time the timers are behind by, under a millisecond
+    std::vector<std::unique_ptr<LevelSection>> sections;
+    int streamDistance;
+    bool synchronousStreaming;
     
     static ChimpCharacter* player;
     ObjectVector background, middle, foreground;
@@ -71,7 +134,7 @@ private:
     static ChimpObject* currentObj;
     
 public:
-    ChimpGame(SDL_Renderer* const rend, const int width, const int height,
+    ChimpGame(SDL_Renderer* const rend, const int width, const int height, ChimpJobSystem& jobSystem,
               ChimpCharacter* plyr = nullptr);
     ~ChimpGame();
     
@@ -102,7 +165,19 @@ public:
     inline const IntBox& getBackView() const { return backView; }
     inline const IntBox& getForeView() const { return foreView; }
     inline lua_State* getLuaState() const { return luast; }
-    bool setMusic(const std::string& mus);
+    inline const ChimpAnimationRegistry& getAnimations() const { return animations; }
+    inline AssetId getTextureId(const std::string& name) const { return textureNames.find(name); }
+    inline AssetId getTileId(const std::string& name) const { return tileNames.find(name); }
+    inline AssetId getSoundId(const std::string& name) const { return soundNames.find(name); }
+    inline AssetId getMusicId(const std::string& name) const { return musicNames.find(name); }
+    inline const ChimpTile* getTile(const AssetId id) const { return id < tiles.size() ? &tiles[id] : nullptr; }
+    inline Mix_Chunk* getSound(const AssetId id) const { return id < sounds.size() ? sounds[id] : nullptr; }
+    inline ChimpAudioService& getAudio() { return audio; }
+    inline ChimpTimerWheel& getTimers() { return timers; }
+    bool setMusic(const AssetId id);
+    void playMusic();
+    inline const std::vector<ChimpAssetTiming>& getAssetTimings() const { return assetTimings; }
+    inline void setSynchronousStreaming(const bool sync) { synchronousStreaming = sync; }
     
     inline static ChimpCharacter*& getPlayer() { return player; }
     inline static ChimpGame* getGame() { return self; }
@@ -116,7 +191,7 @@ public:
     void pushChar(const Layer lay, const ChimpTile& til, const int x = 0, const int y = 0, const int tilesX = 1,
                   const int tilesY = 1, const int maxH = HEALTH, const Faction frnds = FACTION_VOID,
                   const Faction enms = FACTION_VOID);
-    void pushChar(const Layer lay, const TileVec& tilRn, const TileVec& tilJmp, TileVec& tilIdl, const int x = 0,
+    void pushChar(const Layer lay, const ClipId clpRn, const ClipId clpJmp, const ClipId clpIdl, const int x = 0,
                   const int y = 0, const int tilesX = 1, const int tilesY = 1, const int maxH = 100,
                   const Faction frnds = FACTION_VOID, const Faction enms = FACTION_VOID);
     
@@ -124,21 +199,37 @@ public:
     void translateWindowY(const int y);
     
     void initialize();
-    void update(Uint32 time);
+    void update(double time);
     void render();
+    void record(ChimpRenderPacket& packet);
     void reset();
     
     tinyxml2::XMLError loadLevel(const std::string& levelFile);
+    tinyxml2::XMLError openLevel(const std::string& levelFile);
+    void decodeOpenedLevel();
+    tinyxml2::XMLError buildOpenedLevel();
+    void preloadLevel(const std::string& levelFile);
+    inline void changeLevel(const std::string& levelFile) { pendingLevel = levelFile; }
+    inline bool isLevelChangePending() const { return !pendingLevel.empty(); }
+    tinyxml2::XMLError switchLevel();
     
 private:
-    bool loadTextures(tinyxml2::XMLDocument& levelXML, TextureMap& textures, SDL_Renderer* const renderer);
-    bool loadTiles(tinyxml2::XMLDocument& levelXML, TextureMap& textures, TileMap& tiles);
-    bool loadSounds(tinyxml2::XMLDocument& levelXML, SoundMap& sounds, MusicMap& musics);
-    void loadWorldBox(const tinyxml2::XMLElement* const edges);
-    bool loadAllAnimations(tinyxml2::XMLElement* const objXML, TileVec& idletiles, TileVec& runtiles,
-                           TileVec& jumptiles, TileMap& tiles);
-    static void loadAnimation(tinyxml2::XMLElement* const objXML, std::string anim, TileVec& tilvec, TileMap& tiles);
-    void loadObject(tinyxml2::XMLElement* const objXML, ChimpObject& obj);
+    std::unique_ptr<PreparedLevel> prepareLevel(const std::string& levelFile, const bool decode = true);
+    static tinyxml2::XMLError readLevel(const std::string& levelFile, ChimpCookedLevel& level);
+    void unloadLevel();
+    bool buildLevel(const ChimpCookedLevel& level, ChimpAssetLoader& loader);
+    ObjectPointer buildObject(const ChimpCookedLevel& level, const uint32_t index) const;
+    ObjectVector& getLayer(const Layer lay);
+    void streamSections(const bool block, const bool started);
+    void buildSection(LevelSection& section) const;
+    void spliceSection(LevelSection& section, const bool started);
+    void unloadSection(LevelSection& section, const bool save);
+    bool buildClips(const CookedFrame* const frames, const size_t count, ClipId& idleclip, ClipId& runclip,
+                    ClipId& jumpclip);
+    void addClips(AnimationClip& idle, AnimationClip& run, AnimationClip& jump, ClipId& idleclip, ClipId& runclip,
+                  ClipId& jumpclip);
+    void applyProperties(const ChimpCookedLevel& level, const CookedOp* const ops, const size_t count,
+                         ChimpObject& obj) const;
 };
 
 } // namespace chimp
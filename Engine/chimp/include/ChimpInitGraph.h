@@ -0,0 +1,87 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPINITGRAPH_H
+#define CHIMPINITGRAPH_H
+
+#include "ChimpJobSystem.h"
+
+#include <SDL2/SDL.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace chimp
+{
+
+/*
+ * Startup as a dependency graph. Each task runs once all the tasks it depends on have finished: on a job system, or
+ * on the thread calling run() if it has to own SDL's video state or the renderer. Independent tasks overlap, so
+ * startup takes about as long as the longest chain of dependent tasks, which report() prints as the critical path.
+ * Once a task fails, tasks that haven't started yet are skipped.
+ */
+class ChimpInitGraph
+{
+public:
+    typedef size_t TaskId;
+    
+private:
+    struct Task
+    {
+        std::string name;
+        std::function<bool()> run;
+        std::vector<TaskId> dependencies, dependents;
+        bool mainThread;
+        size_t waitingOn = 0;
+        Uint64 start = 0, end = 0;
+        bool ran = false, succeeded = false;
+    };
+    
+    std::vector<Task> tasks;
+    std::deque<TaskId> mainQueue;
+    size_t finished;
+    bool failed;
+    std::mutex mutex;
+    std::condition_variable wake;
+    Uint64 begin;
+    
+public:
+    ChimpInitGraph() : finished(0), failed(false), begin(0) {}
+    ChimpInitGraph(const ChimpInitGraph&) = delete;
+    ChimpInitGraph& operator=(const ChimpInitGraph&) = delete;
+    
+    TaskId add(const std::string& name, std::function<bool()> run, const std::vector<TaskId>& dependencies = {},
+               const bool mainThread = false);
+    bool run(ChimpJobSystem& jobs);
+    void report(std::ostream& out) const;
+    
+private:
+    void schedule(const TaskId id, ChimpTaskGroup& group);
+    void execute(const TaskId id, ChimpTaskGroup& group);
+    double toMs(const Uint64 time) const;
+};
+
+} // namespace chimp
+
+#endif // CHIMPINITGRAPH_H
@@ -0,0 +1,169 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPJOBSYSTEM_H
+#define CHIMPJOBSYSTEM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace chimp
+{
+
+class ChimpJobSystem;
+
+struct ChimpWorkerStats
+{
+    uint64_t tasks;     // run by this worker
+    uint64_t steals;    // of those, taken from another worker
+    double busyMs;      // running tasks
+    double utilisation; // busyMs as a fraction of the time since the stats were reset
+};
+
+/*
+ * Tasks that can be waited on together. A group must outlive its tasks, so the destructor waits for them.
+ */
+class ChimpTaskGroup
+{
+    friend class ChimpJobSystem;
+    
+private:
+    ChimpJobSystem& jobs;
+    std::atomic<size_t> pending;
+    std::mutex mutex; // guards continuations
+    std::vector<std::function<void()>> continuations;
+    
+public:
+    explicit ChimpTaskGroup(ChimpJobSystem& jobSystem) : jobs(jobSystem), pending(0) {}
+    ~ChimpTaskGroup() { wait(); }
+    ChimpTaskGroup(const ChimpTaskGroup&) = delete;
+    ChimpTaskGroup& operator=(const ChimpTaskGroup&) = delete;
+    
+    void run(std::function<void()> task);
+    void then(std::function<void()> continuation);
+    void wait();
+    inline bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+    
+private:
+    void finish();
+};
+
+/*
+ * Work-stealing task scheduler. Each worker thread has a Chase-Lev deque: it pushes and pops the tasks it submits at
+ * one end without locking, while idle workers steal the oldest tasks from the other end. Tasks submitted from other
+ * threads go through a locked queue. Threads waiting on a ChimpTaskGroup run tasks meanwhile instead of blocking, so
+ * tasks may wait on tasks of their own, e.g. decoding a level's assets from a startup task.
+ * 
+ * Tasks must not touch the renderer or any other state owned by the main thread.
+ */
+class ChimpJobSystem
+{
+    friend class ChimpTaskGroup;
+    
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    
+    struct Job
+    {
+        std::function<void()> run;
+        ChimpTaskGroup* group;
+    };
+    
+    class Deque // Chase-Lev; only the owning worker pushes and pops, anyone steals
+    {
+    private:
+        struct Ring
+        {
+            const int64_t mask;
+            std::unique_ptr<std::atomic<Job*>[]> jobs;
+            
+            explicit Ring(const int64_t size) : mask(size - 1), jobs(new std::atomic<Job*>[size]) {}
+            inline Job* get(const int64_t i) const { return jobs[i & mask].load(std::memory_order_relaxed); }
+            inline void put(const int64_t i, Job* const job) { jobs[i & mask].store(job, std::memory_order_relaxed); }
+        };
+        
+        std::atomic<int64_t> top;
+        char padding[CACHE_LINE]; // keeps thieves' writes to top from evicting the owner's bottom
+        std::atomic<int64_t> bottom;
+        std::atomic<Ring*> ring;
+        std::vector<std::unique_ptr<Ring>> rings; // grown out of, kept until destruction since thieves may read them
+        
+    public:
+        Deque();
+        void push(Job* const job);
+        Job* pop();
+        Job* steal();
+    };
+    
+    struct Worker
+    {
+        Deque deque;
+        std::atomic<uint64_t> tasks, steals, busyTicks;
+        uint32_t seed; // for picking whom to steal from
+        char padding[CACHE_LINE]; // keeps the counters off the cache line of whatever is allocated next
+        
+        Worker() : tasks(0), steals(0), busyTicks(0), seed(0) {}
+    };
+    
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::deque<Job*> injected; // submitted from outside the workers
+    std::mutex injectMutex;
+    std::atomic<size_t> injectedCount;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<unsigned> sleeping;
+    unsigned wakeups; // guarded by sleepMutex
+    bool stopping;    // guarded by sleepMutex
+    std::chrono::steady_clock::time_point statsStart;
+    
+public:
+    explicit ChimpJobSystem(unsigned count = 0, const bool pin = true);
+    ~ChimpJobSystem();
+    ChimpJobSystem(const ChimpJobSystem&) = delete;
+    ChimpJobSystem& operator=(const ChimpJobSystem&) = delete;
+    
+    void parallelFor(const size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+    inline size_t size() const { return threads.size(); }
+    std::vector<ChimpWorkerStats> getStats() const;
+    void resetStats();
+    void report(std::ostream& out) const;
+    
+private:
+    void submit(Job* const job);
+    Job* find(Worker* const self);
+    bool runOne(Worker* const self);
+    void execute(Job* const job);
+    void work(Worker* const self, const unsigned index, const bool pin);
+    static Worker* currentWorker(const ChimpJobSystem* const jobs);
+};
+
+} // namespace chimp
+
+#endif // CHIMPJOBSYSTEM_H
@@ -0,0 +1,56 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPMAPPEDFILE_H
+#define CHIMPMAPPEDFILE_H
+
+#include <string>
+#include <vector>
+
+namespace chimp
+{
+
+/*
+ * A whole file mapped read only into memory. Pages are only read from disk when touched. On Windows the file is read
+ * into a buffer instead.
+ */
+class ChimpMappedFile
+{
+private:
+    const char* fileData;
+    size_t fileSize;
+    void* mapping;
+    std::vector<char> buffer;
+    
+public:
+    ChimpMappedFile() : fileData(nullptr), fileSize(0), mapping(nullptr) {}
+    ~ChimpMappedFile();
+    ChimpMappedFile(const ChimpMappedFile&) = delete;
+    ChimpMappedFile& operator=(const ChimpMappedFile&) = delete;
+    
+    bool open(const std::string& file);
+    void close();
+    inline const char* data() const { return fileData; }
+    inline size_t size() const { return fileSize; }
+    inline bool isOpen() const { return fileData; }
+};
+
+} // namespace chimp
+
+#endif // CHIMPMAPPEDFILE_H
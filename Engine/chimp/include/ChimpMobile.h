@@ -61,7 +61,7 @@ public:
     void sprint();
     void stopSprinting();
     virtual void reset();
-    virtual void update(const ObjectVector& objects, ChimpGame& game, const Uint32 time);
+    virtual void update(const ObjectVector& objects, ChimpGame& game, const double time);
     void accelerate();
 
     float getAccelerationY() const { return accelerationY; }
@@ -111,6 +111,8 @@ public:
     float getTerminalVelocityRun() { return run_accel * MS_PER_ACCEL / resistance_x; }
     float getTerminalVelocityFall() { return GRAVITY * MS_PER_ACCEL / resistance_y; }
     bool hasPlatform() const { return platform; }
+    const ChimpObject* getPlatform() const { return platform; }
+    void leavePlatform() { platform = nullptr; } // e.g. when the platform is streamed out
     
 protected:
     void runScript(std::string& script, lua_State* const luast);
@@ -0,0 +1,54 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPNAMETABLE_H
+#define CHIMPNAMETABLE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chimp
+{
+
+typedef uint32_t AssetId;
+static constexpr AssetId ASSET_NONE = 0xFFFFFFFF;
+
+/*
+ * Interns names into dense IDs, starting at 0 in the order they're first seen, so an ID can index a flat vector of
+ * whatever the names refer to. Names are only looked up when resolving them to IDs, never at runtime.
+ */
+class ChimpNameTable
+{
+private:
+    std::unordered_map<std::string, AssetId> ids;
+    std::vector<std::string> names;
+    
+public:
+    AssetId intern(const std::string& name);
+    AssetId find(const std::string& name) const;
+    inline const std::string& name(const AssetId id) const { return names[id]; }
+    inline size_t size() const { return names.size(); }
+    void clear();
+};
+
+} // namespace chimp
+
+#endif // CHIMPNAMETABLE_H
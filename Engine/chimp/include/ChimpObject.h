@@ -24,7 +24,8 @@
 #include "ChimpConstants.h"
 #include "ChimpTile.h"
 #include "ChimpStructs.h"
-#include "ChimpStructs.h"
+#include "ChimpRenderPacket.h"
+#include "ChimpTimerWheel.h"
 
 #if defined (__gnu_linux__) || defined (_WIN32)
 #include <SDL2/SDL_mixer.h>
@@ -50,7 +51,7 @@ enum Faction { FACTION_VOID = 0, FACTION_PLAYER = 1<<0, FACTION_BADDIES = 1<<1 }
 class ChimpObject
 {    
 protected:
-    ChimpTile tile;
+    const ChimpTile* tile; // owned by the ChimpGame
     SDL_Renderer* const renderer;
     Coordinate coord, center;
     float approx_zero_float, approx_zero_y;
@@ -59,11 +60,12 @@ protected:
     bool active;
     int width, height;
     BoolBox damageBox;
+    std::vector<TimerId> timers; // cancelled when this Object is destroyed
     
 public:
     ChimpObject(SDL_Renderer* const rend, const ChimpTile& til, const int pX = 0, const int pY = 0,
                 const int tilesX = 1, const int tilesY = 1, Faction frnds = FACTION_VOID, Faction enms = FACTION_VOID);
-    virtual ~ChimpObject() {}
+    virtual ~ChimpObject();
     
     virtual void initialize(const ChimpGame& game);
     
@@ -77,18 +79,18 @@ public:
     virtual void setInitialY(const float y) { setY(y); }
     inline float getCenterX() const { return coord.x + center.x; }
     inline float getCenterY() const { return coord.y + center.y; }
-    inline int getTilesX() const { return width / tile.drawRect.w; }
-    inline void setTilesX(const int tilesX) { width = tile.drawRect.w*tilesX; }
-    inline int getTilesY() const { return height / tile.drawRect.h; }
-    inline void setTilesY(const int tilesY) { height = tile.drawRect.h*tilesY; }
+    inline int getTilesX() const { return width / tile->drawRect.w; }
+    inline void setTilesX(const int tilesX) { width = tile->drawRect.w*tilesX; }
+    inline int getTilesY() const { return height / tile->drawRect.h; }
+    inline void setTilesY(const int tilesY) { height = tile->drawRect.h*tilesY; }
     inline int getWidth() const { return width; }
     inline int getHeight() const { return height; }
-    inline int getTexRectW() const { return tile.textureRect.w; }
-    inline int getTexRectH() const { return tile.textureRect.h; }
-    inline float getCollisionLeft() const { return coord.x + tile.collisionBox.l; }
-    inline float getCollisionRight() const { return coord.x + width - tile.collisionBox.r; }
-    inline float getCollisionTop() const { return coord.y + tile.collisionBox.t; }
-    inline float getCollisionBottom() const {return coord.y + height - tile.collisionBox.b; }
+    inline int getTexRectW() const { return tile->textureRect.w; }
+    inline int getTexRectH() const { return tile->textureRect.h; }
+    inline float getCollisionLeft() const { return coord.x + tile->collisionBox.l; }
+    inline float getCollisionRight() const { return coord.x + width - tile->collisionBox.r; }
+    inline float getCollisionTop() const { return coord.y + tile->collisionBox.t; }
+    inline float getCollisionBottom() const {return coord.y + height - tile->collisionBox.b; }
     inline bool getDamageLeft() const { return damageBox.l; }
     inline void setDamageLeft(const bool bl) { damageBox.l = bl; }
     inline bool getDamageRight() const { return damageBox.r; }
@@ -97,8 +99,8 @@ public:
     inline void setDamageTop(const bool bl) { damageBox.t = bl; }
     inline bool getDamageBottom() const { return damageBox.b; }
     inline void setDamageBottom(const bool bl) { damageBox.b = bl; }
-    inline ChimpTile& getChimpTile() { return tile; }
-    inline void setChimpTile(const ChimpTile& til) { tile = til; }
+    inline const ChimpTile& getChimpTile() const { return *tile; }
+    inline void setChimpTile(const ChimpTile& til) { tile = &til; } // til must outlive this Object
     inline int getFriends() const { return friends; }
     inline bool setFriends(const int facs);
     inline void addFriend(const Faction fac) { friends |= fac; }
@@ -115,10 +117,12 @@ public:
     
     bool touches(const ChimpObject& other) const;
     bool touchesAtBottom(const ChimpObject& other) const;
+    TimerId addTimer(ChimpGame& game, const Uint32 delay, ChimpTimerWheel::Callback callback);
     
-    virtual void update(const ObjectVector& objects, ChimpGame& game, const Uint32 time);
+    virtual void update(const ObjectVector& objects, ChimpGame& game, const double time);
     virtual void accelerate() {}
     virtual void render(const IntBox& screen);
+    virtual void record(const IntBox& screen, ChimpRenderPacket& packet);
     virtual void reset() {}
     
     inline float getApproxZeroFloat() const { return approx_zero_float; }
@@ -185,6 +189,8 @@ public:
     virtual float getTerminalVelocityFall() { return 0.0f; }
     virtual void setSoundJump(Mix_Chunk* const sound) {}
     virtual void setSoundMultijump(Mix_Chunk* const sound) {}
+    virtual const ChimpObject* getPlatform() const { return nullptr; }
+    virtual void leavePlatform() {}
     #pragma GCC diagnostic pop
     
 protected:
@@ -0,0 +1,109 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPPROFILER_H
+#define CHIMPPROFILER_H
+
+#include <SDL2/SDL.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace chimp
+{
+
+/*
+ * Frame profiler (--profile). Zones are timed with ChimpProfileZone and kept in a ring buffer per thread holding the
+ * last PROFILE_ZONES of them, so it always has the most recent frames. How far back that goes depends on the zones per
+ * frame and the frame rate: a few seconds at 60 fps, but less than a second of the pipelined simulation thread at
+ * SIMULATION_RATE, since scripts and collisions add zones per object; --fps lowers that rate. Recording takes no lock:
+ * each thread only writes its own buffer. write() snapshots every buffer into a Chrome trace event JSON file, to be
+ * opened in Perfetto or chrome://tracing; requestWrite() asks for that from anywhere, including a signal handler, and
+ * the main loop does it at the start of the next frame. Until enable() is called, zones cost one relaxed load.
+ */
+class ChimpProfiler
+{
+private:
+    struct Zone
+    {
+        std::atomic<const char*> name; // string literal
+        std::atomic<Uint64> start, end;
+    };
+    
+    struct ThreadBuffer
+    {
+        std::unique_ptr<Zone[]> zones;
+        std::atomic<size_t> written; // zones recorded in total; the newest is at (written - 1) % size
+        std::string name;
+    };
+    
+    const size_t size;
+    std::atomic<bool> enabled;
+    std::atomic<bool> writeRequested;
+    Uint64 origin;
+    int written;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads; // numbered in the order they first record something
+    std::mutex mutex;
+    
+    ChimpProfiler();
+    
+public:
+    static ChimpProfiler& getProfiler();
+    ChimpProfiler(const ChimpProfiler&) = delete;
+    ChimpProfiler& operator=(const ChimpProfiler&) = delete;
+    
+    void enable();
+    inline bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    inline static Uint64 now() { return SDL_GetPerformanceCounter(); }
+    void setThreadName(const std::string& name);
+    void record(const char* const name, const Uint64 start, const Uint64 end);
+    
+    inline void requestWrite() { writeRequested.store(true, std::memory_order_relaxed); }
+    bool writeIfRequested();
+    bool write(const std::string& file);
+    
+private:
+    ThreadBuffer& getBuffer();
+};
+
+/*
+ * Records a zone from construction to destruction, if the profiler is enabled.
+ */
+class ChimpProfileZone
+{
+private:
+    const char* const name;
+    const Uint64 start;
+    
+public:
+    explicit ChimpProfileZone(const char* const nm) // nm must be a string literal
+        : name(nm), start(ChimpProfiler::getProfiler().isEnabled() ? ChimpProfiler::now() : 0) {}
+    ~ChimpProfileZone()
+        { if(start) ChimpProfiler::getProfiler().record(name, start, ChimpProfiler::now()); }
+    ChimpProfileZone(const ChimpProfileZone&) = delete;
+    ChimpProfileZone& operator=(const ChimpProfileZone&) = delete;
+};
+
+} // namespace chimp
+
+#endif // CHIMPPROFILER_H
@@ -0,0 +1,82 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPRENDERPACKET_H
+#define CHIMPRENDERPACKET_H
+
+#include <SDL2/SDL.h>
+
+#include <atomic>
+#include <vector>
+
+namespace chimp
+{
+
+struct ChimpDrawCommand
+{
+    SDL_Texture* texture;
+    SDL_Rect textureRect, drawRect;
+    SDL_RendererFlip flip;
+    SDL_Color tint;
+};
+
+/*
+ * Everything the render thread needs to draw one frame. Filled by the simulation thread, then treated as immutable
+ * once published.
+ */
+struct ChimpRenderPacket
+{
+    std::vector<ChimpDrawCommand> draws;
+    size_t backgroundEnd = 0, middleEnd = 0; // draws before these are the background's, then the middle layer's
+    int health = 0;
+    bool gameOver = false;
+
+    void clear() { draws.clear(); } // keeps capacity, so steady state packets don't allocate
+    void submit(SDL_Renderer* const renderer) const;
+
+private:
+    void submit(SDL_Renderer* const renderer, const size_t begin, const size_t end) const;
+};
+
+/*
+ * Triple buffered hand-off of render packets from the simulation thread to the render thread. The producer always owns
+ * one packet, the consumer always owns another and the third is the most recently published one. Swapping is a single
+ * atomic exchange on either side, so neither thread ever waits on the other.
+ */
+class ChimpRenderPipeline
+{
+private:
+    static constexpr int INDEX_MASK = 0x3, FRESH = 0x4;
+
+    ChimpRenderPacket packets[3];
+    std::atomic<int> ready;
+    int writing, reading;
+
+public:
+    ChimpRenderPipeline() : ready(1), writing(0), reading(2) {}
+
+    ChimpRenderPacket& beginWrite();
+    void publish();
+    bool acquire();
+    inline const ChimpRenderPacket& current() const { return packets[reading]; }
+};
+
+} // namespace chimp
+
+#endif // CHIMPRENDERPACKET_H
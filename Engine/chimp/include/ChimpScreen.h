@@ -0,0 +1,60 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPSCREEN_H
+#define CHIMPSCREEN_H
+
+#include <SDL2/SDL.h>
+
+namespace chimp
+{
+
+/*
+ * Owns the start and end of every frame. By default frames are drawn straight to the window. With an internal
+ * resolution set, the whole frame is drawn into one offscreen texture of that size instead, and present() scales it to
+ * the window in a single copy, letterboxed and optionally limited to whole-number scale factors.
+ */
+class ChimpScreen
+{
+private:
+    SDL_Renderer* const renderer;
+    SDL_Texture* target; // nullptr when drawing straight to the window
+    const int viewWidth, viewHeight;
+    int internalWidth, internalHeight;
+    bool integerScale;
+    SDL_Rect outputRect; // where target ends up in the window
+    
+public:
+    ChimpScreen(SDL_Renderer* const rend, const int viewW, const int viewH);
+    ~ChimpScreen();
+    ChimpScreen(const ChimpScreen&) = delete;
+    ChimpScreen& operator=(const ChimpScreen&) = delete;
+    
+    bool setInternalResolution(const int width, const int height, const bool integer);
+    inline SDL_Renderer* getRenderer() const { return renderer; }
+    inline bool hasInternalResolution() const { return target; }
+    void resize(const int windowWidth, const int windowHeight);
+    void begin();
+    void present();
+    void clear();
+};
+
+} // namespace chimp
+
+#endif // CHIMPSCREEN_H
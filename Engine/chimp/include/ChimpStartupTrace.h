@@ -0,0 +1,103 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPSTARTUPTRACE_H
+#define CHIMPSTARTUPTRACE_H
+
+#include <SDL2/SDL.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chimp
+{
+
+/*
+ * Timestamps the phases of startup (--startup-report): subsystem init, reading the level, decoding and uploading each
+ * asset, building each object and running each init script. Spans can be recorded from any thread. The timeline is
+ * written in Chrome's trace event format, so it can be opened in chrome://tracing or Perfetto as well as parsed.
+ * Recording does nothing until enable() is called, so the hooks cost one relaxed load when startup isn't traced.
+ */
+class ChimpStartupTrace
+{
+private:
+    struct Span
+    {
+        std::string name;
+        const char* category; // string literal
+        Uint64 start, end;
+        int thread;
+    };
+    
+    std::atomic<bool> enabled;
+    Uint64 origin;
+    std::vector<Span> spans;
+    std::map<std::thread::id, int> threads; // numbered in the order they first record something
+    mutable std::mutex mutex;
+    
+    ChimpStartupTrace() : enabled(false), origin(0) {}
+    
+public:
+    static ChimpStartupTrace& getTrace();
+    ChimpStartupTrace(const ChimpStartupTrace&) = delete;
+    ChimpStartupTrace& operator=(const ChimpStartupTrace&) = delete;
+    
+    void enable();
+    inline bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    inline static Uint64 now() { return SDL_GetPerformanceCounter(); }
+    void record(const std::string& name, const char* const category, const Uint64 start, const Uint64 end);
+    
+    void report(std::ostream& out) const;
+    bool write(const std::string& file) const;
+    
+private:
+    double toMs(const Uint64 time) const;
+};
+
+/*
+ * Records a span from construction to destruction, if the startup trace is enabled.
+ */
+class ChimpTraceScope
+{
+private:
+    const char* const category;
+    std::string name;
+    const Uint64 start;
+    
+public:
+    ChimpTraceScope(const char* const cat, const std::string& nm)
+        : category(cat), start(ChimpStartupTrace::getTrace().isEnabled() ? ChimpStartupTrace::now() : 0)
+        { if(start) name = nm; }
+    ChimpTraceScope(const char* const cat, const char* const nm, const size_t index) // named "nm index"
+        : category(cat), start(ChimpStartupTrace::getTrace().isEnabled() ? ChimpStartupTrace::now() : 0)
+        { if(start) name = std::string(nm) + " " + std::to_string(index); }
+    ~ChimpTraceScope()
+        { if(start) ChimpStartupTrace::getTrace().record(name, category, start, ChimpStartupTrace::now()); }
+    ChimpTraceScope(const ChimpTraceScope&) = delete;
+    ChimpTraceScope& operator=(const ChimpTraceScope&) = delete;
+};
+
+} // namespace chimp
+
+#endif // CHIMPSTARTUPTRACE_H
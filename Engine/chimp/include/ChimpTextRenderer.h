@@ -0,0 +1,91 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPTEXTRENDERER_H
+#define CHIMPTEXTRENDERER_H
+
+#include <SDL2/SDL.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace chimp
+{
+
+/*
+ * Draws text from glyph atlases. Each font size used is rasterized once into a single texture holding every printable
+ * ASCII glyph; after that, drawing text only appends quads to a batch, and flush() draws each size's batch with one
+ * render call. Changing text therefore never creates textures. With SDL older than 2.0.18 (no SDL_RenderGeometry),
+ * glyphs are copied from the atlas one at a time instead. Rasterizing doesn't need the renderer, so rasterize() can
+ * run on another thread, e.g. during startup; only uploading the atlas waits for the renderer.
+ */
+class ChimpTextRenderer
+{
+private:
+    static constexpr char FIRST_GLYPH = ' ', LAST_GLYPH = '~';
+    static constexpr int ATLAS_WIDTH = 512;
+
+    struct Glyph
+    {
+        SDL_Rect rect; // position in the atlas texture
+        int advance;
+    };
+
+    struct GlyphAtlas
+    {
+        SDL_Texture* texture = nullptr;
+        SDL_Surface* sheet = nullptr; // rasterized but not uploaded yet
+        Glyph glyphs[LAST_GLYPH - FIRST_GLYPH + 1];
+        int height = 0, textureHeight = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        std::vector<SDL_Vertex> vertices; // current batch, reused between frames
+        std::vector<int> indices;
+#endif
+    };
+
+    SDL_Renderer* renderer;
+    const std::string fontFile;
+    std::map<int, GlyphAtlas> atlases;
+
+public:
+    ChimpTextRenderer(SDL_Renderer* const rend, const std::string& file);
+    ~ChimpTextRenderer();
+    ChimpTextRenderer(const ChimpTextRenderer&) = delete;
+    ChimpTextRenderer& operator=(const ChimpTextRenderer&) = delete;
+
+    inline void setRenderer(SDL_Renderer* const rend) { renderer = rend; } // only before anything is uploaded
+    bool rasterize(const int size);
+    bool loadSize(const int size);
+    void clear();
+    int measure(const char* const text, const int size);
+    int getLineHeight(const int size);
+    void draw(const char* const text, const int x, const int y, const int size, const SDL_Color color);
+    inline void draw(const std::string& text, const int x, const int y, const int size, const SDL_Color color)
+        { draw(text.c_str(), x, y, size, color); }
+    void flush();
+
+private:
+    GlyphAtlas* getAtlas(const int size);
+    bool upload(GlyphAtlas& atlas);
+};
+
+} // namespace chimp
+
+#endif // CHIMPTEXTRENDERER_H
@@ -0,0 +1,95 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPTIMERWHEEL_H
+#define CHIMPTIMERWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace chimp
+{
+
+typedef uint64_t TimerId; // 0 is none
+
+/*
+ * Timers counted in game milliseconds, advanced by the simulation, so they stop while the game does. They're kept in
+ * a hierarchical wheel: the first level has a slot for each of the next 256 ms, and each slot of the three levels
+ * above spans a whole turn of the level below, covering about 18 hours in all. Timers move down a level as the level
+ * below comes round to them. Scheduling and cancelling take constant time; advancing takes a slot per millisecond,
+ * plus moving timers down when a level wraps. Timers are pooled, so once the pool has grown, scheduling only
+ * allocates for what a callback captures.
+ * 
+ * Not thread safe; the simulation owns it.
+ */
+class ChimpTimerWheel
+{
+public:
+    typedef std::function<void(const TimerId)> Callback; // passed its own id
+    
+private:
+    static constexpr int ROOT_BITS = 8, LEVEL_BITS = 6, LEVELS = 4;
+    static constexpr uint32_t ROOT_SLOTS = 1 << ROOT_BITS, LEVEL_SLOTS = 1 << LEVEL_BITS;
+    static constexpr uint32_t SLOTS = ROOT_SLOTS + (LEVELS - 1) * LEVEL_SLOTS;
+    static constexpr uint32_t FIRING = SLOTS; // list of timers being run
+    static constexpr uint32_t NONE = UINT32_MAX;
+    
+    struct Timer
+    {
+        uint64_t expires;
+        Callback callback;
+        uint32_t generation = 1;
+        uint32_t slot = NONE; // NONE while free
+        uint32_t prev, next;  // in the slot's list, or in the free list
+    };
+    
+    std::vector<Timer> timers;
+    uint32_t heads[SLOTS + 1];
+    uint32_t freeTimers;
+    uint64_t current; // next millisecond to run
+    size_t pending;
+    
+public:
+    ChimpTimerWheel();
+    ChimpTimerWheel(const ChimpTimerWheel&) = delete;
+    ChimpTimerWheel& operator=(const ChimpTimerWheel&) = delete;
+    
+    TimerId schedule(const uint32_t delay, Callback callback);
+    bool cancel(const TimerId id);
+    bool isPending(const TimerId id) const;
+    void advance(const uint32_t time);
+    void clear();
+    inline size_t size() const { return pending; }
+    inline uint64_t now() const { return current; }
+    
+private:
+    void insert(const uint32_t index);
+    void link(const uint32_t index, const uint32_t slot);
+    void unlink(const uint32_t index);
+    void release(const uint32_t index);
+    void cascade(const int level, const uint32_t slot);
+    void run(const uint64_t time);
+    const Timer* find(const TimerId id) const;
+};
+
+} // namespace chimp
+
+#endif // CHIMPTIMERWHEEL_H
@@ -0,0 +1,81 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPVOICEMANAGER_H
+#define CHIMPVOICEMANAGER_H
+
+#include "ChimpStructs.h"
+
+#if defined (__gnu_linux__) || defined (_WIN32)
+#include <SDL2/SDL_mixer.h>
+#endif
+#if defined (__APPLE__) && defined (__MACH__)
+#include <SDL2_mixer/SDL_mixer.h>
+#endif
+
+#include <vector>
+
+namespace chimp
+{
+
+enum VoicePriority { VOICE_LOW, VOICE_NORMAL, VOICE_HIGH };
+typedef Uint32 VoiceId; // names a sound while it plays; 0 is none
+
+/*
+ * Plays sounds on a fixed set of mixer channels, the voices. A voice's loudness and stereo position are set on its
+ * channel with Mix_Volume() and Mix_SetPosition(), never on the Mix_Chunk, so one chunk can play at several distances
+ * at once. When every voice is busy, a new sound takes over the least important one playing (lowest priority, then
+ * quietest, then oldest) if it's more important itself, and is dropped otherwise. The mixer must have been given at
+ * least as many channels, with Mix_AllocateChannels().
+ */
+class ChimpVoiceManager
+{
+private:
+    struct Voice
+    {
+        VoicePriority priority = VOICE_LOW;
+        float gain = 0;
+        Uint32 started = 0; // play() count when it started
+        VoiceId id = 0;
+    };
+    
+    std::vector<Voice> voices; // by channel
+    Uint32 plays;
+    
+public:
+    explicit ChimpVoiceManager(const int count);
+    
+    int play(Mix_Chunk* const chunk, const VoicePriority priority = VOICE_NORMAL, const float gain = 1,
+             const float pan = 0, const VoiceId id = 0);
+    void stop(const VoiceId id);
+    void stopAll();
+    void setPosition(const VoiceId id, const float gain, const float pan);
+    inline int size() const { return static_cast<int>(voices.size()); }
+    
+    static bool locate(const Box<float>& source, const IntBox& view, const int zone, float& gain, float& pan);
+    
+private:
+    int findVoice(const VoicePriority priority, const float gain) const;
+    int findChannel(const VoiceId id) const;
+    static void place(const int channel, const float gain, const float pan);
+};
+
+} // namespace chimp
+
+#endif // CHIMPVOICEMANAGER_H
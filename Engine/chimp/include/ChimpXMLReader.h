@@ -0,0 +1,83 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHIMPXMLREADER_H
+#define CHIMPXMLREADER_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace chimp
+{
+
+/*
+ * Pull parser over an XML buffer. Each next() reads just enough to return one event, reusing the same few strings, so
+ * memory use depends only on how deeply elements nest, not on how big the document is. Follows tinyxml2's rules where
+ * the level loader could tell the difference: entities are decoded, line endings become '\n', whitespace only text is
+ * dropped and other text is kept as is. DTDs are skipped without being read.
+ */
+class ChimpXMLReader
+{
+public:
+    enum Event
+    {
+        XML_START,  // element opened; name() and attribute() are valid until the next event
+        XML_END,    // element closed, also sent right after XML_START for <empty/> elements
+        XML_TEXT,   // text or CDATA
+        XML_OTHER,  // comment, declaration or DTD
+        XML_DONE,
+        XML_ERROR
+    };
+    
+private:
+    const char* const begin;
+    const char* const end;
+    const char* p;
+    std::string elementName, textValue, errorMessage;
+    std::vector<std::pair<std::string, std::string>> attributes; // only grows, so its strings keep their capacity
+    size_t attributeCount;
+    std::vector<std::string> open; // elements not closed yet, innermost last; also only grows
+    size_t openCount;
+    bool closePending;
+    
+public:
+    ChimpXMLReader(const char* const data, const size_t size);
+    
+    Event next();
+    inline const std::string& name() const { return elementName; }
+    const char* attribute(const char* const attributeName) const;
+    inline const std::string& text() const { return textValue; }
+    inline size_t depth() const { return openCount; } // elements open, counting one just started
+    inline const std::string& error() const { return errorMessage; }
+    
+private:
+    Event fail(const char* const message);
+    bool startsWith(const char* const prefix) const;
+    bool skipPast(const char* const terminator);
+    bool readName(std::string& out);
+    static void readText(const char* from, const char* const to, std::string& out, const bool decode);
+    Event readStart();
+    Event readEnd();
+};
+
+} // namespace chimp
+
+#endif // CHIMPXMLREADER_H
@@ -0,0 +1,69 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpAnimation.h"
+
+#include <cstdint>
+
+namespace chimp
+{
+
+/**
+ * @brief ChimpAnimationRegistry::add()
+ * 
+ * Adds a clip to the registry. If an identical clip was already added, its id is returned instead, so Characters
+ * loaded with the same animation all share one copy. Only clips with the same hash are compared in full.
+ * 
+ * @param clip Clip to add. Must have at least one frame.
+ * @return Id of the clip in this registry.
+ */
+ClipId ChimpAnimationRegistry::add(const AnimationClip& clip)
+{
+    const size_t key = hash(clip);
+    const auto range = byHash.equal_range(key);
+    for(auto it = range.first; it != range.second; ++it)
+        if(clips[it->second] == clip)
+            return it->second;
+    clips.push_back(clip);
+    byHash.emplace(key, clips.size() - 1);
+    return clips.size() - 1;
+}
+
+/**
+ * @brief ChimpAnimationRegistry::hash()
+ * 
+ * FNV-1a over everything operator== compares, so equal clips always hash the same.
+ */
+size_t ChimpAnimationRegistry::hash(const AnimationClip& clip)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const uint64_t value)
+    {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    for(const ChimpTile* const frame : clip.frames)
+        mix(reinterpret_cast<uintptr_t>(frame));
+    for(const Uint32 duration : clip.durations)
+        mix(duration);
+    mix(static_cast<uint64_t>(clip.distancePerFrame));
+    return static_cast<size_t>(hash);
+}
+
+} // namespace chimp
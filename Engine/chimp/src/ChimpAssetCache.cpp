@@ -0,0 +1,168 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpAssetCache.h"
+#include "ChimpAssetPack.h"
+#include "ChimpMappedFile.h"
+
+#include <tuple>
+
+namespace chimp
+{
+
+bool ChimpAssetKey::operator<(const ChimpAssetKey& other) const
+{
+    return std::tie(kind, hash, file) < std::tie(other.kind, other.hash, other.file);
+}
+
+ChimpAssetCache::~ChimpAssetCache()
+{
+    for(auto& entry : entries)
+        free(entry.second);
+}
+
+bool ChimpAssetCache::contains(const ChimpAssetKey& key) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.count(key);
+}
+
+/**
+ * @brief ChimpAssetCache::acquire()
+ * 
+ * Takes another reference to a cached asset. Only the pointer matching the key's kind is set.
+ * 
+ * @return false if the asset isn't cached, in which case nothing is changed.
+ */
+bool ChimpAssetCache::acquire(const ChimpAssetKey& key, SDL_Texture*& texture, Mix_Chunk*& chunk, Mix_Music*& music)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto entry = entries.find(key);
+    if(entry == entries.end())
+        return false;
+    ++entry->second.refs;
+    texture = entry->second.texture;
+    chunk = entry->second.chunk;
+    music = entry->second.music;
+    return true;
+}
+
+/**
+ * @brief ChimpAssetCache::insert()
+ * 
+ * Adds a newly loaded asset, which the cache then owns, holding one reference to it. If the key is already cached,
+ * e.g. because a level loads the same file under two names, the new asset is freed and the pointers are changed to
+ * the existing one, which gains the reference instead.
+ */
+void ChimpAssetCache::insert(const ChimpAssetKey& key, SDL_Texture*& texture, Mix_Chunk*& chunk, Mix_Music*& music)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = entries[key];
+    if(entry.refs)
+    {
+        Entry duplicate;
+        duplicate.texture = texture;
+        duplicate.chunk = chunk;
+        duplicate.music = music;
+        free(duplicate);
+        texture = entry.texture;
+        chunk = entry.chunk;
+        music = entry.music;
+    }
+    else
+    {
+        entry.texture = texture;
+        entry.chunk = chunk;
+        entry.music = music;
+    }
+    ++entry.refs;
+}
+
+/**
+ * @brief ChimpAssetCache::release()
+ * 
+ * Drops one reference, freeing the asset when none are left. Must be called from the thread owning the renderer.
+ */
+void ChimpAssetCache::release(const ChimpAssetKey& key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto entry = entries.find(key);
+    if(entry == entries.end() || --entry->second.refs > 0)
+        return;
+    free(entry->second);
+    entries.erase(entry);
+}
+
+size_t ChimpAssetCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+/**
+ * @brief ChimpAssetCache::hash()
+ * 
+ * Hashes a file's contents, reading it from the asset pack when it's in there.
+ * 
+ * @return false if the file couldn't be read.
+ */
+bool ChimpAssetCache::hash(const std::string& file, uint64_t& hash)
+{
+    const char* data;
+    size_t size;
+    if(ChimpAssetPack::getPack().find(file, data, size))
+    {
+        hash = ChimpAssetCache::hash(data, size);
+        return true;
+    }
+    ChimpMappedFile mapped;
+    if(!mapped.open(file))
+        return false;
+    hash = ChimpAssetCache::hash(mapped.data(), mapped.size());
+    return true;
+}
+
+/**
+ * @brief ChimpAssetCache::hash()
+ * 
+ * 64 bit FNV-1a.
+ */
+uint64_t ChimpAssetCache::hash(const char* const data, const size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for(size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void ChimpAssetCache::free(Entry& entry)
+{
+    if(entry.texture)
+        SDL_DestroyTexture(entry.texture);
+    if(entry.chunk)
+        Mix_FreeChunk(entry.chunk);
+    if(entry.music)
+        Mix_FreeMusic(entry.music);
+    entry = Entry();
+}
+
+} // namespace chimp
@@ -0,0 +1,255 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpAssetLoader.h"
+#include "ChimpAssetPack.h"
+#include "ChimpStartupTrace.h"
+
+#if defined (__gnu_linux__) || defined (_WIN32)
+#include <SDL2/SDL_image.h>
+#endif
+#if defined (__APPLE__) && defined (__MACH__)
+#include <SDL2_image/SDL_image.h>
+#endif
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace chimp
+{
+
+ChimpAssetLoader::~ChimpAssetLoader()
+{
+    freeAll();
+}
+
+/**
+ * @brief ChimpAssetLoader::addTexture()
+ * @param name Name the texture is stored under.
+ * @param file Path to the image file.
+ */
+void ChimpAssetLoader::addTexture(const std::string& name, const std::string& file)
+{
+    add(ASSET_TEXTURE, name, file);
+}
+
+void ChimpAssetLoader::addSound(const std::string& name, const std::string& file)
+{
+    add(ASSET_SOUND, name, file);
+}
+
+void ChimpAssetLoader::addMusic(const std::string& name, const std::string& file)
+{
+    add(ASSET_MUSIC, name, file);
+}
+
+/**
+ * @brief ChimpAssetLoader::decode()
+ * 
+ * Hashes every queued asset in parallel and decodes the ones the cache doesn't have yet, then waits for all of them.
+ * Doesn't touch the renderer, so may be called from any thread, including a job system task.
+ */
+void ChimpAssetLoader::decode()
+{
+    ChimpTaskGroup group(jobs);
+    for(Asset& asset : assets)
+        group.run([this, &asset] { decode(asset, &cache); });
+    group.wait();
+}
+
+/**
+ * @brief ChimpAssetLoader::upload()
+ * 
+ * Finishes loading after decode(): creates textures on the calling thread and takes a cache reference to every asset.
+ * Assets that were cached during decode() but have been freed since are decoded again here. On success, each kind of
+ * asset is appended to its vector in the order it was added, their keys are appended to keys, which the caller must
+ * eventually release from the cache, and the loader is left empty. On failure, nothing is added and everything loaded
+ * so far is freed or released.
+ * 
+ * @param renderer Renderer textures are created for. Must be owned by the calling thread.
+ * @param timings Receives one entry per asset, in the order they were added.
+ * @return false if any asset failed to load.
+ */
+bool ChimpAssetLoader::upload(SDL_Renderer* const renderer, std::vector<SDL_Texture*>& textures,
+                              std::vector<Mix_Chunk*>& sounds, std::vector<Mix_Music*>& musics,
+                              std::vector<ChimpAssetKey>& keys, std::vector<ChimpAssetTiming>& timings)
+{
+    bool success = true;
+    for(Asset& asset : assets)
+    {
+        if(asset.error.empty() && asset.cached
+           && !cache.acquire(asset.key, asset.texture, asset.chunk, asset.music))
+        {
+            asset.cached = false;
+            decode(asset, nullptr);
+        }
+        
+        if(!asset.error.empty())
+        {
+            std::cerr << "Error loading \"" << asset.key.file << "\": " << asset.error << std::endl;
+            success = false;
+        }
+        else if(asset.key.kind == ASSET_TEXTURE && !asset.cached && success)
+        {
+            const Uint64 start = SDL_GetPerformanceCounter();
+            asset.texture = SDL_CreateTextureFromSurface(renderer, asset.surface);
+            const Uint64 end = SDL_GetPerformanceCounter();
+            asset.uploadMs = (end - start) * 1000.0 / SDL_GetPerformanceFrequency();
+            ChimpStartupTrace::getTrace().record(asset.name, "upload", start, end);
+            SDL_FreeSurface(asset.surface);
+            asset.surface = nullptr;
+            if(!asset.texture)
+            {
+                std::cerr << "CreateTextureFromSurface error: " << SDL_GetError() << std::endl;
+                success = false;
+            }
+        }
+    }
+    if(!success)
+    {
+        freeAll();
+        return false;
+    }
+    
+    for(Asset& asset : assets)
+    {
+        if(!asset.cached)
+            cache.insert(asset.key, asset.texture, asset.chunk, asset.music);
+        switch(asset.key.kind)
+        {
+        case ASSET_TEXTURE:
+            textures.push_back(asset.texture);
+            break;
+        case ASSET_SOUND:
+            sounds.push_back(asset.chunk);
+            break;
+        case ASSET_MUSIC:
+            musics.push_back(asset.music);
+            break;
+        }
+        keys.push_back(asset.key);
+        timings.push_back({asset.name, asset.key.file, asset.decodeMs, asset.uploadMs, asset.cached});
+    }
+    assets.clear();
+    return true;
+}
+
+/**
+ * @brief ChimpAssetLoader::report()
+ * 
+ * Writes a table of per-asset load times, slowest decode first.
+ */
+void ChimpAssetLoader::report(const std::vector<ChimpAssetTiming>& timings, std::ostream& out)
+{
+    std::vector<const ChimpAssetTiming*> sorted;
+    double decodeTotal = 0, uploadTotal = 0;
+    for(const ChimpAssetTiming& timing : timings)
+    {
+        sorted.push_back(&timing);
+        decodeTotal += timing.decodeMs;
+        uploadTotal += timing.uploadMs;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const ChimpAssetTiming* a, const ChimpAssetTiming* b)
+                     { return a->decodeMs > b->decodeMs; });
+    
+    const std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    out << "decode ms\tupload ms\tasset" << std::endl;
+    for(const ChimpAssetTiming* timing : sorted)
+        out << timing->decodeMs << "\t\t" << timing->uploadMs << "\t\t" << timing->name << " (" << timing->file << ")"
+            << (timing->cached ? " cached" : "") << std::endl;
+    out << decodeTotal << "\t\t" << uploadTotal << "\t\ttotal, " << timings.size() << " assets" << std::endl;
+    out.flags(flags);
+}
+
+void ChimpAssetLoader::add(const AssetKind kind, const std::string& name, const std::string& file)
+{
+    assets.emplace_back();
+    assets.back().key.kind = kind;
+    assets.back().key.file = file;
+    assets.back().key.hash = 0;
+    assets.back().name = name;
+}
+
+/**
+ * @brief ChimpAssetLoader::decode()
+ * 
+ * Runs on a worker thread. Only touches the given asset. Files come from the asset pack when they're in it.
+ * 
+ * @param skipCached If not null, the file is hashed first and not decoded if this cache already has it.
+ */
+void ChimpAssetLoader::decode(Asset& asset, const ChimpAssetCache* const skipCached)
+{
+    const Uint64 start = SDL_GetPerformanceCounter();
+    if(skipCached && ChimpAssetCache::hash(asset.key.file, asset.key.hash) && skipCached->contains(asset.key))
+    {
+        asset.cached = true;
+        const Uint64 end = SDL_GetPerformanceCounter();
+        asset.decodeMs = (end - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        ChimpStartupTrace::getTrace().record(asset.name, "hash", start, end);
+        return;
+    }
+    SDL_RWops* const rw = ChimpAssetPack::getPack().openRW(asset.key.file);
+    switch(asset.key.kind)
+    {
+    case ASSET_TEXTURE:
+        asset.surface = IMG_Load_RW(rw, 1);
+        if(!asset.surface)
+            asset.error = SDL_GetError(); // SDL errors are per thread
+        break;
+    case ASSET_SOUND:
+        asset.chunk = Mix_LoadWAV_RW(rw, 1);
+        if(!asset.chunk)
+            asset.error = SDL_GetError();
+        break;
+    case ASSET_MUSIC:
+        asset.music = Mix_LoadMUS_RW(rw, 1); // streams from rw, so pack memory must outlive it
+        if(!asset.music)
+            asset.error = SDL_GetError();
+        break;
+    }
+    const Uint64 end = SDL_GetPerformanceCounter();
+    asset.decodeMs = (end - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    ChimpStartupTrace::getTrace().record(asset.name, "decode", start, end);
+}
+
+void ChimpAssetLoader::freeAll()
+{
+    for(Asset& asset : assets)
+    {
+        if(asset.cached)
+        {
+            if(asset.texture || asset.chunk || asset.music) // acquired
+                cache.release(asset.key);
+            continue;
+        }
+        if(asset.surface)
+            SDL_FreeSurface(asset.surface);
+        if(asset.texture)
+            SDL_DestroyTexture(asset.texture);
+        if(asset.chunk)
+            Mix_FreeChunk(asset.chunk);
+        if(asset.music)
+            Mix_FreeMusic(asset.music);
+    }
+    assets.clear();
+}
+
+} // namespace chimp
@@ -0,0 +1,403 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpAssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace chimp
+{
+
+namespace // LZ4 block format, see https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+{
+    constexpr size_t
+        LZ4_MIN_MATCH     = 4,
+        LZ4_LAST_LITERALS = 5,  // a block always ends with at least this many literals
+        LZ4_MATCH_LIMIT   = 12, // and its last match starts at least this far from the end
+        LZ4_MAX_OFFSET    = 65535,
+        LZ4_HASH_BITS     = 12;
+    
+    inline uint32_t read32(const char* const p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    
+    inline void writeLength(std::vector<char>& out, size_t length) // the part of a length that didn't fit in the token
+    {
+        for(; length >= 255; length -= 255)
+            out.push_back(char(255));
+        out.push_back(char(length));
+    }
+    
+    void writeSequence(std::vector<char>& out, const char* const literals, const size_t literalLength,
+                       const size_t offset, const size_t matchLength)
+    {
+        const size_t matchCode = matchLength ? matchLength - LZ4_MIN_MATCH : 0;
+        out.push_back(char( (std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15) ));
+        if(literalLength >= 15)
+            writeLength(out, literalLength - 15);
+        out.insert(out.end(), literals, literals + literalLength);
+        if(!matchLength) // last sequence
+            return;
+        out.push_back(char(offset & 0xFF));
+        out.push_back(char(offset >> 8));
+        if(matchCode >= 15)
+            writeLength(out, matchCode - 15);
+    }
+    
+    /*
+     * Greedy single pass compressor, plenty for assets that are packed once. Matches are found through a hash table of
+     * the last position each 4 byte sequence was seen at.
+     */
+    void lz4Compress(const char* const src, const size_t size, std::vector<char>& out)
+    {
+        std::vector<int64_t> table(size_t(1) << LZ4_HASH_BITS, -1);
+        size_t anchor = 0, pos = 0;
+        
+        out.clear();
+        while(size >= LZ4_MATCH_LIMIT + 1 && pos <= size - LZ4_MATCH_LIMIT)
+        {
+            const uint32_t sequence = read32(src + pos);
+            const uint32_t hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+            const int64_t candidate = table[hash];
+            table[hash] = pos;
+            if(candidate < 0 || pos - candidate > LZ4_MAX_OFFSET || read32(src + candidate) != sequence)
+            {
+                ++pos;
+                continue;
+            }
+            
+            size_t length = LZ4_MIN_MATCH;
+            while(pos + length < size - LZ4_LAST_LITERALS && src[candidate + length] == src[pos + length])
+                ++length;
+            writeSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+        }
+        writeSequence(out, src + anchor, size - anchor, 0, 0);
+    }
+    
+    /*
+     * Bounds checked, so a corrupt pack fails to load instead of writing past the buffer.
+     */
+    bool lz4Decompress(const unsigned char* const src, const size_t srcSize, char* const dst, const size_t dstSize)
+    {
+        size_t in = 0, out = 0;
+        while(in < srcSize)
+        {
+            const unsigned token = src[in++];
+            size_t literalLength = token >> 4;
+            if(literalLength == 15)
+            {
+                unsigned char byte;
+                do
+                {
+                    if(in >= srcSize)
+                        return false;
+                    byte = src[in++];
+                    literalLength += byte;
+                } while(byte == 255);
+            }
+            if(literalLength > srcSize - in || literalLength > dstSize - out)
+                return false;
+            if(literalLength)
+                std::memcpy(dst + out, src + in, literalLength);
+            in += literalLength;
+            out += literalLength;
+            if(in == srcSize) // the last sequence has no match
+                break;
+            
+            if(srcSize - in < 2)
+                return false;
+            const size_t offset = src[in] | (src[in + 1] << 8);
+            in += 2;
+            if(offset == 0 || offset > out)
+                return false;
+            size_t matchLength = token & 15;
+            if(matchLength == 15)
+            {
+                unsigned char byte;
+                do
+                {
+                    if(in >= srcSize)
+                        return false;
+                    byte = src[in++];
+                    matchLength += byte;
+                } while(byte == 255);
+            }
+            matchLength += LZ4_MIN_MATCH;
+            if(matchLength > dstSize - out)
+                return false;
+            for(size_t i = 0; i < matchLength; ++i, ++out) // matches may overlap their own output
+                dst[out] = dst[out - offset];
+        }
+        return out == dstSize;
+    }
+    
+    std::string normalize(const std::string& path)
+    {
+        size_t start = 0;
+        while(path.compare(start, 2, "./") == 0)
+            start += 2;
+        return path.substr(start);
+    }
+    
+    struct LuaChunk
+    {
+        const char* data;
+        size_t size;
+    };
+    
+    const char* readChunk(lua_State*, void* const chunkPtr, size_t* const size) // lua_Reader
+    {
+        LuaChunk& chunk = *static_cast<LuaChunk*>(chunkPtr);
+        *size = chunk.size;
+        chunk.size = 0; // everything is handed over at once
+        return *size ? chunk.data : nullptr;
+    }
+} // LZ4 block format
+
+ChimpAssetPack& ChimpAssetPack::getPack()
+{
+    static ChimpAssetPack pack;
+    return pack;
+}
+
+/**
+ * @brief ChimpAssetPack::mount()
+ * 
+ * Maps a pack so its files are served to loaders from then on. A missing pack isn't an error, everything is just
+ * loaded from loose files.
+ * 
+ * @return false if there is no usable pack. Only a pack that exists but is invalid is reported.
+ */
+bool ChimpAssetPack::mount(const std::string& packFile)
+{
+    unmount();
+    if(!file.open(packFile))
+        return false;
+    if(!validate())
+    {
+        std::cerr << "Error: \"" << packFile << "\" isn't a valid version " << PACK_VERSION << " asset pack, "
+                  << "loading loose files instead" << std::endl;
+        file.close();
+        return false;
+    }
+    count = reinterpret_cast<const Header*>(file.data())->count;
+    entries = reinterpret_cast<const Entry*>(file.data() + sizeof(Header));
+    return true;
+}
+
+/**
+ * @brief ChimpAssetPack::unmount()
+ * 
+ * Nothing handed out by find(), openRW() or Music streaming from the pack may be used after this.
+ */
+void ChimpAssetPack::unmount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    decompressed.clear();
+    file.close();
+    entries = nullptr;
+    count = 0;
+}
+
+/**
+ * @brief ChimpAssetPack::find()
+ * 
+ * Looks a file up in the pack. Compressed files are decompressed on first use. Safe to call from any thread.
+ * 
+ * @param data Set to the file's contents, which stay valid until unmount().
+ * @return false if the file isn't in the pack.
+ */
+bool ChimpAssetPack::find(const std::string& path, const char*& data, size_t& size)
+{
+    const Entry* const entry = findEntry(path);
+    if(!entry)
+        return false;
+    size = entry->size;
+    if(!(entry->flags & PACK_LZ4))
+    {
+        data = file.data() + entry->offset;
+        return true;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = decompressed.find(entry - entries);
+    if(found == decompressed.end())
+    {
+        std::vector<char> contents(entry->size);
+        const unsigned char* const blob = reinterpret_cast<const unsigned char*>(file.data() + entry->offset);
+        if(!lz4Decompress(blob, entry->storedSize, contents.data(), contents.size()))
+        {
+            std::cerr << "Error: \"" << path << "\" is corrupt in the asset pack" << std::endl;
+            return false;
+        }
+        found = decompressed.emplace(entry - entries, std::move(contents)).first;
+    }
+    data = found->second.data();
+    return true;
+}
+
+/**
+ * @brief ChimpAssetPack::openRW()
+ * 
+ * Opens a file for any SDL loader taking an SDL_RWops: memory backed if it's in the pack, the loose file otherwise.
+ * 
+ * @return nullptr if the file can't be found, with the SDL error set
+ */
+SDL_RWops* ChimpAssetPack::openRW(const std::string& path)
+{
+    const char* data;
+    size_t size;
+    if(find(path, data, size))
+        return SDL_RWFromConstMem(data, size);
+    return SDL_RWFromFile(path.c_str(), "rb");
+}
+
+/**
+ * @brief ChimpAssetPack::loadLua()
+ * 
+ * Like luaL_loadfile(), but reads the script from the pack if it's in there.
+ */
+int ChimpAssetPack::loadLua(lua_State* const luast, const std::string& path)
+{
+    LuaChunk chunk;
+    if(!find(path, chunk.data, chunk.size))
+        return luaL_loadfile(luast, path.c_str());
+    return lua_load(luast, readChunk, &chunk, ("@" + path).c_str(), nullptr);
+}
+
+/**
+ * @brief ChimpAssetPack::write()
+ * 
+ * Packs files into a new pack file. Each file is stored under the path given for it.
+ * 
+ * @param compress LZ4 compress every file that gets smaller from it.
+ * @return false if a file can't be read or the pack can't be written.
+ */
+bool ChimpAssetPack::write(const std::string& packFile, std::vector<std::string> paths, const bool compress)
+{
+    for(std::string& path : paths)
+        path = normalize(path);
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    
+    std::vector<Entry> index(paths.size());
+    std::vector<char> names;
+    size_t offset = sizeof(Header) + index.size() * sizeof(Entry);
+    for(size_t i = 0; i < paths.size(); ++i)
+    {
+        index[i].path = offset + names.size();
+        names.insert(names.end(), paths[i].c_str(), paths[i].c_str() + paths[i].size() + 1);
+    }
+    offset += names.size();
+    
+    std::vector<std::vector<char>> blobs(paths.size());
+    for(size_t i = 0; i < paths.size(); ++i)
+    {
+        std::ifstream in(paths[i], std::ios::binary);
+        if(!in)
+        {
+            std::cerr << "Error: can't read \"" << paths[i] << "\" for packing" << std::endl;
+            return false;
+        }
+        std::vector<char> contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        index[i].size = contents.size();
+        index[i].flags = 0;
+        if(compress)
+        {
+            lz4Compress(contents.data(), contents.size(), blobs[i]);
+            if(blobs[i].size() < contents.size())
+                index[i].flags |= PACK_LZ4;
+        }
+        if(!(index[i].flags & PACK_LZ4))
+            blobs[i].swap(contents);
+        
+        offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+        index[i].offset = offset;
+        index[i].storedSize = blobs[i].size();
+        offset += blobs[i].size();
+        std::cout << paths[i] << ": " << index[i].size << " -> " << index[i].storedSize << " bytes" << std::endl;
+    }
+    
+    const Header header = { PACK_MAGIC, PACK_VERSION, PACK_ENDIAN, uint32_t(paths.size()) };
+    std::ofstream out(packFile, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(Entry));
+    out.write(names.data(), names.size());
+    for(size_t i = 0; i < blobs.size(); ++i)
+    {
+        while(size_t(out.tellp()) < index[i].offset)
+            out.put('\0');
+        out.write(blobs[i].data(), blobs[i].size());
+    }
+    if(!out)
+    {
+        std::cerr << "Error: can't write asset pack \"" << packFile << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Binary search over the sorted index, so lookups don't allocate.
+ */
+const ChimpAssetPack::Entry* ChimpAssetPack::findEntry(const std::string& path) const
+{
+    if(!count)
+        return nullptr;
+    const std::string key = normalize(path);
+    const Entry* const end = entries + count;
+    const Entry* const found = std::lower_bound(entries, end, key, [this](const Entry& entry, const std::string& k)
+                                                { return std::strcmp(file.data() + entry.path, k.c_str()) < 0; });
+    return found != end && key == file.data() + found->path ? found : nullptr;
+}
+
+bool ChimpAssetPack::validate() const
+{
+    const size_t size = file.size();
+    if(size < sizeof(Header))
+        return false;
+    const Header& header = *reinterpret_cast<const Header*>(file.data());
+    if(   header.magic != PACK_MAGIC || header.version != PACK_VERSION || header.endian != PACK_ENDIAN
+       || header.count > (size - sizeof(Header)) / sizeof(Entry) )
+        return false;
+    
+    const Entry* const index = reinterpret_cast<const Entry*>(file.data() + sizeof(Header));
+    for(uint32_t i = 0; i < header.count; ++i)
+    {
+        const Entry& entry = index[i];
+        if(   entry.path >= size || !std::memchr(file.data() + entry.path, '\0', size - entry.path)
+           || entry.offset > size || entry.storedSize > size - entry.offset
+           || (!(entry.flags & PACK_LZ4) && entry.storedSize != entry.size) )
+            return false;
+        if(i > 0 && std::strcmp(file.data() + index[i - 1].path, file.data() + entry.path) >= 0)
+            return false;
+    }
+    return true;
+}
+
+} // namespace chimp
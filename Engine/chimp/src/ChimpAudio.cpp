@@ -0,0 +1,261 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpAudio.h"
+#include "ChimpConstants.h"
+
+
+namespace chimp
+{
+
+/**
+ * @brief ChimpAudioQueue::ChimpAudioQueue()
+ * @param capacity Most commands queued at once, rounded up to a power of two.
+ */
+ChimpAudioQueue::ChimpAudioQueue(const size_t capacity) : head(0), tail(0)
+{
+    size_t size = 1;
+    while(size < capacity)
+        size *= 2;
+    commands.resize(size);
+    mask = size - 1;
+}
+
+/**
+ * @brief ChimpAudioQueue::push()
+ * 
+ * Producer side.
+ * 
+ * @return false if the queue is full.
+ */
+bool ChimpAudioQueue::push(const ChimpAudioCommand& command)
+{
+    const size_t back = tail.load(std::memory_order_relaxed);
+    if(back - head.load(std::memory_order_acquire) == commands.size())
+        return false;
+    commands[back & mask] = command;
+    tail.store(back + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief ChimpAudioQueue::pop()
+ * 
+ * Consumer side.
+ * 
+ * @return false if the queue is empty.
+ */
+bool ChimpAudioQueue::pop(ChimpAudioCommand& command)
+{
+    const size_t front = head.load(std::memory_order_relaxed);
+    if(front == tail.load(std::memory_order_acquire))
+        return false;
+    command = commands[front & mask];
+    head.store(front + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief ChimpAudioService::ChimpAudioService()
+ * @param voiceCount Sounds played at once, on mixer channels 0 to voiceCount - 1.
+ * @param queueSize Most commands waiting for the audio thread at once.
+ */
+ChimpAudioService::ChimpAudioService(const int voiceCount, const size_t queueSize)
+    : queue(queueSize), voices(voiceCount), stopping(false), sleeping(false), done(0), sent(0), dropped(0), nextVoice(1)
+{
+    thread = std::thread(&ChimpAudioService::run, this);
+}
+
+ChimpAudioService::~ChimpAudioService()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+/**
+ * @brief ChimpAudioService::play()
+ * 
+ * Plays a sound once, if it's more important than a sound already playing when every voice is busy.
+ * 
+ * @param gain Volume from 0 to 1.
+ * @param pan Stereo position from -1 (left) to 1 (right).
+ * @return Names the sound for stop() and setPosition() while it plays.
+ */
+VoiceId ChimpAudioService::play(Mix_Chunk* const chunk, const VoicePriority priority, const float gain,
+                                const float pan)
+{
+    if(!chunk || gain <= 0)
+        return 0;
+    ChimpAudioCommand command = {};
+    command.op = AUDIO_PLAY;
+    command.voice = nextVoice++;
+    command.chunk = chunk;
+    command.priority = priority;
+    command.gain = gain;
+    command.pan = pan;
+    send(command);
+    return command.voice;
+}
+
+/**
+ * @brief ChimpAudioService::playAt()
+ * 
+ * Plays a sound made by something in the world, heard as ChimpVoiceManager::locate() works out.
+ * 
+ * @return Names the sound for stop() and setPosition() while it plays, or 0 if it's too far away to hear.
+ */
+VoiceId ChimpAudioService::playAt(Mix_Chunk* const chunk, const Box<float>& source, const IntBox& view,
+                                  const int zone, const VoicePriority priority)
+{
+    float gain, pan;
+    if(!ChimpVoiceManager::locate(source, view, zone, gain, pan))
+        return 0;
+    return play(chunk, priority, gain, pan);
+}
+
+/**
+ * @brief ChimpAudioService::stop()
+ */
+void ChimpAudioService::stop(const VoiceId voice)
+{
+    ChimpAudioCommand command = {};
+    command.op = AUDIO_STOP;
+    command.voice = voice;
+    send(command);
+}
+
+/**
+ * @brief ChimpAudioService::setPosition()
+ * 
+ * Changes the volume and stereo position of a sound while it plays.
+ */
+void ChimpAudioService::setPosition(const VoiceId voice, const float gain, const float pan)
+{
+    ChimpAudioCommand command = {};
+    command.op = AUDIO_POSITION;
+    command.voice = voice;
+    command.gain = gain;
+    command.pan = pan;
+    send(command);
+}
+
+/**
+ * @brief ChimpAudioService::playMusic()
+ * 
+ * Loops music, or halts the music if it's null.
+ */
+void ChimpAudioService::playMusic(Mix_Music* const music)
+{
+    ChimpAudioCommand command = {};
+    command.op = AUDIO_MUSIC;
+    command.music = music;
+    send(command);
+}
+
+/**
+ * @brief ChimpAudioService::halt()
+ * 
+ * Stops every sound and the music.
+ */
+void ChimpAudioService::halt()
+{
+    ChimpAudioCommand command = {};
+    command.op = AUDIO_HALT;
+    send(command);
+}
+
+/**
+ * @brief ChimpAudioService::wait()
+ * 
+ * Blocks until the audio thread has run every command sent, e.g. before freeing chunks or music they name. Not for
+ * use every tick.
+ */
+void ChimpAudioService::wait()
+{
+    while(done.load(std::memory_order_acquire) != sent)
+        std::this_thread::yield();
+}
+
+void ChimpAudioService::send(const ChimpAudioCommand& command)
+{
+    if(!queue.push(command))
+    {
+        ++dropped;
+        return;
+    }
+    ++sent;
+    // Either this sees the audio thread going to sleep, or the audio thread sees the command before it sleeps.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(sleeping.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(mutex); // the audio thread is either waiting already or still holds it
+        wake.notify_one();
+    }
+}
+
+void ChimpAudioService::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while(!stopping)
+    {
+        ChimpAudioCommand command;
+        if(queue.pop(command))
+        {
+            execute(command);
+            done.fetch_add(1, std::memory_order_release);
+            continue;
+        }
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+void ChimpAudioService::execute(const ChimpAudioCommand& command)
+{
+    switch(command.op)
+    {
+    case AUDIO_PLAY:
+        voices.play(command.chunk, command.priority, command.gain, command.pan, command.voice);
+        break;
+    case AUDIO_STOP:
+        voices.stop(command.voice);
+        break;
+    case AUDIO_POSITION:
+        voices.setPosition(command.voice, command.gain, command.pan);
+        break;
+    case AUDIO_MUSIC:
+        if(command.music)
+            Mix_PlayMusic(command.music, -1);
+        else
+            Mix_HaltMusic();
+        break;
+    case AUDIO_HALT:
+        voices.stopAll();
+        Mix_HaltMusic();
+        break;
+    }
+}
+
+} // namespace chimp
@@ -19,6 +19,7 @@
 
 #include "ChimpCharacter.h"
 #include "ChimpGame.h"
+#include "ChimpProfiler.h"
 
 #include <cmath>
 #include <iostream>
@@ -28,10 +29,11 @@ namespace chimp
 
 /**
  * @brief ChimpCharacter::ChimpCharacter()
- * @param tilRn Character's run ChimpTiles
- * @param tilJmp Character's jump ChimpTiles
- * @param tilIdl Character's idle ChimpTiles
  * @param rend SDL renderer that should be drawn to
+ * @param clps Registry the clip ids refer to, which must outlive the Character
+ * @param clpRn Character's run AnimationClip
+ * @param clpJmp Character's jump AnimationClip
+ * @param clpIdl Character's idle AnimationClip
  * @param pX Object's initial x-position
  * @param pY Object's initial y-position
  * @param tilesX How many times the ChimpTile should be tiled to the right.
@@ -40,15 +42,16 @@ namespace chimp
  * @param enms Factions which the Object can deal damage to.
  * @param maxHlth Charcter's maximum health
  */
-ChimpCharacter::ChimpCharacter(SDL_Renderer* const rend, const TileVec& tilRn, const TileVec& tilJmp,
-                               const TileVec& tilIdl, const int pX, const int pY, const int tilesX, const int tilesY,
-                               Faction frnds, Faction enms, const int maxHlth)
-    : ChimpMobile(rend, tilIdl[0], pX, pY, tilesX, tilesY, frnds, enms), tilesRun(tilRn), tilesJump(tilJmp),
-      tilesIdle(tilIdl), maxHealth(maxHlth)
+ChimpCharacter::ChimpCharacter(SDL_Renderer* const rend, const ChimpAnimationRegistry& clps, const ClipId clpRn,
+                               const ClipId clpJmp, const ClipId clpIdl, const int pX, const int pY, const int tilesX,
+                               const int tilesY, Faction frnds, Faction enms, const int maxHlth)
+    : ChimpMobile(rend, *clps.get(clpIdl).frames[0], pX, pY, tilesX, tilesY, frnds, enms), clips(clps),
+      clipRun(clpRn), clipJump(clpJmp), clipIdle(clpIdl), clipCurrent(clpIdl), frameCursor(0), maxHealth(maxHlth)
 {
     health = maxHealth;
     vulnerable = true;
-    idleTime = 0;
+    animationTime = 0;
+    idleTime = -1;
     soundJump = nullptr;
     soundMultijump = nullptr;
 }
@@ -59,30 +62,6 @@ void ChimpCharacter::initialize(const ChimpGame& game)
     ChimpMobile::initialize(game);
 }
 
-bool ChimpCharacter::setTilesIdle(const TileVec& vec)
-{
-    if(vec.empty())
-        return false;
-    tilesIdle = vec;
-    return true;
-}
-
-bool ChimpCharacter::setTilesRun(const TileVec& vec)
-{
-    if(vec.empty())
-        return false;
-    tilesRun = vec;
-    return true;
-}
-
-bool ChimpCharacter::setTilesJump(const TileVec& vec)
-{
-    if(vec.empty())
-        return false;
-    tilesJump = vec;
-    return true;
-}
-
 /**
  * @brief ChimpCharacter::runRight()
  * 
@@ -90,12 +69,11 @@ bool ChimpCharacter::setTilesJump(const TileVec& vec)
  */
 void ChimpCharacter::runRight()
 {
-    idleTime = 0;
+    idleTime = -1;
     if(!runningRight)
     {
         moveStart.x = coord.x;
-        tile = tilesRun[0];
-        tileIndex = 0;
+        startClip(clipRun);
     }
     ChimpMobile::runRight();
 }
@@ -107,12 +85,11 @@ void ChimpCharacter::runRight()
  */
 void ChimpCharacter::runLeft()
 {
-    idleTime = 0;
+    idleTime = -1;
     if(!runningLeft)
     {
         moveStart.x = coord.x;
-        tile = tilesRun[0];
-        tileIndex = 0;
+        startClip(clipRun);
     }
     ChimpMobile::runLeft();
 }
@@ -124,12 +101,11 @@ void ChimpCharacter::runLeft()
  */
 void ChimpCharacter::jump(ChimpGame& game)
 {
-    idleTime = 0;
+    idleTime = -1;
     if(platform)
     {
         moveStart.x = coord.x;
-        tile = tilesJump[0];
-        tileIndex = 0;
+        startClip(clipJump);
         if(soundJump)
             playSound(soundJump, game);
     }
@@ -166,11 +142,14 @@ bool ChimpCharacter::setMaxHealth(const int heal)
  * 
  * [...]
  */
-void ChimpCharacter::update(const ObjectVector& objects, ChimpGame& game, const Uint32 time)
+void ChimpCharacter::update(const ObjectVector& objects, ChimpGame& game, const double time)
 {
     ChimpMobile::update(objects, game, time);
+    animationTime += time;
     
     if(active && vulnerable)
+    {
+        ChimpProfileZone zone("collision");
         for(const ObjectPointer& obj : objects)
         {
             if(!obj->isActive() || (!obj->getDamageTop() && touchesAtBottom(*obj)) || &*obj == platform)
@@ -195,109 +174,126 @@ void ChimpCharacter::update(const ObjectVector& objects, ChimpGame& game, const
                 else
                 {
                     setVulnerable(false);
-                    SDL_AddTimer(INVULNERABLE_TIME, vulnerableTimer, this);
+                    addTimer(game, INVULNERABLE_TIME, [this](const TimerId) { setVulnerable(true); });
                 }
             }
         }
+    }
 }
 
 /**
  * @brief ChimpCharacter::render()
  * 
- * Calls ChimpMobile::render(). Animates this Character by cycling through the appropriate ChimpTile vector.
+ * Calls ChimpMobile::render(). Animates this Character by cycling through the appropriate AnimationClip.
  * 
  * @param screen Current view for this Character's game layer.
  */
 void ChimpCharacter::render(const IntBox& screen)
+{
+    animate();
+    
+    if(vulnerable)
+        ChimpMobile::render(screen);
+    else
+    {
+        SDL_SetTextureColorMod(tile->texture, TINT_DAMAGED.r, TINT_DAMAGED.g, TINT_DAMAGED.b);
+        ChimpMobile::render(screen);
+        SDL_SetTextureColorMod(tile->texture, 255, 255, 255);
+    }
+}
+
+/**
+ * @brief ChimpCharacter::record()
+ * 
+ * Calls ChimpMobile::record(). Animates this Character the same way render() does.
+ * 
+ * @param screen Current view for this Character's game layer.
+ * @param packet Render packet being built for the next frame.
+ */
+void ChimpCharacter::record(const IntBox& screen, ChimpRenderPacket& packet)
+{
+    animate();
+    
+    const size_t first = packet.draws.size();
+    ChimpMobile::record(screen, packet);
+    if(!vulnerable)
+        for(size_t i = first; i < packet.draws.size(); ++i)
+            packet.draws[i].tint = TINT_DAMAGED;
+}
+
+/**
+ * @brief ChimpCharacter::animate()
+ * 
+ * Advances this Character's frame cursor through its run, jump or idle AnimationClip and points its ChimpTile at the
+ * current frame. Run and jump clips advance with distance moved, idle clips with game time, so the same updates always
+ * show the same frames.
+ */
+void ChimpCharacter::animate()
 {
     if(!platform)
     {
-        if(int(coord.y-moveStart.y) / PIXELS_PER_FRAME_Y)
+        const AnimationClip& clip = clips.get(clipJump);
+        if(clipCurrent != clipJump)
+            startClip(clipJump);
+        else if(int(coord.y-moveStart.y) / clip.distancePerFrame)
         {
-            tileIndex = (tileIndex+1) % tilesJump.size();
-            tile = tilesJump[tileIndex];
+            frameCursor = (frameCursor+1) % clip.size();
+            tile = clip.frames[frameCursor];
             moveStart.y = coord.y;
         }
     }
     else if(runningLeft || runningRight)
     {
-        size_t in = std::abs((int)(coord.x-moveStart.x) / PIXELS_PER_FRAME_X) % tilesRun.size();
-        if(tileIndex != in)
+        const AnimationClip& clip = clips.get(clipRun);
+        size_t in = std::abs((int)(coord.x-moveStart.x) / clip.distancePerFrame) % clip.size();
+        if(clipCurrent != clipRun || frameCursor != in)
         {
-            tile = tilesRun[in];
-            tileIndex = in;
+            clipCurrent = clipRun;
+            frameCursor = in;
+            tile = clip.frames[in];
         }
     }
     else
     {
-        Uint32 time = SDL_GetTicks();
-        if(idleTime == 0)
+        const AnimationClip& clip = clips.get(clipIdle);
+        if(idleTime < 0 || clipCurrent != clipIdle)
         {
-            tileIndex = 0;
-            tile = tilesIdle[tileIndex];
-            idleTime = time;
+            startClip(clipIdle);
+            idleTime = animationTime;
         }
-        else if((time - idleTime) / TIME_PER_IDLE)
+        else if(animationTime - idleTime >= clip.durations[frameCursor])
         {
-            tileIndex = (tileIndex+1) % tilesIdle.size();
-            tile = tilesIdle[tileIndex];
-            idleTime = time;
+            frameCursor = (frameCursor+1) % clip.size();
+            tile = clip.frames[frameCursor];
+            idleTime = animationTime;
         }
     }
-    
-    if(vulnerable)
-        ChimpMobile::render(screen);
-    else
-    {
-        SDL_SetTextureColorMod(tile.texture, 255, 0, 0);
-        ChimpMobile::render(screen);
-        SDL_SetTextureColorMod(tile.texture, 255, 255, 255);
-    }
 }
 
-void ChimpCharacter::playSound(Mix_Chunk* const sound, const ChimpGame& game) const
+/**
+ * @brief ChimpCharacter::startClip()
+ * 
+ * Switches this Character to the first frame of an AnimationClip.
+ * 
+ * @param clip Id of the clip in clips.
+ */
+void ChimpCharacter::startClip(const ClipId clip)
 {
-    const float left = game.getMidViewLeft() - getCollisionRight();
-    const float right = getCollisionLeft() - game.getMidViewRight();
-    const float top = game.getMidViewTop() - getCollisionBottom();
-    const float bottom = getCollisionTop() - game.getMidViewBottom();
-    const float horiz = left > right ? left : right;
-    const float vert = top > bottom ? top : bottom;
-    if(horiz > game.getActiveZone() || vert > game.getActiveZone())
-        return;
-    
-    if(horiz > 0)
-    {
-        if(vert > 0)
-        {
-            const float volume = 128.0f * (game.getActiveZone() - std::sqrt(horiz*horiz + vert*vert)) / game.getActiveZone();
-            if(volume < 0)
-                return;
-            Mix_VolumeChunk(sound, (int)volume);
-            Mix_PlayChannel(-1, sound, 0);
-        }
-        else
-        {
-            const float volume = 128.0f * (game.getActiveZone() - horiz) / game.getActiveZone();
-            if(volume < 0)
-                return;
-            Mix_VolumeChunk(sound, (int)volume);
-            Mix_PlayChannel(-1, sound, 0);
-        }
-    }
-    else if(vert > 0)
-    {
-        const float volume = (128.0f * (game.getActiveZone() - vert) / game.getActiveZone());
-        if(volume < 0)
-            return;
-        Mix_VolumeChunk(sound, (int)volume);
-        Mix_PlayChannel(-1, sound, 0);
-    }
-    else
-    {
-        Mix_VolumeChunk(sound, 128);
-        Mix_PlayChannel(-1, sound, 0);
-    }
+    clipCurrent = clip;
+    frameCursor = 0;
+    tile = clips.get(clip).frames[0];
+}
+
+/**
+ * @brief ChimpCharacter::playSound()
+ * 
+ * Plays a sound from where this Character is, through the game's voices. The player's sounds take priority.
+ */
+void ChimpCharacter::playSound(Mix_Chunk* const sound, ChimpGame& game) const
+{
+    const Box<float> source = { getCollisionLeft(), getCollisionRight(), getCollisionTop(), getCollisionBottom() };
+    game.getAudio().playAt(sound, source, game.getMidView(), game.getActiveZone(),
+                            this == ChimpGame::getPlayer() ? VOICE_HIGH : VOICE_NORMAL);
 }
 
 } // namespace chimp
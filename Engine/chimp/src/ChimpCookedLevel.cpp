@@ -0,0 +1,1126 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpCookedLevel.h"
+#include "ChimpGame.h"
+#include "ChimpXMLReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <tinyxml2.h>
+
+namespace chimp
+{
+
+namespace // XML to records
+{
+    bool getBool(const char* const boolStr, bool& result)
+    {
+        if(!boolStr)
+            return false;
+        if(strcmp(boolStr, "true") == 0)
+        {
+            result = true;
+            return true;
+        }
+        if(strcmp(boolStr, "false") == 0)
+        {
+            result = false;
+            return true;
+        }
+        return false;
+    }
+    
+    inline bool getInt(const char* const str, int& result)
+    {
+        return str && tinyxml2::XMLUtil::ToInt(str, &result);
+    }
+    
+    inline bool getFloat(const char* const str, float& result)
+    {
+        return str && tinyxml2::XMLUtil::ToFloat(str, &result);
+    }
+    
+    Layer getLayer(const char* const layer)
+    {
+        if(layer && strcmp(layer, "background") == 0)
+            return BACK;
+        if(layer && strcmp(layer, "foreground") == 0)
+            return FORE;
+        return MID;
+    }
+    
+    /*
+     * Cooks a level in a single pass over its XML, without building a document. Each element is handled as it's read,
+     * so textures, tiles, sounds and music may be named before they're declared; those references are kept by name
+     * and resolved once the whole file has been read. As with tinyxml2's FirstChildElement(), only the first of each
+     * single valued child (e.g. <position>) counts, and an element's text only counts if it's its first child.
+     */
+    class Cooker
+    {
+    public:
+        CookedHeader header;
+        std::vector<std::string> names;
+        std::vector<CookedAsset> textures, sounds, musics;
+        std::vector<CookedTile> tiles;
+        std::vector<CookedFrame> frames;
+        std::vector<CookedObject> objects;
+        std::vector<CookedOp> ops;
+        std::vector<CookedSection> sections;
+        
+    private:
+        static constexpr uint32_t AUTO_SECTION = COOKED_NONE - 1; // section chosen by x position
+        
+        enum Context { DOCUMENT, TILE, LEVEL, SECTION, OBJECT, LEAF, SKIP };
+        enum Leaf // elements whose text is needed
+        {
+            LEAF_MUSIC, LEAF_ACTIVE_ZONE, LEAF_INACTIVE_ZONE, LEAF_STREAM_DISTANCE, LEAF_SECTION_WIDTH,
+            LEAF_TILE, LEAF_MAX_HEALTH, LEAF_RESPAWN, LEAF_STOP_FACTOR, LEAF_SPRINT_FACTOR, LEAF_MAX_JUMPS,
+            LEAF_FACTION, LEAF_ACCELERATION, LEAF_IMPULSE, LEAF_RESISTANCE, LEAF_SCRIPT, LEAF_SOUND
+        };
+        /*
+         * An object's ops are collected per property and stored in this order once the object ends, whatever order
+         * its children come in, so a _SCALE op still lands after the absolute ops it scales.
+         */
+        enum Property
+        {
+            PROP_POSITION, PROP_TILES, PROP_MAX_HEALTH, PROP_RESPAWN, PROP_DAMAGE, PROP_BOUNDED, PROP_STOP_FACTOR,
+            PROP_SPRINT_FACTOR, PROP_MAX_JUMPS, PROP_FACTION, PROP_ACCELERATION, PROP_IMPULSE, PROP_RESISTANCE,
+            PROP_SCRIPT, PROP_SOUND, PROP_COUNT
+        };
+        enum Once // bits of single valued children already read
+        {
+            ONCE_TEXTURE = 1<<0, ONCE_STRETCH = 1<<1, ONCE_COLLISION = 1<<2, // of a tile
+            ONCE_EDGES = 1<<0, ONCE_SCROLL = 1<<1, ONCE_MUSIC = 1<<2, ONCE_ACTIVE_ZONE = 1<<3, // of the level
+            ONCE_INACTIVE_ZONE = 1<<4, ONCE_STREAM_DISTANCE = 1<<5, ONCE_SECTION_WIDTH = 1<<6,
+            ONCE_POSITION = 1<<0, ONCE_TILES = 1<<1, ONCE_MAX_HEALTH = 1<<2, ONCE_RESPAWN = 1<<3, // of an object
+            ONCE_DAMAGE = 1<<4, ONCE_BOUNDED = 1<<5, ONCE_STOP_FACTOR = 1<<6, ONCE_SPRINT_FACTOR = 1<<7,
+            ONCE_MAX_JUMPS = 1<<8
+        };
+        
+        std::map<std::string, uint32_t> nameIndices, textureIndices, tileIndices, soundIndices, musicIndices;
+        std::vector<uint32_t> objectSections; // section index, AUTO_SECTION or COOKED_NONE for each object
+        std::vector<CookedObject> sectionObjects; // objects in a <section>, which follow the level's own
+        std::vector<uint32_t> sectionObjectSections;
+        std::vector<std::string> tileTextures;   // texture named by each tile, until resolved
+        std::vector<std::string> frameTiles;     // tile named by each frame, until resolved
+        std::vector<std::string> opSounds;       // sound named by each <sound> child; sound ops' operands index this
+        std::string musicName;
+        bool hasMusic, levelRead;
+        int sectionWidth;
+        
+        std::vector<Context> contexts; // one per open element
+        uint32_t levelOnce, once;      // once is for the current tile or object
+        std::string tileName, tileTexture;
+        CookedTile tile;
+        bool stretchWidth, stretchHeight;
+        CookedObject object;
+        uint32_t objectSection;
+        bool inSection;
+        std::vector<CookedOp> properties[PROP_COUNT];
+        Leaf leaf;
+        CookedFrame frame;
+        std::string leafText, leafType, leafMode;
+        bool leafHasText, leafHasType, leafFirstChild;
+        
+    public:
+        Cooker() : hasMusic(false), levelRead(false), sectionWidth(0), levelOnce(0), once(0)
+            { std::memset(&header, 0, sizeof(header)); }
+        
+        uint32_t intern(const std::string& name)
+        {
+            auto found = nameIndices.find(name);
+            if(found != nameIndices.end())
+                return found->second;
+            names.push_back(name);
+            return nameIndices[name] = names.size() - 1;
+        }
+        
+        bool cook(const char* const xml, const size_t length);
+        void serialize(std::vector<char>& blob);
+        
+    private:
+        bool start(const ChimpXMLReader& reader, Context& context);
+        bool startTop(const ChimpXMLReader& reader, Context& context);
+        bool startTile(const ChimpXMLReader& reader);
+        void startLevel(const ChimpXMLReader& reader, Context& context);
+        void startObject(const ChimpXMLReader& reader, const uint32_t section, Context& context);
+        void startProperty(const ChimpXMLReader& reader, Context& context);
+        void startLeaf(const ChimpXMLReader& reader, const Leaf kind, Context& context);
+        bool cookAsset(const ChimpXMLReader& reader, const char* const kind, std::map<std::string, uint32_t>& indices,
+                       std::vector<CookedAsset>& assets);
+        bool endTile();
+        bool endObject();
+        bool endLeaf();
+        bool resolve();
+        void cookSections(const int sectionWidth);
+        
+        inline bool first(uint32_t& seen, const uint32_t bit)
+        {
+            const bool unseen = !(seen & bit);
+            seen |= bit;
+            return unseen;
+        }
+        void op(const Property property, const uint32_t code, const int32_t i)
+        {
+            properties[property].push_back(CookedOp());
+            properties[property].back().code = code;
+            properties[property].back().i = i;
+        }
+        void opF(const Property property, const uint32_t code, const float f)
+        {
+            properties[property].push_back(CookedOp());
+            properties[property].back().code = code;
+            properties[property].back().f = f;
+        }
+        void opScaled(const Property property, const uint32_t code, const float value)
+        {
+            if(leafMode == "absolute")
+                opF(property, code, value);
+            else if(leafMode == "scale")
+                opF(property, code + 1, value); // every _SCALE op directly follows its absolute op
+        }
+        template<typename T> void append(std::vector<char>& blob, CookedArray& arr, const std::vector<T>& records)
+        {
+            arr.offset = blob.size();
+            arr.count = records.size();
+            blob.resize(blob.size() + records.size() * sizeof(T));
+            if(!records.empty())
+                std::memcpy(blob.data() + arr.offset, records.data(), records.size() * sizeof(T));
+        }
+    };
+    
+    bool Cooker::cook(const char* const xml, const size_t length)
+    {
+        ChimpXMLReader reader(xml, length);
+        contexts.assign(1, DOCUMENT);
+        while(true)
+        {
+            switch(reader.next())
+            {
+            case ChimpXMLReader::XML_START:
+            {
+                Context context = SKIP;
+                if(contexts.back() == LEAF)
+                    leafFirstChild = false;
+                if(!start(reader, context))
+                    return false;
+                contexts.push_back(context);
+                break;
+            }
+            case ChimpXMLReader::XML_END:
+            {
+                const Context context = contexts.back();
+                contexts.pop_back();
+                if(   (context == TILE && !endTile())
+                   || (context == OBJECT && !endObject())
+                   || (context == LEAF && !endLeaf()) )
+                    return false;
+                break;
+            }
+            case ChimpXMLReader::XML_TEXT:
+                if(contexts.back() == LEAF && leafFirstChild)
+                {
+                    leafText = reader.text();
+                    leafHasText = true;
+                }
+                // fall through
+            case ChimpXMLReader::XML_OTHER:
+                if(contexts.back() == LEAF)
+                    leafFirstChild = false;
+                break;
+            case ChimpXMLReader::XML_DONE:
+                return resolve();
+            case ChimpXMLReader::XML_ERROR:
+                std::cerr << "Error: level XML " << reader.error() << std::endl;
+                return false;
+            }
+        }
+    }
+    
+    /*
+     * Handles an element starting and sets context to how what's inside it should be read. Anything not part of a
+     * level is skipped along with its children.
+     */
+    bool Cooker::start(const ChimpXMLReader& reader, Context& context)
+    {
+        switch(contexts.back())
+        {
+        case DOCUMENT:
+            return startTop(reader, context);
+        case TILE:
+            return startTile(reader);
+        case LEVEL:
+            startLevel(reader, context);
+            break;
+        case SECTION:
+            if(reader.name() == "object")
+                startObject(reader, sections.size() - 1, context);
+            break;
+        case OBJECT:
+            startProperty(reader, context);
+            break;
+        case LEAF:
+        case SKIP:
+            break;
+        }
+        return true;
+    }
+    
+    bool Cooker::startTop(const ChimpXMLReader& reader, Context& context)
+    {
+        const std::string& name = reader.name();
+        if(name == "chimptexture")
+            return cookAsset(reader, "texture", textureIndices, textures);
+        if(name == "chimpsound")
+            return cookAsset(reader, "sound", soundIndices, sounds);
+        if(name == "chimpmusic")
+            return cookAsset(reader, "music", musicIndices, musics);
+        if(name == "chimptile")
+        {
+            const char* const tileAttr = reader.attribute("name");
+            if(!tileAttr)
+            {
+                std::cerr << "Error: chimptile tag without name attribute" << std::endl;
+                return false;
+            }
+            tileName = tileAttr;
+            tile = CookedTile();
+            stretchWidth = stretchHeight = false;
+            once = 0;
+            context = TILE;
+        }
+        else if(name == "chimplevel" && !levelRead) // only the first level counts
+        {
+            levelRead = true;
+            header.edgeLeft = 0;
+            header.edgeRight = SCREEN_WIDTH;
+            header.edgeTop = 0;
+            header.edgeBottom = SCREEN_HEIGHT;
+            header.music = COOKED_NONE;
+            header.streamDistance = STREAM_DISTANCE;
+            context = LEVEL;
+        }
+        return true;
+    }
+    
+    bool Cooker::cookAsset(const ChimpXMLReader& reader, const char* const kind,
+                           std::map<std::string, uint32_t>& indices, std::vector<CookedAsset>& assets)
+    {
+        const char* const name = reader.attribute("name");
+        const char* const file = reader.attribute("file");
+        if(!name)
+        {
+            std::cerr << "Error: " << reader.name() << " tag without name attribute" << std::endl;
+            return false;
+        }
+        if(!file)
+        {
+            std::cerr << "Error: " << reader.name() << " tag without file attribute" << std::endl;
+            return false;
+        }
+        if(indices.count(name))
+        {
+            std::cerr << "Error: more than one " << kind << " named \"" << name << "\"" << std::endl;
+            return false;
+        }
+        indices[name] = assets.size();
+        assets.push_back({intern(name), intern(file)});
+        return true;
+    }
+    
+    bool Cooker::startTile(const ChimpXMLReader& reader)
+    {
+        const std::string& name = reader.name();
+        if(name == "texture" && first(once, ONCE_TEXTURE))
+        {
+            const char* const texName = reader.attribute("name");
+            if(!texName)
+            {
+                std::cerr << "Error: chimptile texture child without name attribute" << std::endl;
+                return false;
+            }
+            tileTexture = texName;
+            const char* const required[] = { "x", "y", "width", "height" };
+            int* const values[] = { &tile.x, &tile.y, &tile.width, &tile.height };
+            for(size_t i = 0; i < 4; ++i)
+            {
+                if(!getInt(reader.attribute(required[i]), *values[i]))
+                {
+                    std::cerr << "Error: chimptile texture child without " << required[i] << " attribute"
+                              << std::endl;
+                    return false;
+                }
+            }
+        }
+        else if(name == "stretch" && first(once, ONCE_STRETCH))
+        {
+            stretchWidth = getInt(reader.attribute("width"), tile.drawWidth);
+            stretchHeight = getInt(reader.attribute("height"), tile.drawHeight);
+        }
+        else if(name == "collision" && first(once, ONCE_COLLISION))
+        {
+            getInt(reader.attribute("left"), tile.left);
+            getInt(reader.attribute("right"), tile.right);
+            getInt(reader.attribute("top"), tile.top);
+            getInt(reader.attribute("bottom"), tile.bottom);
+        }
+        return true;
+    }
+    
+    bool Cooker::endTile()
+    {
+        if(!(once & ONCE_TEXTURE))
+        {
+            std::cerr << "Error: chimptile tag without texture child" << std::endl;
+            return false;
+        }
+        if(tileIndices.count(tileName))
+        {
+            std::cerr << "Error: more than one tile named \"" << tileName << "\"" << std::endl;
+            return false;
+        }
+        if(!stretchWidth)
+            tile.drawWidth = tile.width;
+        if(!stretchHeight)
+            tile.drawHeight = tile.height;
+        tile.name = intern(tileName);
+        tile.texture = COOKED_NONE; // resolved from tileTextures
+        tileIndices[tileName] = tiles.size();
+        tiles.push_back(tile);
+        tileTextures.push_back(tileTexture);
+        return true;
+    }
+    
+    void Cooker::startLevel(const ChimpXMLReader& reader, Context& context)
+    {
+        const std::string& name = reader.name();
+        if(name == "object")
+            startObject(reader, AUTO_SECTION, context);
+        else if(name == "section")
+        {
+            CookedSection section = {INT32_MAX, INT32_MIN, 0, 0}; // bounds not given are worked out later
+            getInt(reader.attribute("left"), section.left);
+            getInt(reader.attribute("right"), section.right);
+            sections.push_back(section);
+            context = SECTION;
+        }
+        else if(name == "edges" && first(levelOnce, ONCE_EDGES))
+        {
+            getInt(reader.attribute("left"), header.edgeLeft);
+            getInt(reader.attribute("right"), header.edgeRight);
+            getInt(reader.attribute("top"), header.edgeTop);
+            getInt(reader.attribute("bottom"), header.edgeBottom);
+        }
+        else if(name == "scrollfactor" && first(levelOnce, ONCE_SCROLL))
+        {
+            if(getFloat(reader.attribute("background"), header.scrollBack))
+                header.flags |= COOKED_SCROLL_BACK;
+            if(getFloat(reader.attribute("foreground"), header.scrollFore))
+                header.flags |= COOKED_SCROLL_FORE;
+        }
+        else if(name == "music" && first(levelOnce, ONCE_MUSIC))
+            startLeaf(reader, LEAF_MUSIC, context);
+        else if(name == "activezone" && first(levelOnce, ONCE_ACTIVE_ZONE))
+            startLeaf(reader, LEAF_ACTIVE_ZONE, context);
+        else if(name == "inactivezone" && first(levelOnce, ONCE_INACTIVE_ZONE))
+            startLeaf(reader, LEAF_INACTIVE_ZONE, context);
+        else if(name == "streamdistance" && first(levelOnce, ONCE_STREAM_DISTANCE))
+            startLeaf(reader, LEAF_STREAM_DISTANCE, context);
+        else if(name == "sectionwidth" && first(levelOnce, ONCE_SECTION_WIDTH))
+            startLeaf(reader, LEAF_SECTION_WIDTH, context);
+    }
+    
+    /*
+     * Objects without a known type are skipped. Players are never put in a section.
+     */
+    void Cooker::startObject(const ChimpXMLReader& reader, const uint32_t section, Context& context)
+    {
+        const char* const type = reader.attribute("type");
+        if(!type)
+            return;
+        if(strcmp(type, "player") == 0)
+        {
+            object.type = COOKED_PLAYER;
+            objectSection = COOKED_NONE;
+        }
+        else if(strcmp(type, "character") == 0 || strcmp(type, "object") == 0)
+        {
+            object.type = type[0] == 'c' ? COOKED_CHARACTER : COOKED_OBJECT;
+            objectSection = section;
+        }
+        else
+            return;
+        
+        object.layer = getLayer(reader.attribute("layer"));
+        object.firstFrame = frames.size();
+        inSection = contexts.back() == SECTION;
+        once = 0;
+        for(std::vector<CookedOp>& property : properties)
+            property.clear();
+        context = OBJECT;
+    }
+    
+    void Cooker::startProperty(const ChimpXMLReader& reader, Context& context)
+    {
+        const std::string& name = reader.name();
+        bool tf;
+        int value;
+        
+        if(name == "tile")
+        {
+            const char* const animation = reader.attribute("animation");
+            frame.animation = COOKED_ANIM_NONE;
+            if(animation && strcmp(animation, "idle") == 0)
+                frame.animation = COOKED_ANIM_IDLE;
+            else if(animation && strcmp(animation, "run") == 0)
+                frame.animation = COOKED_ANIM_RUN;
+            else if(animation && strcmp(animation, "jump") == 0)
+                frame.animation = COOKED_ANIM_JUMP;
+            const char* const duration = reader.attribute("duration");
+            if(!duration || !tinyxml2::XMLUtil::ToUnsigned(duration, &frame.duration) || frame.duration == 0)
+                frame.duration = TIME_PER_IDLE;
+            startLeaf(reader, LEAF_TILE, context);
+        }
+        else if(name == "position" && first(once, ONCE_POSITION))
+        {
+            if(getInt(reader.attribute("x"), value))
+                op(PROP_POSITION, OP_POSITION_X, value);
+            if(getInt(reader.attribute("y"), value))
+                op(PROP_POSITION, OP_POSITION_Y, value);
+        }
+        else if(name == "tiles" && first(once, ONCE_TILES))
+        {
+            if(getInt(reader.attribute("x"), value))
+                op(PROP_TILES, OP_TILES_X, value);
+            if(getInt(reader.attribute("y"), value))
+                op(PROP_TILES, OP_TILES_Y, value);
+        }
+        else if(   (name == "damage" && first(once, ONCE_DAMAGE))
+                || (name == "bounded" && first(once, ONCE_BOUNDED)) )
+        {
+            const bool damage = name == "damage";
+            const Property property = damage ? PROP_DAMAGE : PROP_BOUNDED;
+            if(getBool(reader.attribute("left"), tf))
+                op(property, damage ? OP_DAMAGE_LEFT : OP_BOUND_LEFT, tf);
+            if(getBool(reader.attribute("right"), tf))
+                op(property, damage ? OP_DAMAGE_RIGHT : OP_BOUND_RIGHT, tf);
+            if(getBool(reader.attribute("top"), tf))
+                op(property, damage ? OP_DAMAGE_TOP : OP_BOUND_TOP, tf);
+            if(getBool(reader.attribute("bottom"), tf))
+                op(property, damage ? OP_DAMAGE_BOTTOM : OP_BOUND_BOTTOM, tf);
+        }
+        else if(name == "maxhealth" && first(once, ONCE_MAX_HEALTH))
+            startLeaf(reader, LEAF_MAX_HEALTH, context);
+        else if(name == "respawn" && first(once, ONCE_RESPAWN))
+            startLeaf(reader, LEAF_RESPAWN, context);
+        else if(name == "stopfactor" && first(once, ONCE_STOP_FACTOR))
+            startLeaf(reader, LEAF_STOP_FACTOR, context);
+        else if(name == "sprintfactor" && first(once, ONCE_SPRINT_FACTOR))
+            startLeaf(reader, LEAF_SPRINT_FACTOR, context);
+        else if(name == "maxjumps" && first(once, ONCE_MAX_JUMPS))
+            startLeaf(reader, LEAF_MAX_JUMPS, context);
+        else if(name == "faction")
+            startLeaf(reader, LEAF_FACTION, context);
+        else if(name == "acceleration")
+            startLeaf(reader, LEAF_ACCELERATION, context);
+        else if(name == "impulse")
+            startLeaf(reader, LEAF_IMPULSE, context);
+        else if(name == "resistance")
+            startLeaf(reader, LEAF_RESISTANCE, context);
+        else if(name == "script")
+            startLeaf(reader, LEAF_SCRIPT, context);
+        else if(name == "sound")
+            startLeaf(reader, LEAF_SOUND, context);
+    }
+    
+    /*
+     * The attributes a leaf needs are copied now, since only its text is left to read.
+     */
+    void Cooker::startLeaf(const ChimpXMLReader& reader, const Leaf kind, Context& context)
+    {
+        const char* const type = reader.attribute("type");
+        const char* const mode = reader.attribute("mode");
+        leaf = kind;
+        leafHasType = type;
+        leafType = type ? type : "";
+        leafMode = mode ? mode : "absolute";
+        leafHasText = false;
+        leafFirstChild = true;
+        context = LEAF;
+    }
+    
+    bool Cooker::endLeaf()
+    {
+        const char* const text = leafHasText ? leafText.c_str() : nullptr;
+        float f;
+        int value;
+        bool tf;
+        
+        switch(leaf)
+        {
+        case LEAF_MUSIC:
+            hasMusic = text;
+            musicName = leafText;
+            break;
+        case LEAF_ACTIVE_ZONE:
+            if(getInt(text, header.activeZone))
+                header.flags |= COOKED_ACTIVE_ZONE;
+            break;
+        case LEAF_INACTIVE_ZONE:
+            if(getInt(text, header.inactiveZone))
+                header.flags |= COOKED_INACTIVE_ZONE;
+            break;
+        case LEAF_STREAM_DISTANCE:
+            getInt(text, header.streamDistance);
+            break;
+        case LEAF_SECTION_WIDTH:
+            getInt(text, sectionWidth);
+            break;
+        case LEAF_TILE:
+            if(!text)
+            {
+                std::cerr << "Error: no tile named \"\" found" << std::endl;
+                return false;
+            }
+            frame.tile = COOKED_NONE; // resolved from frameTiles
+            frames.push_back(frame);
+            frameTiles.push_back(leafText);
+            break;
+        case LEAF_MAX_HEALTH:
+            if(getInt(text, value))
+                op(PROP_MAX_HEALTH, OP_MAX_HEALTH, value);
+            break;
+        case LEAF_RESPAWN:
+            if(getBool(text, tf))
+                op(PROP_RESPAWN, OP_RESPAWN, tf);
+            break;
+        case LEAF_STOP_FACTOR:
+            if(getFloat(text, f))
+                opScaled(PROP_STOP_FACTOR, OP_STOP_FACTOR, f);
+            break;
+        case LEAF_SPRINT_FACTOR:
+            if(getFloat(text, f))
+                opF(PROP_SPRINT_FACTOR, OP_SPRINT_FACTOR, f);
+            break;
+        case LEAF_MAX_JUMPS:
+            if(getInt(text, value))
+                op(PROP_MAX_JUMPS, OP_MAX_JUMPS, value);
+            break;
+        case LEAF_FACTION:
+            if(leafHasType && text)
+            {
+                Faction faction;
+                if(leafText == "player")
+                    faction = FACTION_PLAYER;
+                else if(leafText == "baddies")
+                    faction = FACTION_BADDIES;
+                else
+                    break;
+                
+                if(leafType == "friend")
+                    op(PROP_FACTION, OP_FRIEND, faction);
+                else if(leafType == "enemy")
+                    op(PROP_FACTION, OP_ENEMY, faction);
+            }
+            break;
+        case LEAF_ACCELERATION:
+            if(getFloat(text, f) && leafHasType)
+            {
+                if(leafType == "run")
+                    opScaled(PROP_ACCELERATION, OP_RUN_ACCEL, f);
+                else if(leafType == "jump")
+                    opScaled(PROP_ACCELERATION, OP_JUMP_ACCEL, f);
+            }
+            break;
+        case LEAF_IMPULSE:
+            if(getFloat(text, f) && leafHasType)
+            {
+                if(leafType == "run")
+                    opScaled(PROP_IMPULSE, OP_RUN_IMPULSE, f);
+                else if(leafType == "jump")
+                    opScaled(PROP_IMPULSE, OP_JUMP_IMPULSE, f);
+                else if(leafType == "multijump")
+                    opScaled(PROP_IMPULSE, OP_MULTIJUMP_IMPULSE, f);
+            }
+            break;
+        case LEAF_RESISTANCE:
+            if(getFloat(text, f) && leafHasType)
+            {
+                if(leafType == "run")
+                    opScaled(PROP_RESISTANCE, OP_RESISTANCE_X, f);
+                else if(leafType == "jump")
+                    opScaled(PROP_RESISTANCE, OP_RESISTANCE_Y, f);
+            }
+            break;
+        case LEAF_SCRIPT:
+            if(leafHasType && text)
+            {
+                if(leafType == "behavior")
+                    op(PROP_SCRIPT, OP_SCRIPT_BEHAVIOR, intern(leafText));
+                else if(leafType == "init")
+                    op(PROP_SCRIPT, OP_SCRIPT_INIT, intern(leafText));
+            }
+            break;
+        case LEAF_SOUND:
+            if(leafHasType && text)
+            {
+                opSounds.push_back(leafText); // has to name a sound even if the type is unknown
+                if(leafType == "jump")
+                    op(PROP_SOUND, OP_SOUND_JUMP, opSounds.size() - 1);
+                else if(leafType == "multijump")
+                    op(PROP_SOUND, OP_SOUND_MULTIJUMP, opSounds.size() - 1);
+            }
+            break;
+        }
+        return true;
+    }
+    
+    bool Cooker::endObject()
+    {
+        object.frameCount = frames.size() - object.firstFrame;
+        if(object.frameCount == 0)
+        {
+            std::cerr << "Error: object without tile child" << std::endl;
+            return false;
+        }
+        object.firstOp = ops.size();
+        for(const std::vector<CookedOp>& property : properties)
+            ops.insert(ops.end(), property.begin(), property.end());
+        object.opCount = ops.size() - object.firstOp;
+        (inSection ? sectionObjects : objects).push_back(object);
+        (inSection ? sectionObjectSections : objectSections).push_back(objectSection);
+        return true;
+    }
+    
+    /*
+     * Turns the names kept while reading into indices, then puts objects into sections.
+     */
+    bool Cooker::resolve()
+    {
+        if(!levelRead)
+        {
+            std::cerr << "Error: no chimplevel tag" << std::endl;
+            return false;
+        }
+        
+        for(size_t i = 0; i < tiles.size(); ++i)
+        {
+            auto found = textureIndices.find(tileTextures[i]);
+            if(found == textureIndices.end())
+            {
+                std::cerr << "Error: no texture named \"" << tileTextures[i] << "\" found" << std::endl;
+                return false;
+            }
+            tiles[i].texture = found->second;
+        }
+        for(size_t i = 0; i < frames.size(); ++i)
+        {
+            auto found = tileIndices.find(frameTiles[i]);
+            if(found == tileIndices.end())
+            {
+                std::cerr << "Error: no tile named \"" << frameTiles[i] << "\" found" << std::endl;
+                return false;
+            }
+            frames[i].tile = found->second;
+        }
+        std::vector<uint32_t> soundOps(opSounds.size());
+        for(size_t i = 0; i < opSounds.size(); ++i)
+        {
+            auto found = soundIndices.find(opSounds[i]);
+            if(found == soundIndices.end())
+            {
+                std::cerr << "Error: no sound named \"" << opSounds[i] << "\" found" << std::endl;
+                return false;
+            }
+            soundOps[i] = found->second;
+        }
+        for(CookedOp& cookedOp : ops)
+            if(cookedOp.code == OP_SOUND_JUMP || cookedOp.code == OP_SOUND_MULTIJUMP)
+                cookedOp.u = soundOps[cookedOp.u];
+        if(hasMusic)
+        {
+            auto found = musicIndices.find(musicName);
+            if(found == musicIndices.end())
+            {
+                std::cerr << "Error: no music named \"" << musicName << "\" found" << std::endl;
+                return false;
+            }
+            header.music = found->second;
+        }
+        
+        objects.insert(objects.end(), sectionObjects.begin(), sectionObjects.end());
+        objectSections.insert(objectSections.end(), sectionObjectSections.begin(), sectionObjectSections.end());
+        cookSections(sectionWidth);
+        return true;
+    }
+    
+    /*
+     * Puts objects outside any <section> into sectionWidth wide sections by x position, or leaves them always loaded
+     * if there's no <sectionwidth>. Sections' missing bounds are set to span their objects. Objects are then reordered
+     * so the always loaded ones come first, followed by each section's in turn. Empty sections are dropped.
+     */
+    void Cooker::cookSections(const int sectionWidth)
+    {
+        std::map<int, uint32_t> autoSections; // by x / sectionWidth
+        std::vector<int32_t> lefts(sections.size(), INT32_MAX), rights(sections.size(), INT32_MIN);
+        for(size_t i = 0; i < objects.size(); ++i)
+        {
+            int32_t x = 0, tilesX = 1;
+            for(uint32_t j = objects[i].firstOp; j < objects[i].firstOp + objects[i].opCount; ++j)
+            {
+                if(ops[j].code == OP_POSITION_X)
+                    x = ops[j].i;
+                else if(ops[j].code == OP_TILES_X)
+                    tilesX = ops[j].i;
+            }
+            
+            if(objectSections[i] == AUTO_SECTION)
+            {
+                if(sectionWidth <= 0)
+                {
+                    objectSections[i] = COOKED_NONE;
+                    continue;
+                }
+                const int bucket = x >= 0 ? x / sectionWidth : -((sectionWidth - 1 - x) / sectionWidth);
+                auto found = autoSections.find(bucket);
+                if(found == autoSections.end())
+                {
+                    sections.push_back({INT32_MAX, INT32_MIN, 0, 0});
+                    lefts.push_back(INT32_MAX);
+                    rights.push_back(INT32_MIN);
+                    found = autoSections.insert({bucket, sections.size() - 1}).first;
+                }
+                objectSections[i] = found->second;
+            }
+            else if(objectSections[i] == COOKED_NONE)
+                continue;
+            
+            const uint32_t section = objectSections[i];
+            const CookedTile& tile = tiles[frames[objects[i].firstFrame].tile];
+            lefts[section] = std::min(lefts[section], x);
+            rights[section] = std::max(rights[section], x + tile.drawWidth * tilesX);
+        }
+        for(size_t i = 0; i < sections.size(); ++i)
+        {
+            if(sections[i].left == INT32_MAX)
+                sections[i].left = lefts[i];
+            if(sections[i].right == INT32_MIN)
+                sections[i].right = rights[i];
+        }
+        
+        std::vector<uint32_t> order(objects.size());
+        for(size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        auto rank = [this](const uint32_t i) // always loaded objects first
+            { return objectSections[i] == COOKED_NONE ? 0 : uint64_t(objectSections[i]) + 1; };
+        std::stable_sort(order.begin(), order.end(), [&rank](const uint32_t a, const uint32_t b)
+                         { return rank(a) < rank(b); });
+        
+        std::vector<CookedObject> ordered;
+        std::vector<CookedSection> cooked;
+        uint32_t current = COOKED_NONE;
+        ordered.reserve(objects.size());
+        for(const uint32_t i : order)
+        {
+            const uint32_t section = objectSections[i];
+            if(section != current)
+            {
+                current = section;
+                cooked.push_back(sections[section]);
+                cooked.back().firstObject = ordered.size();
+            }
+            ordered.push_back(objects[i]);
+            if(section != COOKED_NONE)
+                ++cooked.back().objectCount;
+        }
+        objects.swap(ordered);
+        sections.swap(cooked);
+    }
+    
+    void Cooker::serialize(std::vector<char>& blob)
+    {
+        std::vector<uint32_t> nameOffsets(names.size());
+        
+        blob.assign(sizeof(CookedHeader), 0);
+        append(blob, header.textures, textures);
+        append(blob, header.sounds, sounds);
+        append(blob, header.musics, musics);
+        append(blob, header.tiles, tiles);
+        append(blob, header.frames, frames);
+        append(blob, header.objects, objects);
+        append(blob, header.ops, ops);
+        append(blob, header.sections, sections);
+        append(blob, header.names, nameOffsets); // placeholder, filled in below
+        for(size_t i = 0; i < names.size(); ++i)
+        {
+            nameOffsets[i] = blob.size();
+            blob.insert(blob.end(), names[i].c_str(), names[i].c_str() + names[i].size() + 1);
+        }
+        blob.resize((blob.size() + 3) & ~size_t(3));
+        if(!nameOffsets.empty())
+            std::memcpy(blob.data() + header.names.offset, nameOffsets.data(), nameOffsets.size() * sizeof(uint32_t));
+        
+        header.magic = COOKED_MAGIC;
+        header.version = COOKED_VERSION;
+        header.endian = COOKED_ENDIAN;
+        header.size = blob.size();
+        std::memcpy(blob.data(), &header, sizeof(header));
+    }
+} // XML to records
+
+ChimpCookedLevel::ChimpCookedLevel() : data(nullptr), size(0) {}
+
+ChimpCookedLevel::~ChimpCookedLevel()
+{
+    clear();
+}
+
+void ChimpCookedLevel::clear()
+{
+    file.close();
+    buffer.clear();
+    buffer.shrink_to_fit();
+    data = nullptr;
+    size = 0;
+}
+
+/**
+ * @brief ChimpCookedLevel::map()
+ * 
+ * Maps a cooked level file read only. Its records are used in place; nothing is parsed or copied.
+ * 
+ * @return false if the file can't be read or isn't a valid cooked level of this version.
+ */
+bool ChimpCookedLevel::map(const std::string& fileName)
+{
+    clear();
+    if(!file.open(fileName))
+    {
+        std::cerr << "Error: can't open cooked level \"" << fileName << "\"" << std::endl;
+        return false;
+    }
+    if(!use(file.data(), file.size()))
+    {
+        std::cerr << "Error: \"" << fileName << "\" isn't a valid version " << COOKED_VERSION << " cooked level"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief ChimpCookedLevel::use()
+ * 
+ * Uses a cooked level already in memory, without copying it. blob must be 4 byte aligned and outlive this.
+ * 
+ * @return false if blob isn't a valid cooked level of this version.
+ */
+bool ChimpCookedLevel::use(const char* const blob, const size_t length)
+{
+    if(blob != file.data())
+        clear();
+    data = blob;
+    size = length;
+    if(reinterpret_cast<uintptr_t>(blob) % 4 != 0 || !validate())
+    {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief ChimpCookedLevel::cook()
+ * 
+ * Cooks level XML into this, in memory, in one pass over xml. No XML document is built.
+ * 
+ * @return false if the XML isn't a valid level. Errors are reported on std::cerr.
+ */
+bool ChimpCookedLevel::cook(const char* const xml, const size_t length)
+{
+    Cooker cooker;
+    
+    clear();
+    if(!cooker.cook(xml, length))
+        return false;
+    
+    cooker.serialize(buffer);
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+}
+
+/**
+ * @brief ChimpCookedLevel::cookFile()
+ * 
+ * Maps a level XML file and cooks it into this.
+ */
+bool ChimpCookedLevel::cookFile(const std::string& fileName)
+{
+    ChimpMappedFile xml;
+    if(!xml.open(fileName))
+    {
+        std::cerr << "Error: can't open level \"" << fileName << "\"" << std::endl;
+        return false;
+    }
+    return cook(xml.data(), xml.size());
+}
+
+/**
+ * @brief ChimpCookedLevel::write()
+ * 
+ * Saves this level as a cooked level file that map() can load.
+ */
+bool ChimpCookedLevel::write(const std::string& fileName) const
+{
+    std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+    if(!data || !out.write(data, size))
+    {
+        std::cerr << "Error: can't write cooked level \"" << fileName << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief ChimpCookedLevel::isCooked()
+ * 
+ * Checks just the first bytes of a file, so loaders can tell cooked levels from XML ones.
+ */
+bool ChimpCookedLevel::isCooked(const std::string& fileName)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    char magic[sizeof(uint32_t)];
+    return in.read(magic, sizeof(magic)) && isCooked(magic, sizeof(magic));
+}
+
+bool ChimpCookedLevel::isCooked(const char* const blob, const size_t length)
+{
+    uint32_t magic;
+    if(length < sizeof(magic))
+        return false;
+    std::memcpy(&magic, blob, sizeof(magic));
+    return magic == COOKED_MAGIC;
+}
+
+/**
+ * @brief ChimpCookedLevel::listFiles()
+ * 
+ * Appends the path of every file the level loads, as the engine opens it: textures, sounds, music and scripts.
+ */
+void ChimpCookedLevel::listFiles(std::vector<std::string>& files) const
+{
+    const CookedHeader& head = header();
+    const CookedArray* const assetArrays[] = { &head.textures, &head.sounds, &head.musics };
+    for(const CookedArray* const arr : assetArrays)
+        for(uint32_t i = 0; i < arr->count; ++i)
+            files.push_back(ASSETS_PATH + name(array<CookedAsset>(*arr)[i].file));
+    
+    const CookedOp* const ops = array<CookedOp>(head.ops);
+    for(uint32_t i = 0; i < head.ops.count; ++i)
+        if(ops[i].code == OP_SCRIPT_BEHAVIOR || ops[i].code == OP_SCRIPT_INIT)
+            files.push_back(name(ops[i].u));
+}
+
+/*
+ * Bounds checks every array and every index once, so building a level from the records can trust them.
+ */
+bool ChimpCookedLevel::validate() const
+{
+    if(size < sizeof(CookedHeader))
+        return false;
+    const CookedHeader& head = header();
+    if(   head.magic != COOKED_MAGIC || head.version != COOKED_VERSION || head.endian != COOKED_ENDIAN
+       || head.size != size )
+        return false;
+    
+    auto fits = [this](const CookedArray& arr, const size_t recordSize)
+        { return arr.offset % 4 == 0 && arr.offset <= size && arr.count <= (size - arr.offset) / recordSize; };
+    if(   !fits(head.names, sizeof(uint32_t)) || !fits(head.textures, sizeof(CookedAsset))
+       || !fits(head.tiles, sizeof(CookedTile)) || !fits(head.sounds, sizeof(CookedAsset))
+       || !fits(head.musics, sizeof(CookedAsset)) || !fits(head.objects, sizeof(CookedObject))
+       || !fits(head.frames, sizeof(CookedFrame)) || !fits(head.ops, sizeof(CookedOp))
+       || !fits(head.sections, sizeof(CookedSection)) )
+        return false;
+    
+    const uint32_t* const names = array<uint32_t>(head.names);
+    for(uint32_t i = 0; i < head.names.count; ++i)
+        if(names[i] >= size || !memchr(data + names[i], '\0', size - names[i]))
+            return false;
+    auto assetsValid = [&](const CookedArray& arr)
+    {
+        const CookedAsset* const assets = array<CookedAsset>(arr);
+        for(uint32_t i = 0; i < arr.count; ++i)
+            if(assets[i].name >= head.names.count || assets[i].file >= head.names.count)
+                return false;
+        return true;
+    };
+    if(!assetsValid(head.textures) || !assetsValid(head.sounds) || !assetsValid(head.musics))
+        return false;
+    if(head.music != COOKED_NONE && head.music >= head.musics.count)
+        return false;
+    
+    const CookedTile* const tiles = array<CookedTile>(head.tiles);
+    for(uint32_t i = 0; i < head.tiles.count; ++i)
+        if(tiles[i].name >= head.names.count || tiles[i].texture >= head.textures.count)
+            return false;
+    const CookedFrame* const frames = array<CookedFrame>(head.frames);
+    for(uint32_t i = 0; i < head.frames.count; ++i)
+        if(frames[i].tile >= head.tiles.count || frames[i].animation > COOKED_ANIM_JUMP)
+            return false;
+    const CookedObject* const objects = array<CookedObject>(head.objects);
+    for(uint32_t i = 0; i < head.objects.count; ++i)
+    {
+        const CookedObject& object = objects[i];
+        if(   object.type > COOKED_OBJECT || object.layer > FORE || object.frameCount == 0
+           || object.firstFrame > head.frames.count || object.frameCount > head.frames.count - object.firstFrame
+           || object.firstOp > head.ops.count || object.opCount > head.ops.count - object.firstOp )
+            return false;
+    }
+    const CookedOp* const ops = array<CookedOp>(head.ops);
+    for(uint32_t i = 0; i < head.ops.count; ++i)
+    {
+        if(ops[i].code >= OP_COUNT)
+            return false;
+        if((ops[i].code == OP_SCRIPT_BEHAVIOR || ops[i].code == OP_SCRIPT_INIT) && ops[i].u >= head.names.count)
+            return false;
+        if((ops[i].code == OP_SOUND_JUMP || ops[i].code == OP_SOUND_MULTIJUMP) && ops[i].u >= head.sounds.count)
+            return false;
+    }
+    const CookedSection* const sections = array<CookedSection>(head.sections);
+    uint32_t sectioned = head.sections.count ? sections[0].firstObject : head.objects.count;
+    if(sectioned > head.objects.count)
+        return false;
+    for(uint32_t i = 0; i < head.sections.count; ++i) // contiguous, in order and without players
+    {
+        if(sections[i].firstObject != sectioned || sections[i].objectCount > head.objects.count - sectioned)
+            return false;
+        for(uint32_t j = sectioned; j < sectioned + sections[i].objectCount; ++j)
+            if(objects[j].type == COOKED_PLAYER)
+                return false;
+        sectioned += sections[i].objectCount;
+    }
+    return sectioned == head.objects.count;
+}
+
+} // namespace chimp
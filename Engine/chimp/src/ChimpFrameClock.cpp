@@ -0,0 +1,82 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpFrameClock.h"
+#include "ChimpConstants.h"
+
+#include <algorithm>
+
+namespace chimp
+{
+
+/**
+ * @brief ChimpFrameClock::ChimpFrameClock()
+ * @param rate Frames per second limit() holds to. 0 doesn't limit.
+ */
+ChimpFrameClock::ChimpFrameClock(const double rate)
+    : countsPerMs(SDL_GetPerformanceFrequency() / 1000.0), last(SDL_GetPerformanceCounter()), interval(0)
+{
+    setRate(rate);
+}
+
+void ChimpFrameClock::setRate(const double rate)
+{
+    interval = rate > 0 ? static_cast<Uint64>(countsPerMs * 1000.0 / rate) : 0;
+}
+
+/**
+ * @brief ChimpFrameClock::tick()
+ * 
+ * Starts a new frame.
+ * 
+ * @return Milliseconds since the last tick() or restart().
+ */
+double ChimpFrameClock::tick()
+{
+    const Uint64 now = SDL_GetPerformanceCounter();
+    const double elapsed = (now - last) / countsPerMs;
+    last = now;
+    return elapsed;
+}
+
+/**
+ * @brief ChimpFrameClock::limit()
+ * 
+ * Waits until the current frame has lasted a whole frame interval. Returns right away if unlimited or already late.
+ * Sleeps, then spins through the last FRAME_SPIN_TIME ms, or the last quarter of the interval if that's shorter.
+ */
+void ChimpFrameClock::limit() const
+{
+    if(!interval)
+        return;
+    const Uint64 due = last + interval;
+    // short intervals still sleep for most of the frame instead of spinning through it
+    const Uint64 spin = std::min<Uint64>(static_cast<Uint64>(FRAME_SPIN_TIME * countsPerMs), interval / 4);
+    Uint64 now = SDL_GetPerformanceCounter();
+    while(now + spin < due)
+    {
+        const Uint32 sleep = static_cast<Uint32>((due - spin - now) / countsPerMs);
+        SDL_Delay(sleep > 0 ? sleep : 1);
+        now = SDL_GetPerformanceCounter();
+    }
+    while(now < due)
+        now = SDL_GetPerformanceCounter();
+}
+
+} // namespace chimp
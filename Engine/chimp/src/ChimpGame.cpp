@@ -18,15 +18,14 @@
 */
 
 #include "ChimpGame.h"
+#include "ChimpAssetPack.h"
+#include "ChimpCookedLevel.h"
+#include "ChimpProfiler.h"
+#include "ChimpStartupTrace.h"
 
-#if defined (__gnu_linux__) || defined (_WIN32)
-#include <SDL2/SDL_image.h>
-#endif
-#if defined (__APPLE__) && defined (__MACH__)
-#include <SDL2_image/SDL_image.h>
-#endif
-
+#include <algorithm>
 #include <iostream>
+#include <unordered_set>
 #include "ChimpLuaInterface.h"
 
 namespace chimp
@@ -36,57 +35,10 @@ ChimpGame* ChimpGame::self;
 ChimpObject* ChimpGame::currentObj;
 ChimpCharacter* ChimpGame::player;
 
-namespace // helper functions for level loading
-{
-    bool getString(const char* const cStr, std::string& str)
-    {
-        if(cStr)
-        {
-            str = cStr;
-            return true;
-        }
-        return false;
-    }
-    
-    Layer getLayer(const tinyxml2::XMLElement *objXML)
-    {
-        std::string layer;
-        if(getString(objXML->Attribute("layer"), layer))
-        {
-            if(layer == "background")
-                return BACK;
-            else if(layer == "foreground")
-                return FORE;
-        }
-        return MID;
-    }
-    
-    bool getBool(const char* const boolStr, bool& result)
-    {
-        if(!boolStr)
-            return false;
-        if(strcmp(boolStr, "true") == 0)
-        {
-            result = true;
-            return true;
-        }
-        if(strcmp(boolStr, "false") == 0)
-        {
-            result = false;
-            return true;
-        }
-        return false;
-    }
-    
-    std::string getMode(const tinyxml2::XMLElement* const tag)
-    {
-        std::string mode;
-        return getString(tag->Attribute("mode"), mode) ? mode : "absolute";
-    }
-} // helper functions for level loading
-
-ChimpGame::ChimpGame(SDL_Renderer* const rend, const int width, const int height,
-                     ChimpCharacter* plyr) : renderer(rend), viewWidth(width), viewHeight(height)
+ChimpGame::ChimpGame(SDL_Renderer* const rend, const int width, const int height, ChimpJobSystem& jobSystem,
+                     ChimpCharacter* plyr) : renderer(rend), jobs(jobSystem), sectionTasks(jobSystem),
+                                             audio(AUDIO_VOICES, AUDIO_QUEUE_SIZE), viewWidth(width),
+                                             viewHeight(height)
 {
     player = plyr;
     scroll_factor_back = 1.0;
@@ -97,18 +49,19 @@ ChimpGame::ChimpGame(SDL_Renderer* const rend, const int width, const int height
     setupLua(luast);
     self = this;
     music = nullptr;
+    streamDistance = STREAM_DISTANCE;
+    synchronousStreaming = false;
+    timerTime = 0;
 }
 
 ChimpGame::~ChimpGame()
 {
+    if(preloader.joinable())
+        preloader.join();
+    sectionTasks.wait(); // sections may still be building
     if(player)
         delete player;
-    for(auto& tex : textures)
-        SDL_DestroyTexture(tex.second);
-    for(auto& snd : sounds)
-        Mix_FreeChunk(snd.second);
-    for(auto& mus : musics)
-        Mix_FreeMusic(mus.second);
+    // Textures, sounds and music are freed by assetCache.
 }
 
 ChimpObject& ChimpGame::getObj(Layer lay, size_t index)
@@ -210,19 +163,30 @@ bool ChimpGame::setInactiveZone(const int zone)
     return true;
 }
 
-bool ChimpGame::setMusic(const std::string& mus)
+/**
+ * @brief ChimpGame::setMusic()
+ * 
+ * Chooses the music playMusic() plays. Doesn't start it.
+ * 
+ * @param id Music ID, or ASSET_NONE for silence.
+ * @return false if there's no music with that ID, in which case nothing changes.
+ */
+bool ChimpGame::setMusic(const AssetId id)
 {
-    if(mus == "")
+    if(id == ASSET_NONE)
     {
         music = nullptr;
         return true;
     }
-    else if(musics.find(mus) != musics.end())
-    {
-        music = musics[mus];
-        return true;
-    }
-    return false;
+    if(id >= musics.size())
+        return false;
+    music = musics[id];
+    return true;
+}
+
+void ChimpGame::playMusic()
+{
+    audio.playMusic(music);
 }
 
 void ChimpGame::pushObj(const Layer layr, const ChimpTile& til, const int x, const int y, const int tilesX,
@@ -257,23 +221,23 @@ void ChimpGame::pushMob(const Layer layr, const ChimpTile &til, const int x, con
     }
 }
 
-void ChimpGame::pushChar(const Layer lay, const TileVec &tilRn, const TileVec &tilJmp, TileVec &tilIdl, const int x,
+void ChimpGame::pushChar(const Layer lay, const ClipId clpRn, const ClipId clpJmp, const ClipId clpIdl, const int x,
                          const int y, const int tilesX, const int tilesY, const int maxH, const Faction frnds,
                          const Faction enms)
 {
     switch(lay)
     {
     case BACK:
-        background.push_back(std::unique_ptr<ChimpCharacter>(
-            new ChimpCharacter(renderer, tilRn, tilJmp, tilIdl, x, y, tilesX, tilesY, frnds, enms, maxH) ));
+        background.push_back(std::unique_ptr<ChimpCharacter>( new ChimpCharacter(
+            renderer, animations, clpRn, clpJmp, clpIdl, x, y, tilesX, tilesY, frnds, enms, maxH) ));
         break;
     case MID:
-        middle.push_back(std::unique_ptr<ChimpCharacter>(
-            new ChimpCharacter(renderer, tilRn, tilJmp, tilIdl, x, y, tilesX, tilesY, frnds, enms, maxH) ));
+        middle.push_back(std::unique_ptr<ChimpCharacter>( new ChimpCharacter(
+            renderer, animations, clpRn, clpJmp, clpIdl, x, y, tilesX, tilesY, frnds, enms, maxH) ));
         break;
     case FORE:
-        foreground.push_back(std::unique_ptr<ChimpCharacter>(
-            new ChimpCharacter(renderer, tilRn, tilJmp, tilIdl, x, y, tilesX, tilesY, frnds, enms, maxH) ));
+        foreground.push_back(std::unique_ptr<ChimpCharacter>( new ChimpCharacter(
+            renderer, animations, clpRn, clpJmp, clpIdl, x, y, tilesX, tilesY, frnds, enms, maxH) ));
         break;
     }
 }
@@ -281,8 +245,12 @@ void ChimpGame::pushChar(const Layer lay, const TileVec &tilRn, const TileVec &t
 void ChimpGame::pushChar(const Layer lay, const ChimpTile &til, const int x, const int y, const int tilesX,
                          const int tilesY, const int maxH, const Faction frnds, const Faction enms)
 {
-    TileVec tVec = {til};
-    pushChar(lay, tVec, tVec, tVec, x, y, tilesX, tilesY, maxH, frnds, enms);
+    AnimationClip idle, run, jump;
+    ClipId idleclip, runclip, jumpclip;
+    idle.frames.push_back(&til);
+    idle.durations.push_back(TIME_PER_IDLE);
+    addClips(idle, run, jump, idleclip, runclip, jumpclip);
+    pushChar(lay, runclip, jumpclip, idleclip, x, y, tilesX, tilesY, maxH, frnds, enms);
 }
 
 void ChimpGame::translateWindowX(const int x)
@@ -343,6 +311,7 @@ void ChimpGame::initialize()
     midView.b = viewHeight;
     backView = midView;
     foreView = midView;
+    streamSections(true, false);
     
     for(auto& obj : background)
         obj->initialize(*this);
@@ -353,27 +322,47 @@ void ChimpGame::initialize()
     player->initialize(*this);
     
     if(music)
-        Mix_PlayMusic(music, -1);
+        playMusic();
 }
 
-void ChimpGame::update(Uint32 time)
+void ChimpGame::update(double time)
 {
     if(time > MAX_FRAME_TIME) // Weird things happen when time is too high.
         time = MAX_FRAME_TIME;
     
-    static Uint32 accelTime = 0;
+    static double accelTime = 0;
     
-    for(auto& obj : background)
-        obj->update(background, *this, time);
-    for(auto& obj : middle)
-        obj->update(middle, *this, time);
-    player->update(middle, *this, time);
-    for(auto& obj : foreground)
-        obj->update(foreground, *this, time);
+    timerTime += time;
+    const Uint32 timerMs = static_cast<Uint32>(timerTime);
+    timerTime -= timerMs;
+    timers.advance(timerMs);
+    
+    if(!sections.empty())
+    {
+        ChimpProfileZone zone("stream sections");
+        streamSections(synchronousStreaming, true);
+    }
+    {
+        ChimpProfileZone zone("update background");
+        for(auto& obj : background)
+            obj->update(background, *this, time);
+    }
+    {
+        ChimpProfileZone zone("update middle");
+        for(auto& obj : middle)
+            obj->update(middle, *this, time);
+        player->update(middle, *this, time);
+    }
+    {
+        ChimpProfileZone zone("update foreground");
+        for(auto& obj : foreground)
+            obj->update(foreground, *this, time);
+    }
     
     accelTime += time;
     if(accelTime >= MS_PER_ACCEL)
     {
+        ChimpProfileZone zone("accelerate");
         accelTime -= MS_PER_ACCEL;
         for(auto& obj : background)
             obj->accelerate();
@@ -396,17 +385,65 @@ void ChimpGame::update(Uint32 time)
 
 void ChimpGame::render()
 {
-    for(auto& obj : background)
-        obj->render(backView);
-    for(auto& obj : middle)
-        obj->render(midView);
-    player->render(midView);
+    {
+        ChimpProfileZone zone("render background");
+        for(auto& obj : background)
+            obj->render(backView);
+    }
+    {
+        ChimpProfileZone zone("render middle");
+        for(auto& obj : middle)
+            obj->render(midView);
+        player->render(midView);
+    }
+    ChimpProfileZone zone("render foreground");
     for(auto& obj : foreground)
         obj->render(foreView);
 }
 
+/**
+ * @brief ChimpGame::record()
+ * 
+ * Records the current frame into a render packet, in the same order render() would draw it, so it can be submitted
+ * later from the render thread.
+ * 
+ * @param packet Render packet being built for the next frame.
+ */
+void ChimpGame::record(ChimpRenderPacket& packet)
+{
+    {
+        ChimpProfileZone zone("record background");
+        for(auto& obj : background)
+            obj->record(backView, packet);
+        packet.backgroundEnd = packet.draws.size();
+    }
+    {
+        ChimpProfileZone zone("record middle");
+        for(auto& obj : middle)
+            obj->record(midView, packet);
+        player->record(midView, packet);
+        packet.middleEnd = packet.draws.size();
+    }
+    {
+        ChimpProfileZone zone("record foreground");
+        for(auto& obj : foreground)
+            obj->record(foreView, packet);
+    }
+    packet.health = player->getHealth();
+    packet.gameOver = !player->isActive();
+}
+
 void ChimpGame::reset()
 {
+    sectionTasks.wait();
+    for(auto& section : sections) // sections come back as the level file has them
+    {
+        if(section->state == SECTION_LOADED)
+            unloadSection(*section, false);
+        section->built.clear();
+        section->saved.clear();
+        section->state = SECTION_UNLOADED;
+    }
     for(auto& obj : background)
         obj->reset();
     for(auto& obj : middle)
@@ -418,516 +455,688 @@ void ChimpGame::reset()
     initialize();
 }
 
+/**
+ * @brief ChimpGame::loadLevel()
+ * 
+ * Loads either a level XML file or a cooked level (see ChimpCookedLevel), from the asset pack if it's in there. XML is
+ * cooked in memory first, so both end up in buildLevel(). Only for the first level; use changeLevel() after that.
+ * Same as openLevel(), decodeOpenedLevel() and buildOpenedLevel() one after another.
+ */
 tinyxml2::XMLError ChimpGame::loadLevel(const std::string& levelFile)
 {
-    tinyxml2::XMLDocument levelXML;
-    tinyxml2::XMLError loadFileResult;
-    tinyxml2::XMLNode* level;
-    tinyxml2::XMLElement* objXML;
-    tinyxml2::XMLElement* tag;
+    const tinyxml2::XMLError result = openLevel(levelFile);
+    if(result != tinyxml2::XML_SUCCESS)
+        return result;
+    decodeOpenedLevel();
+    return buildOpenedLevel();
+}
+
+/**
+ * @brief ChimpGame::openLevel()
+ * 
+ * First step of loadLevel(): reads the level and queues its assets. Doesn't touch SDL or the renderer, so it can run
+ * on another thread while the rest of the engine starts up.
+ */
+tinyxml2::XMLError ChimpGame::openLevel(const std::string& levelFile)
+{
+    openedLevel = prepareLevel(levelFile, false);
+    return openedLevel->result;
+}
+
+/**
+ * @brief ChimpGame::decodeOpenedLevel()
+ * 
+ * Second step of loadLevel(): decodes the opened level's assets. Can run on any thread, but needs SDL_image and the
+ * audio device initialized, since sounds are converted to the device's format.
+ */
+void ChimpGame::decodeOpenedLevel()
+{
+    if(!openedLevel)
+        return;
+    ChimpTraceScope trace("level", "decode assets");
+    openedLevel->loader.decode();
+}
+
+/**
+ * @brief ChimpGame::buildOpenedLevel()
+ * 
+ * Last step of loadLevel(): creates textures, tiles and objects. Must be called from the thread owning the renderer.
+ */
+tinyxml2::XMLError ChimpGame::buildOpenedLevel()
+{
+    std::unique_ptr<PreparedLevel> prepared = std::move(openedLevel);
+    if(!prepared || prepared->result != tinyxml2::XML_SUCCESS)
+        return prepared ? prepared->result : tinyxml2::XML_ERROR_FILE_NOT_FOUND;
+    ChimpTraceScope trace("level", "build level");
+    if(!buildLevel(prepared->level, prepared->loader))
+        return tinyxml2::XML_NO_TEXT_NODE;
+    currentLevel = std::move(prepared);
+    return tinyxml2::XML_SUCCESS;
+}
+
+/**
+ * @brief ChimpGame::preloadLevel()
+ * 
+ * Starts reading a level and decoding whichever of its assets aren't cached yet on a background thread, so a later
+ * changeLevel() to the same file only has to create textures and objects. Preloading another level drops this one.
+ */
+void ChimpGame::preloadLevel(const std::string& levelFile)
+{
+    if(levelFile == preloadFile)
+        return;
+    if(preloader.joinable())
+        preloader.join();
+    preloaded.reset();
+    preloadFile = levelFile;
+    preloader = std::thread([this, levelFile] { preloaded = prepareLevel(levelFile); });
+}
+
+/**
+ * @brief ChimpGame::switchLevel()
+ * 
+ * Replaces the current level with the one passed to changeLevel(). Must be called between frames, from the thread
+ * owning the renderer, since objects are destroyed and textures created. The new level's assets are acquired from the
+ * cache before the old level's are released, so assets both levels use stay loaded. Starts the new level like
+ * initialize().
+ * 
+ * @return Anything but XML_SUCCESS means the new level couldn't be read or built. If it couldn't be read, the old
+ * level is kept and goes on; if it was read but couldn't be built, the old level has already been unloaded.
+ */
+tinyxml2::XMLError ChimpGame::switchLevel()
+{
+    const std::string levelFile = pendingLevel;
+    pendingLevel.clear();
     
-    loadFileResult = levelXML.LoadFile(levelFile.c_str());
-    if(loadFileResult != tinyxml2::XML_SUCCESS)
-        return loadFileResult;
-    level = levelXML.FirstChildElement("chimplevel");
-    if(!level)
-        return tinyxml2::XML_ERROR_FILE_READ_ERROR;
+    if(preloader.joinable())
+        preloader.join();
+    std::unique_ptr<PreparedLevel> prepared = levelFile == preloadFile ? std::move(preloaded)
+                                                                         : prepareLevel(levelFile);
+    preloaded.reset();
+    preloadFile.clear();
+    if(prepared->result != tinyxml2::XML_SUCCESS)
+        return prepared->result;
     
-    if(   !loadTextures(levelXML, textures, renderer)
-       || !loadTiles(levelXML, textures, tiles)
-       || !loadSounds(levelXML, sounds, musics) )
+    unloadLevel();
+    std::vector<ChimpAssetKey> previous;
+    previous.swap(levelAssets);
+    const bool built = buildLevel(prepared->level, prepared->loader);
+    for(const ChimpAssetKey& key : previous)
+        assetCache.release(key);
+    if(!built)
         return tinyxml2::XML_NO_TEXT_NODE;
+    currentLevel = std::move(prepared);
     
-    loadWorldBox(level->FirstChildElement("edges"));
-    if( (tag = level->FirstChildElement("scrollfactor")) )
-    {
-        float factor;
-        if(tag->QueryFloatAttribute("background", &factor) == tinyxml2::XML_SUCCESS)
-            setScrollFactor(BACK, factor);
-        if(tag->QueryFloatAttribute("foreground", &factor) == tinyxml2::XML_SUCCESS)
-            setScrollFactor(FORE, factor);
-    }
-    if( (tag = level->FirstChildElement("music")) )
-    {
-        std::string name;
-        if(getString(tag->GetText(), name))
-            setMusic(name);
-    }
-    if( (tag = level->FirstChildElement("activezone")) )
-    {
-        int zone;
-        if(tag->QueryIntText(&zone) == tinyxml2::XML_SUCCESS)
-            setActiveZone(zone);
-    }
-    if( (tag = level->FirstChildElement("inactivezone")) )
+    initialize();
+    return tinyxml2::XML_SUCCESS;
+}
+
+/**
+ * @brief ChimpGame::prepareLevel()
+ * 
+ * Reads a level and decodes its assets. Doesn't touch the renderer or the current level, so runs on any thread.
+ * 
+ * @param decode If false, the assets are only queued in the loader.
+ */
+std::unique_ptr<ChimpGame::PreparedLevel> ChimpGame::prepareLevel(const std::string& levelFile, const bool decode)
+{
+    std::unique_ptr<PreparedLevel> prepared(new PreparedLevel(jobs, assetCache));
+    prepared->file = levelFile;
     {
-        int zone;
-        if(tag->QueryIntText(&zone) == tinyxml2::XML_SUCCESS)
-            setInactiveZone(zone);
+        ChimpTraceScope trace("level", "read level");
+        prepared->result = readLevel(levelFile, prepared->level);
     }
+    if(prepared->result != tinyxml2::XML_SUCCESS)
+        return prepared;
     
-    for( objXML = level->FirstChildElement("object"); objXML; objXML = objXML->NextSiblingElement("object") )
+    const ChimpCookedLevel& level = prepared->level;
+    const CookedHeader& head = level.header();
+    const CookedAsset* const texs = level.array<CookedAsset>(head.textures);
+    const CookedAsset* const snds = level.array<CookedAsset>(head.sounds);
+    const CookedAsset* const muss = level.array<CookedAsset>(head.musics);
+    for(uint32_t i = 0; i < head.textures.count; ++i)
+        prepared->loader.addTexture(level.name(texs[i].name), ASSETS_PATH + level.name(texs[i].file));
+    for(uint32_t i = 0; i < head.sounds.count; ++i)
+        prepared->loader.addSound(level.name(snds[i].name), ASSETS_PATH + level.name(snds[i].file));
+    for(uint32_t i = 0; i < head.musics.count; ++i)
+        prepared->loader.addMusic(level.name(muss[i].name), ASSETS_PATH + level.name(muss[i].file));
+    if(decode)
     {
-        std::string type;
-        if(getString(objXML->Attribute("type"), type))
-        {
-            if(type == "player")
-            {
-                TileVec runtiles, jumptiles, idletiles;
-                if(loadAllAnimations(objXML, idletiles, runtiles, jumptiles, tiles))
-                {
-                    player = new ChimpCharacter(renderer, runtiles, jumptiles, idletiles);
-                    loadObject(objXML, *player);
-                }
-            }
-            else if(type == "character")
-            {
-                TileVec runtiles, jumptiles, idletiles;
-                std::string tile;
-                if(loadAllAnimations(objXML, idletiles, runtiles, jumptiles, tiles))
-                {
-                    Layer layer = getLayer(objXML);
-                    pushChar(layer, runtiles, jumptiles, idletiles);
-                    loadObject(objXML, getObjBack(layer));
-                }
-                else if(getString(objXML->FirstChildElement("tile")->GetText(), tile))
-                {
-                    Layer layer = getLayer(objXML);
-                    pushChar(layer, tiles[tile]);
-                    loadObject(objXML, getObjBack(layer));
-                }
-            }
-            else if(type == "object")
-            {
-                std::string tile;
-                if(getString(objXML->FirstChildElement("tile")->GetText(), tile))
-                {
-                    Layer layer = getLayer(objXML);
-                    pushObj(layer, tiles[tile]);
-                    loadObject(objXML, getObjBack(layer));
-                }   
-            }
-        }
+        ChimpTraceScope trace("level", "decode assets");
+        prepared->loader.decode();
     }
-    
-    return tinyxml2::XML_SUCCESS;
+    return prepared;
 }
 
-void ChimpGame::loadWorldBox(const tinyxml2::XMLElement* const edges)
+/**
+ * @brief ChimpGame::readLevel()
+ * 
+ * Reads a cooked level, or cooks a level XML file into level. XML is cooked straight from the mapped file or the asset
+ * pack, without building a document.
+ */
+tinyxml2::XMLError ChimpGame::readLevel(const std::string& levelFile, ChimpCookedLevel& level)
 {
-    int wbLeft = 0;
-    int wbRight = SCREEN_WIDTH;
-    int wbTop = 0;
-    int wbBottom = SCREEN_HEIGHT;
-    if(edges)
+    const char* packed;
+    size_t packedSize;
+    
+    if(ChimpAssetPack::getPack().find(levelFile, packed, packedSize))
     {
-        int val;
-        if(edges->QueryIntAttribute("left", &val) == tinyxml2::XML_SUCCESS)
-            wbLeft = val;
-        if(edges->QueryIntAttribute("right", &val) == tinyxml2::XML_SUCCESS)
-            wbRight = val;
-        if(edges->QueryIntAttribute("top", &val) == tinyxml2::XML_SUCCESS)
-            wbTop = val;
-        if(edges->QueryIntAttribute("bottom", &val) == tinyxml2::XML_SUCCESS)
-            wbBottom = val;
+        if(ChimpCookedLevel::isCooked(packed, packedSize))
+            return level.use(packed, packedSize) ? tinyxml2::XML_SUCCESS : tinyxml2::XML_ERROR_FILE_READ_ERROR;
+        return level.cook(packed, packedSize) ? tinyxml2::XML_SUCCESS : tinyxml2::XML_NO_TEXT_NODE;
     }
-    setWorldBox(wbLeft, wbRight, wbTop, wbBottom);
-}
-
-bool ChimpGame::loadAllAnimations(tinyxml2::XMLElement* const objXML, TileVec& idletiles, TileVec& runtiles,
-                                  TileVec& jumptiles, TileMap& tiles)
-{
-    loadAnimation(objXML, "idle", idletiles, tiles);
-    if(idletiles.empty())
-        return false;
-    loadAnimation(objXML, "run", runtiles, tiles);
-    if(runtiles.empty())
-        runtiles = idletiles;
-    loadAnimation(objXML, "jump", jumptiles, tiles);
-    if(jumptiles.empty())
-        jumptiles = idletiles;
-    return true;
+    if(ChimpCookedLevel::isCooked(levelFile))
+        return level.map(levelFile) ? tinyxml2::XML_SUCCESS : tinyxml2::XML_ERROR_FILE_READ_ERROR;
+    
+    ChimpMappedFile levelXML;
+    if(!levelXML.open(levelFile))
+        return tinyxml2::XML_ERROR_FILE_NOT_FOUND;
+    return level.cook(levelXML.data(), levelXML.size()) ? tinyxml2::XML_SUCCESS : tinyxml2::XML_NO_TEXT_NODE;
 }
 
-void ChimpGame::loadAnimation(tinyxml2::XMLElement* const objXML, std::string anim, TileVec& tilvec, TileMap& tiles)
+/**
+ * @brief ChimpGame::unloadLevel()
+ * 
+ * Destroys the current level's objects, sections, tiles and clips and puts level settings back to their defaults. Its
+ * assets stay in the cache until levelAssets is released.
+ */
+void ChimpGame::unloadLevel()
 {
-    std::string animation;
-    for( tinyxml2::XMLElement* tag = objXML->FirstChildElement("tile"); tag; tag = tag->NextSiblingElement("tile") )
-        if(getString(tag->Attribute("animation"), animation) && anim == animation)
-            tilvec.push_back( tiles[tag->GetText()] );
+    sectionTasks.wait();
+    sections.clear();
+    objectClips.clear();
+    currentLevel.reset();
+    audio.halt();
+    audio.wait(); // the level's sounds and music are freed once levelAssets is released
+    music = nullptr;
+    currentObj = nullptr;
+    timers.clear();
+    background.clear();
+    middle.clear();
+    foreground.clear();
+    if(player)
+        delete player;
+    player = nullptr;
+    tiles.clear();
+    animations.clear();
+    textures.clear();
+    sounds.clear();
+    musics.clear();
+    textureNames.clear();
+    tileNames.clear();
+    soundNames.clear();
+    musicNames.clear();
+    assetTimings.clear();
+    scroll_factor_back = 1.0;
+    scroll_factor_fore = 1.0;
+    activeZone = ACTIVE_ZONE;
+    inactiveZone = INACTIVE_ZONE;
+    streamDistance = STREAM_DISTANCE;
 }
 
-void ChimpGame::loadObject(tinyxml2::XMLElement* const objXML, ChimpObject& obj)
+/**
+ * @brief ChimpGame::buildLevel()
+ * 
+ * Finishes loading a level's assets and creates its tiles and the objects that are always loaded. An asset's ID is its
+ * index in the cooked level, and records refer to each other by index, so nothing is looked up by name; names are
+ * only interned so scripts can resolve them to IDs. Every clip is registered here, so building sections later never
+ * changes the animation registry.
+ * 
+ * @param loader Holds the level's assets, queued in the order they're listed and already decoded.
+ */
+bool ChimpGame::buildLevel(const ChimpCookedLevel& level, ChimpAssetLoader& loader)
 {
-    tinyxml2::XMLElement* tag;
+    const CookedHeader& head = level.header();
+    const CookedAsset* const texs = level.array<CookedAsset>(head.textures);
+    const CookedAsset* const snds = level.array<CookedAsset>(head.sounds);
+    const CookedAsset* const muss = level.array<CookedAsset>(head.musics);
+    const CookedTile* const tils = level.array<CookedTile>(head.tiles);
+    const CookedObject* const objects = level.array<CookedObject>(head.objects);
+    const CookedFrame* const frames = level.array<CookedFrame>(head.frames);
+    const CookedOp* const ops = level.array<CookedOp>(head.ops);
+    const CookedSection* const sects = level.array<CookedSection>(head.sections);
+    
+    if(!loader.upload(renderer, textures, sounds, musics, levelAssets, assetTimings))
+        return false;
     
-    if( (tag = objXML->FirstChildElement("position")) )
+    for(uint32_t i = 0; i < head.textures.count; ++i)
+        textureNames.intern(level.name(texs[i].name));
+    for(uint32_t i = 0; i < head.sounds.count; ++i)
+        soundNames.intern(level.name(snds[i].name));
+    for(uint32_t i = 0; i < head.musics.count; ++i)
+        musicNames.intern(level.name(muss[i].name));
+    tiles.reserve(head.tiles.count);
+    for(uint32_t i = 0; i < head.tiles.count; ++i)
     {
-        int pos;
-        if(tag->QueryIntAttribute("x", &pos) == tinyxml2::XML_SUCCESS)
-            obj.setInitialX(pos);
-        if(tag->QueryIntAttribute("y", &pos) == tinyxml2::XML_SUCCESS)
-            obj.setInitialY(SCREEN_HEIGHT - pos - obj.getHeight());
+        const CookedTile& tile = tils[i];
+        IntBox colBox = {tile.left, tile.right, tile.top, tile.bottom};
+        SDL_Rect texRect = {tile.x, tile.y, tile.width, tile.height};
+        SDL_Rect drRect = {0, 0, tile.drawWidth, tile.drawHeight};
+        tiles.emplace_back(textures[tile.texture], texRect, drRect, colBox);
+        tileNames.intern(level.name(tile.name));
     }
-    if( (tag = objXML->FirstChildElement("tiles")) )
+    if(   textureNames.size() != textures.size() || tileNames.size() != tiles.size()
+       || soundNames.size() != sounds.size() || musicNames.size() != musics.size() )
     {
-        int tiles;
-        if(tag->QueryIntAttribute("x", &tiles) == tinyxml2::XML_SUCCESS)
-            obj.setTilesX(tiles);
-        if(tag->QueryIntAttribute("y", &tiles) == tinyxml2::XML_SUCCESS)
-            obj.setTilesY(tiles);
+        std::cerr << "Error: level has two assets of the same kind with the same name" << std::endl;
+        return false;
     }
-    if( (tag = objXML->FirstChildElement("maxhealth")) )
+    
+    setWorldBox(head.edgeLeft, head.edgeRight, head.edgeTop, head.edgeBottom);
+    if(head.flags & COOKED_SCROLL_BACK)
+        setScrollFactor(BACK, head.scrollBack);
+    if(head.flags & COOKED_SCROLL_FORE)
+        setScrollFactor(FORE, head.scrollFore);
+    if(head.music != COOKED_NONE)
+        setMusic(head.music);
+    if(head.flags & COOKED_ACTIVE_ZONE)
+        setActiveZone(head.activeZone);
+    if(head.flags & COOKED_INACTIVE_ZONE)
+        setInactiveZone(head.inactiveZone);
+    streamDistance = head.streamDistance;
+    
+    objectClips.assign(head.objects.count, ObjectClips());
+    for(uint32_t i = 0; i < head.objects.count; ++i)
     {
-        int health;
-        if(tag->QueryIntText(&health) == tinyxml2::XML_SUCCESS)
+        const CookedObject& object = objects[i];
+        ObjectClips& clips = objectClips[i];
+        if(object.type == COOKED_OBJECT)
+            continue;
+        clips.animated = buildClips(frames + object.firstFrame, object.frameCount, clips.idle, clips.run, clips.jump);
+        if(!clips.animated && object.type != COOKED_PLAYER)
         {
-            obj.setMaxHealth(health);
+            AnimationClip idle, run, jump;
+            idle.frames.push_back(&tiles[frames[object.firstFrame].tile]);
+            idle.durations.push_back(TIME_PER_IDLE);
+            addClips(idle, run, jump, clips.idle, clips.run, clips.jump);
         }
     }
-    if( (tag = objXML->FirstChildElement("respawn")) )
-    {
-        bool respawn;
-        if(getBool(tag->GetText(), respawn))
-            obj.setRespawn(respawn);
-    }
-    if( (tag = objXML->FirstChildElement("damage")) )
-    {
-        bool tf;
-        if(getBool(tag->Attribute("left"), tf))
-            obj.setDamageLeft(tf);
-        if(getBool(tag->Attribute("right"), tf))
-            obj.setDamageRight(tf);
-        if(getBool(tag->Attribute("top"), tf))
-            obj.setDamageTop(tf);
-        if(getBool(tag->Attribute("bottom"), tf))
-            obj.setDamageBottom(tf);
-    }
-    if( (tag = objXML->FirstChildElement("bounded")) )
-    {
-        bool tf;
-        if(getBool(tag->Attribute("left"), tf))
-            obj.setBoundLeft(tf);
-        if(getBool(tag->Attribute("right"), tf))
-            obj.setBoundRight(tf);
-        if(getBool(tag->Attribute("top"), tf))
-            obj.setBoundTop(tf);
-        if(getBool(tag->Attribute("bottom"), tf))
-            obj.setBoundBottom(tf);
-    }
-    if( (tag = objXML->FirstChildElement("stopfactor")) )
-    {
-        float factor;
-        std::string mode;
-        if(tag->QueryFloatText(&factor) == tinyxml2::XML_SUCCESS)
+    
+    const uint32_t alwaysLoaded = head.sections.count ? sects[0].firstObject : head.objects.count;
+    for(uint32_t i = 0; i < alwaysLoaded; ++i)
+    {
+        ChimpTraceScope trace("object", "object", i);
+        const CookedObject& object = objects[i];
+        if(object.type != COOKED_PLAYER)
+            getLayer(static_cast<Layer>(object.layer)).push_back(buildObject(level, i));
+        else if(objectClips[i].animated)
         {
-            mode = getMode(tag);
-            if(mode == "absolute")
-                obj.setStopFactor(factor);
-            else if(mode == "scale")
-                obj.setStopFactor(obj.getStopFactor() * factor);
+            player = new ChimpCharacter(renderer, animations, objectClips[i].run, objectClips[i].jump,
+                                        objectClips[i].idle);
+            applyProperties(level, ops + object.firstOp, object.opCount, *player);
         }
     }
-    if( (tag = objXML->FirstChildElement("sprintfactor")) )
-    {
-        float factor;
-        if(tag->QueryFloatText(&factor) == tinyxml2::XML_SUCCESS)
-            obj.setSprintFactor(factor);
-    }
-    if( (tag = objXML->FirstChildElement("maxjumps")) )
-    {
-        int max;
-        if(tag->QueryIntText(&max) == tinyxml2::XML_SUCCESS)
-            obj.setMaxJumps(max);
-    }
+    sections.clear();
+    for(uint32_t i = 0; i < head.sections.count; ++i)
+        sections.emplace_back(new LevelSection(sects[i]));
+    
+    return true;
+}
+
+/**
+ * @brief ChimpGame::buildObject()
+ * 
+ * Creates an Object or Character from its cooked record. Only reads the game, so sections can be built on worker
+ * threads.
+ */
+ObjectPointer ChimpGame::buildObject(const ChimpCookedLevel& level, const uint32_t index) const
+{
+    const CookedHeader& head = level.header();
+    const CookedObject& object = level.array<CookedObject>(head.objects)[index];
+    const ChimpTile& tile = tiles[level.array<CookedFrame>(head.frames)[object.firstFrame].tile];
+    const ObjectClips& clips = objectClips[index];
+    ObjectPointer built;
     
-    for(tag = objXML->FirstChildElement("faction"); tag; tag = tag->NextSiblingElement("faction"))
+    if(object.type == COOKED_OBJECT)
+        built.reset(new ChimpObject(renderer, tile));
+    else if(clips.animated)
+        built.reset(new ChimpCharacter(renderer, animations, clips.run, clips.jump, clips.idle, 0, 0, 1, 1,
+                                       FACTION_VOID, FACTION_VOID, 100));
+    else
+        built.reset(new ChimpCharacter(renderer, animations, clips.run, clips.jump, clips.idle));
+    applyProperties(level, level.array<CookedOp>(head.ops) + object.firstOp, object.opCount, *built);
+    return built;
+}
+
+ObjectVector& ChimpGame::getLayer(const Layer lay)
+{
+    switch(lay)
     {
-        std::string type, factionStr;
-        if(getString(tag->Attribute("type"), type) && getString(tag->GetText(), factionStr))
-        {
-            Faction faction;
-            if(factionStr == "player")
-                faction = FACTION_PLAYER;
-            else if(factionStr == "baddies")
-                faction = FACTION_BADDIES;
-            else
-                continue;
-            
-            if(type == "friend")
-                obj.addFriend(faction);
-            else if(type == "enemy")
-                obj.addEnemy(faction);
-        }
+    case BACK:
+        return background;
+    case FORE:
+        return foreground;
+    case MID:
+    default:
+        return middle;
     }
-    for(tag = objXML->FirstChildElement("acceleration"); tag; tag = tag->NextSiblingElement("acceleration"))
+}
+
+/**
+ * @brief ChimpGame::streamSections()
+ * 
+ * Starts loading sections within streamDistance of the view, splices in the ones that finished loading and unloads
+ * loaded ones more than twice streamDistance away, so a section at the edge doesn't load and unload repeatedly.
+ * 
+ * @param block Builds sections on this thread, so they're in before this returns. Otherwise they're built on the
+ * job system and spliced in by a later call.
+ * @param started false while initialize() is setting up the level, which then initializes every object itself.
+ */
+void ChimpGame::streamSections(const bool block, const bool started)
+{
+    if(block)
+        sectionTasks.wait();
+    const int left = midView.l - streamDistance, right = midView.r + streamDistance;
+    for(auto& sectionPtr : sections)
     {
-        float accel;
-        std::string type, mode;
-        if(tag->QueryFloatText(&accel) == tinyxml2::XML_SUCCESS && getString(tag->Attribute("type"), type))
+        LevelSection& section = *sectionPtr;
+        const CookedSection& bounds = *section.cooked;
+        switch(section.state.load(std::memory_order_acquire))
         {
-            mode = getMode(tag);
-            if(type == "run")
+        case SECTION_UNLOADED:
+            if(bounds.right < left || bounds.left > right)
+                break;
+            if(block)
             {
-                if(mode == "absolute")
-                    obj.setRunAccel(accel);
-                else if(mode == "scale")
-                    obj.setRunAccel(obj.getRunAccel() * accel);
+                buildSection(section);
+                spliceSection(section, started);
+                break;
             }
-            else if(type == "jump")
+            section.state.store(SECTION_LOADING, std::memory_order_relaxed);
+            sectionTasks.run([this, &section]
             {
-                if(mode == "absolute")
-                    obj.setJumpAccel(accel);
-                else if(mode == "scale")
-                    obj.setJumpAccel(obj.getJumpAccel() * accel);
-            }
+                buildSection(section);
+                section.state.store(SECTION_BUILT, std::memory_order_release);
+            });
+            break;
+        case SECTION_BUILT:
+            spliceSection(section, started);
+            break;
+        case SECTION_LOADED:
+            if(bounds.right < left - streamDistance || bounds.left > right + streamDistance)
+                unloadSection(section, true);
+            break;
         }
     }
-    for(tag = objXML->FirstChildElement("impulse"); tag; tag = tag->NextSiblingElement("impulse"))
+}
+
+/**
+ * @brief ChimpGame::buildSection()
+ * 
+ * Creates a section's objects into section.built. May run on a worker thread.
+ */
+void ChimpGame::buildSection(LevelSection& section) const
+{
+    const ChimpCookedLevel& level = currentLevel->level;
+    const CookedObject* const objects = level.array<CookedObject>(level.header().objects);
+    const uint32_t first = section.cooked->firstObject;
+    
+    section.built.clear();
+    for(uint32_t i = first; i < first + section.cooked->objectCount; ++i)
     {
-        float impulse;
-        std::string type, mode;
-        if(tag->QueryFloatText(&impulse) == tinyxml2::XML_SUCCESS && getString(tag->Attribute("type"), type))
-        {
-            mode = getMode(tag);
-            if(type == "run")
-            {
-                if(mode == "absolute")
-                    obj.setRunImpulse(impulse);
-                else if(mode == "scale")
-                    obj.setRunImpulse(obj.getRunImpulse() * impulse);
-            }
-            else if(type == "jump")
-            {
-                if(mode == "absolute")
-                    obj.setJumpImpulse(impulse);
-                else if(mode == "scale")
-                    obj.setJumpImpulse(obj.getRunImpulse() * impulse);
-            }
-            else if(type == "multijump")
-            {
-                if(mode == "absolute")
-                    obj.setMultiJumpImpulse(impulse);
-                else if(mode == "scale")
-                    obj.setMultiJumpImpulse(obj.getMultiJumpImpulse() * impulse);
-            }
-        }
+        ChimpTraceScope trace("object", "object", i);
+        section.built.emplace_back(static_cast<Layer>(objects[i].layer), buildObject(level, i));
     }
-    for(tag = objXML->FirstChildElement("resistance"); tag; tag = tag->NextSiblingElement("resistance"))
+}
+
+/**
+ * @brief ChimpGame::spliceSection()
+ * 
+ * Moves a built section's objects into their layers, after the objects already there.
+ * 
+ * @param started If true, objects are initialized, then given back the state saved when the section was last unloaded.
+ */
+void ChimpGame::spliceSection(LevelSection& section, const bool started)
+{
+    for(size_t i = 0; i < section.built.size(); ++i)
     {
-        float resistance;
-        std::string type, mode;
-        if(tag->QueryFloatText(&resistance) == tinyxml2::XML_SUCCESS && getString(tag->Attribute("type"), type))
+        ChimpObject& obj = *section.built[i].second;
+        if(started)
         {
-            mode = getMode(tag);
-            if(type == "run")
-            {
-                if(mode == "absolute")
-                    obj.setResistanceX(resistance);
-                else if(mode == "scale")
-                    obj.setResistanceX(obj.getResistanceX() * resistance);
-            }
-            else if(type == "jump")
+            obj.initialize(*this);
+            if(i < section.saved.size())
             {
-                if(mode == "absolute")
-                    obj.setResistanceY(resistance);
-                else if(mode == "scale")
-                    obj.setResistanceY(obj.getResistanceY() * resistance);
+                const ObjectState& state = section.saved[i];
+                obj.setX(state.x);
+                obj.setY(state.y);
+                obj.setVelocityX(state.velocityX);
+                obj.setVelocityY(state.velocityY);
+                obj.setHealth(state.health);
+                if(state.active)
+                    obj.activate();
+                else
+                    obj.deactivate();
             }
         }
+        section.live.push_back(&obj);
+        getLayer(section.built[i].first).push_back(std::move(section.built[i].second));
     }
-    for(tag = objXML->FirstChildElement("script"); tag; tag = tag->NextSiblingElement("script"))
-    {
-        std::string type, script;
-        if(getString(tag->Attribute("type"), type) && getString(tag->GetText(), script))
-        {
-            if(type == "behavior")
-                obj.setScriptBehavior(script);
-            else if(type == "init")
-                obj.setScriptInit(script);
-        }
-    }
-    for(tag = objXML->FirstChildElement("sound"); tag; tag = tag->NextSiblingElement("sound"))
-    {
-        std::string sound, type;
-        if(   getString(tag->Attribute("type"), type)
-           && getString(tag->GetText(), sound)
-           && sounds.find(sound) != sounds.end())
-        {
-            if(type == "jump")
-                obj.setSoundJump(sounds[sound]);
-            else if(type == "multijump")
-                obj.setSoundMultijump(sounds[sound]);
-        }
-    }
+    section.built.clear();
+    section.saved.clear();
+    section.state.store(SECTION_LOADED, std::memory_order_relaxed);
 }
 
-bool ChimpGame::loadTextures(tinyxml2::XMLDocument& levelXML, TextureMap& textures, SDL_Renderer* const renderer)
+/**
+ * @brief ChimpGame::unloadSection()
+ * 
+ * Destroys a loaded section's objects. Mobiles standing on one of them start falling instead.
+ * 
+ * @param save Keeps each object's position, velocity, health and whether it's active, to be restored when the section
+ * loads again.
+ */
+void ChimpGame::unloadSection(LevelSection& section, const bool save)
 {
-    for(tinyxml2::XMLElement* texture = levelXML.FirstChildElement("chimptexture");
-        texture;
-        texture = texture->NextSiblingElement("chimptexture"))
+    const std::unordered_set<const ChimpObject*> gone(section.live.begin(), section.live.end());
+    section.saved.clear();
+    if(save)
+        for(const ChimpObject* const obj : section.live)
+            section.saved.push_back({obj->getX(), obj->getY(), obj->getVelocityX(), obj->getVelocityY(),
+                                     obj->getHealth(), obj->isActive()});
+    section.live.clear();
+    
+    if(gone.count(currentObj))
+        currentObj = nullptr;
+    auto unloaded = [&gone](const ObjectPointer& obj) { return gone.count(obj.get()) != 0; };
+    for(ObjectVector* const layer : {&background, &middle, &foreground})
     {
-        std::string texName, texFile;
-                
-        if(!getString(texture->Attribute("name"), texName))
-        {
-            std::cerr << "Error: chimptexture tag without name attribute" << std::endl;
-            return false;
-        }
-        if(!getString(texture->Attribute("file"), texFile))
-        {
-            std::cerr << "Error: texture tag without file attribute" << std::endl;
-            return false;
-        }
-        SDL_Texture* tex = IMG_LoadTexture(renderer, (ASSETS_PATH + texFile).c_str());
-        if(!tex)
-        {
-            std::cerr << "Error loading texture file: " << SDL_GetError() << std::endl;
-            return false;
-        }
-        textures[texName] = tex;
+        layer->erase(std::remove_if(layer->begin(), layer->end(), unloaded), layer->end());
+        for(auto& obj : *layer)
+            if(gone.count(obj->getPlatform()))
+                obj->leavePlatform();
     }
-    
-    return true;
+    if(player && gone.count(player->getPlatform()))
+        player->leavePlatform();
+    section.state.store(SECTION_UNLOADED, std::memory_order_relaxed);
 }
 
-bool ChimpGame::loadTiles(tinyxml2::XMLDocument& levelXML, TextureMap& textures, TileMap& tiles)
+/**
+ * @brief ChimpGame::buildClips()
+ * 
+ * Registers a Character's clips from its frames' animation tags. A frame's duration sets how many miliseconds it's
+ * shown for in time-driven clips.
+ * 
+ * @return false if there are no idle frames, in which case nothing is registered.
+ */
+bool ChimpGame::buildClips(const CookedFrame* const frames, const size_t count, ClipId& idleclip, ClipId& runclip,
+                           ClipId& jumpclip)
 {
-    for(tinyxml2::XMLElement* tile = levelXML.FirstChildElement("chimptile");
-        tile;
-        tile = tile->NextSiblingElement("chimptile"))
+    AnimationClip idle, run, jump;
+    for(size_t i = 0; i < count; ++i)
     {
-        std::string tileName, texName;
-        tinyxml2::XMLElement* tag;
-        int x, y, width, height, widthStretched, heightStretched,
-            left   = 0,
-            right  = 0,
-            top    = 0,
-            bottom = 0;
-        
-        if(!getString(tile->Attribute("name"), tileName))
-        {
-            std::cerr << "Error: chimptile tag without name attribute" << std::endl;
-            return false;
-        }
-        
-        if( !(tag = tile->FirstChildElement("texture")) )
-        {
-            std::cerr << "Error: chimptile tag without texture child" << std::endl;
-            return false;
-        }
-        if(!getString(tag->Attribute("name"), texName))
-        {
-            std::cerr << "Error: chimptile texture child without name attribute" << std::endl;
-            return false;
-        }
-        if(textures.find(texName) == textures.end())
-        {
-            std::cerr << "Error: no texture named \"" << texName << "\" found" << std::endl;
-            return false;
-        }
-        if(tag->QueryIntAttribute("x", &x) != tinyxml2::XML_SUCCESS)
-        {
-            std::cerr << "Error: chimptile texture child without x attribute" << std::endl;
-            return false;
-        }
-        if(tag->QueryIntAttribute("y", &y) != tinyxml2::XML_SUCCESS)
-        {
-            std::cerr << "Error: chimptile texture child without y attribute" << std::endl;
-            return false;
-        }
-        if(tag->QueryIntAttribute("width", &width) != tinyxml2::XML_SUCCESS)
+        AnimationClip* clip;
+        switch(frames[i].animation)
         {
-            std::cerr << "Error: chimptile texture child without width attribute" << std::endl;
-            return false;
+        case COOKED_ANIM_IDLE:
+            clip = &idle;
+            break;
+        case COOKED_ANIM_RUN:
+            clip = &run;
+            break;
+        case COOKED_ANIM_JUMP:
+            clip = &jump;
+            break;
+        default:
+            continue;
         }
-        if(tag->QueryIntAttribute("height", &height) != tinyxml2::XML_SUCCESS)
-        {
-            std::cerr << "Error: chimptile texture child without height attribute" << std::endl;
-            return false;
-        }
-        
-        if( (tag = tile->FirstChildElement("stretch")) )
-        {
-            if(tag->QueryIntAttribute("width", &widthStretched) != tinyxml2::XML_SUCCESS)
-                widthStretched = width;
-            if(tag->QueryIntAttribute("height", &heightStretched) != tinyxml2::XML_SUCCESS)
-                heightStretched = height;
-        }
-        else
-        {
-            widthStretched = width;
-            heightStretched = height;
-        }
-        
-        if( (tag = tile->FirstChildElement("collision")) )
-        {
-            tag->QueryIntAttribute("left", &left);
-            tag->QueryIntAttribute("right", &right);
-            tag->QueryIntAttribute("top", &top);
-            tag->QueryIntAttribute("bottom", &bottom);
-        }
-        
-        IntBox colBox = {left, right, top, bottom};
-        SDL_Rect drRect, texRect = {x, y, width, height};
-        drRect.w = widthStretched;
-        drRect.h = heightStretched;
-        tiles[tileName] = ChimpTile(textures[texName], texRect, drRect, colBox);
+        clip->frames.push_back(&tiles[frames[i].tile]);
+        clip->durations.push_back(frames[i].duration);
     }
-    
+    if(idle.frames.empty())
+        return false;
+    addClips(idle, run, jump, idleclip, runclip, jumpclip);
     return true;
 }
 
-bool ChimpGame::loadSounds(tinyxml2::XMLDocument& levelXML, SoundMap& sounds, MusicMap& musics)
+/**
+ * @brief ChimpGame::addClips()
+ * 
+ * Registers a Character's idle, run and jump clips. Empty run or jump clips fall back to the idle frames. Run clips
+ * advance every PIXELS_PER_FRAME_X pixels moved and jump clips every PIXELS_PER_FRAME_Y.
+ */
+void ChimpGame::addClips(AnimationClip& idle, AnimationClip& run, AnimationClip& jump, ClipId& idleclip,
+                         ClipId& runclip, ClipId& jumpclip)
 {
-    for(tinyxml2::XMLElement* sound = levelXML.FirstChildElement("chimpsound");
-        sound;
-        sound = sound->NextSiblingElement("chimpsound"))
-    {
-        std::string name, file;
-        if(!getString(sound->Attribute("name"), name))
-        {
-            std::cerr << "Error: chimpsound tag without name attribute" << std::endl;
-            return false;
-        }
-        if(!getString(sound->Attribute("file"), file))
-        {
-            std::cerr << "Error: chimpsound tag without file attribute" << std::endl;
-            return false;
-        }
-        
-        if( !(sounds[name] = Mix_LoadWAV((ASSETS_PATH + file).c_str())) )
-        {
-            std::cerr << "Mix_LoadWAV error: " << SDL_GetError() << std::endl;
-            return false;
-        }
-    }
-    
-    for(tinyxml2::XMLElement* music = levelXML.FirstChildElement("chimpmusic");
-        music;
-        music = music->NextSiblingElement("chimpmusic"))
+    if(run.frames.empty())
+        run = idle;
+    if(jump.frames.empty())
+        jump = idle;
+    idle.distancePerFrame = 0;
+    run.distancePerFrame = PIXELS_PER_FRAME_X;
+    jump.distancePerFrame = PIXELS_PER_FRAME_Y;
+    idleclip = animations.add(idle);
+    runclip = animations.add(run);
+    jumpclip = animations.add(jump);
+}
+
+/**
+ * @brief ChimpGame::applyProperties()
+ * 
+ * Applies an object's cooked properties in order. Later properties can depend on earlier ones, e.g. a y position is
+ * measured from the object's bottom edge, so depends on its height.
+ */
+void ChimpGame::applyProperties(const ChimpCookedLevel& level, const CookedOp* const ops, const size_t count,
+                                ChimpObject& obj) const
+{
+    for(size_t i = 0; i < count; ++i)
     {
-        std::string name, file;
-        if(!getString(music->Attribute("name"), name))
-        {
-            std::cerr << "Error: chimpmusic tag without name attribute" << std::endl;
-            return false;
-        }
-        if(!getString(music->Attribute("file"), file))
+        const CookedOp& op = ops[i];
+        switch(op.code)
         {
-            std::cerr << "Error: chimpmusic tag without file attribute" << std::endl;
-            return false;
-        }
-        
-        if( !(musics[name] = Mix_LoadMUS((ASSETS_PATH + file).c_str())) )
-        {
-            std::cerr << "Mix_LoadMUS error: " << SDL_GetError() << std::endl;
-            return false;
+        case OP_POSITION_X:
+            obj.setInitialX(op.i);
+            break;
+        case OP_POSITION_Y:
+            obj.setInitialY(SCREEN_HEIGHT - op.i - obj.getHeight());
+            break;
+        case OP_TILES_X:
+            obj.setTilesX(op.i);
+            break;
+        case OP_TILES_Y:
+            obj.setTilesY(op.i);
+            break;
+        case OP_MAX_HEALTH:
+            obj.setMaxHealth(op.i);
+            break;
+        case OP_RESPAWN:
+            obj.setRespawn(op.i);
+            break;
+        case OP_DAMAGE_LEFT:
+            obj.setDamageLeft(op.i);
+            break;
+        case OP_DAMAGE_RIGHT:
+            obj.setDamageRight(op.i);
+            break;
+        case OP_DAMAGE_TOP:
+            obj.setDamageTop(op.i);
+            break;
+        case OP_DAMAGE_BOTTOM:
+            obj.setDamageBottom(op.i);
+            break;
+        case OP_BOUND_LEFT:
+            obj.setBoundLeft(op.i);
+            break;
+        case OP_BOUND_RIGHT:
+            obj.setBoundRight(op.i);
+            break;
+        case OP_BOUND_TOP:
+            obj.setBoundTop(op.i);
+            break;
+        case OP_BOUND_BOTTOM:
+            obj.setBoundBottom(op.i);
+            break;
+        case OP_STOP_FACTOR:
+            obj.setStopFactor(op.f);
+            break;
+        case OP_STOP_FACTOR_SCALE:
+            obj.setStopFactor(obj.getStopFactor() * op.f);
+            break;
+        case OP_SPRINT_FACTOR:
+            obj.setSprintFactor(op.f);
+            break;
+        case OP_MAX_JUMPS:
+            obj.setMaxJumps(op.i);
+            break;
+        case OP_FRIEND:
+            obj.addFriend(static_cast<Faction>(op.i));
+            break;
+        case OP_ENEMY:
+            obj.addEnemy(static_cast<Faction>(op.i));
+            break;
+        case OP_RUN_ACCEL:
+            obj.setRunAccel(op.f);
+            break;
+        case OP_RUN_ACCEL_SCALE:
+            obj.setRunAccel(obj.getRunAccel() * op.f);
+            break;
+        case OP_JUMP_ACCEL:
+            obj.setJumpAccel(op.f);
+            break;
+        case OP_JUMP_ACCEL_SCALE:
+            obj.setJumpAccel(obj.getJumpAccel() * op.f);
+            break;
+        case OP_RUN_IMPULSE:
+            obj.setRunImpulse(op.f);
+            break;
+        case OP_RUN_IMPULSE_SCALE:
+            obj.setRunImpulse(obj.getRunImpulse() * op.f);
+            break;
+        case OP_JUMP_IMPULSE:
+            obj.setJumpImpulse(op.f);
+            break;
+        case OP_JUMP_IMPULSE_SCALE:
+            obj.setJumpImpulse(obj.getRunImpulse() * op.f);
+            break;
+        case OP_MULTIJUMP_IMPULSE:
+            obj.setMultiJumpImpulse(op.f);
+            break;
+        case OP_MULTIJUMP_IMPULSE_SCALE:
+            obj.setMultiJumpImpulse(obj.getMultiJumpImpulse() * op.f);
+            break;
+        case OP_RESISTANCE_X:
+            obj.setResistanceX(op.f);
+            break;
+        case OP_RESISTANCE_X_SCALE:
+            obj.setResistanceX(obj.getResistanceX() * op.f);
+            break;
+        case OP_RESISTANCE_Y:
+            obj.setResistanceY(op.f);
+            break;
+        case OP_RESISTANCE_Y_SCALE:
+            obj.setResistanceY(obj.getResistanceY() * op.f);
+            break;
+        case OP_SCRIPT_BEHAVIOR:
+            obj.setScriptBehavior(level.name(op.u));
+            break;
+        case OP_SCRIPT_INIT:
+            obj.setScriptInit(level.name(op.u));
+            break;
+        case OP_SOUND_JUMP:
+            obj.setSoundJump(sounds[op.u]);
+            break;
+        case OP_SOUND_MULTIJUMP:
+            obj.setSoundMultijump(sounds[op.u]);
+            break;
         }
     }
-    
-    return true;
 }
 
 } // namespace chimp
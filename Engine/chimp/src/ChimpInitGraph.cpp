@@ -0,0 +1,181 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpInitGraph.h"
+#include "ChimpStartupTrace.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace chimp
+{
+
+/**
+ * @brief ChimpInitGraph::add()
+ * 
+ * Adds a task. Dependencies have to be added first, so the graph can't have cycles.
+ * 
+ * @param run Returns false if the task failed.
+ * @param mainThread Run the task on the thread calling run() instead of the job system.
+ * @return The task's ID, for later tasks to depend on.
+ */
+ChimpInitGraph::TaskId ChimpInitGraph::add(const std::string& name, std::function<bool()> run,
+                                           const std::vector<TaskId>& dependencies, const bool mainThread)
+{
+    const TaskId id = tasks.size();
+    tasks.emplace_back();
+    Task& task = tasks.back();
+    task.name = name;
+    task.run = std::move(run);
+    task.mainThread = mainThread;
+    for(const TaskId dependency : dependencies)
+    {
+        if(dependency >= id)
+        {
+            std::cerr << "Error: init task \"" << name << "\" depends on a task added after it" << std::endl;
+            continue;
+        }
+        task.dependencies.push_back(dependency);
+        tasks[dependency].dependents.push_back(id);
+    }
+    return id;
+}
+
+/**
+ * @brief ChimpInitGraph::run()
+ * 
+ * Runs every task and returns once they've all finished or been skipped. The calling thread runs the main thread
+ * tasks and otherwise waits.
+ * 
+ * @return false if any task failed.
+ */
+bool ChimpInitGraph::run(ChimpJobSystem& jobs)
+{
+    ChimpTaskGroup group(jobs);
+    std::unique_lock<std::mutex> lock(mutex);
+    begin = SDL_GetPerformanceCounter();
+    for(Task& task : tasks)
+        task.waitingOn = task.dependencies.size();
+    for(TaskId id = 0; id < tasks.size(); ++id)
+        if(tasks[id].dependencies.empty())
+            schedule(id, group);
+    
+    while(true)
+    {
+        wake.wait(lock, [this] { return !mainQueue.empty() || finished == tasks.size(); });
+        if(mainQueue.empty())
+            break;
+        const TaskId id = mainQueue.front();
+        mainQueue.pop_front();
+        lock.unlock();
+        execute(id, group);
+        lock.lock();
+    }
+    lock.unlock();
+    group.wait(); // the last worker task may still be returning
+    return !failed;
+}
+
+/**
+ * @brief ChimpInitGraph::schedule()
+ * 
+ * Hands over a task whose dependencies have all finished. Called with mutex held.
+ */
+void ChimpInitGraph::schedule(const TaskId id, ChimpTaskGroup& group)
+{
+    if(tasks[id].mainThread)
+        mainQueue.push_back(id);
+    else
+        group.run([this, id, &group] { execute(id, group); });
+}
+
+void ChimpInitGraph::execute(const TaskId id, ChimpTaskGroup& group)
+{
+    Task& task = tasks[id];
+    bool skip;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        skip = failed;
+    }
+    if(!skip)
+    {
+        task.start = SDL_GetPerformanceCounter();
+        task.succeeded = task.run();
+        task.end = SDL_GetPerformanceCounter();
+        task.ran = true;
+        ChimpStartupTrace::getTrace().record(task.name, "startup", task.start, task.end);
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!task.succeeded)
+        failed = true;
+    ++finished;
+    for(const TaskId dependent : task.dependents)
+        if(--tasks[dependent].waitingOn == 0)
+            schedule(dependent, group);
+    wake.notify_all();
+}
+
+double ChimpInitGraph::toMs(const Uint64 time) const
+{
+    return (time - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+/**
+ * @brief ChimpInitGraph::report()
+ * 
+ * Prints the critical path: starting from the task that finished last, each task's dependency that finished last, back
+ * to a task with no dependencies. Gaps between a task's start and its dependency's end are time spent waiting for a
+ * free thread. Only meaningful after run().
+ */
+void ChimpInitGraph::report(std::ostream& out) const
+{
+    double busy = 0;
+    const Task* last = nullptr;
+    for(const Task& task : tasks)
+    {
+        if(!task.ran)
+            continue;
+        busy += toMs(task.end) - toMs(task.start);
+        if(!last || task.end > last->end)
+            last = &task;
+    }
+    if(!last)
+        return;
+    
+    std::vector<const Task*> path;
+    for(const Task* task = last; task; )
+    {
+        path.push_back(task);
+        const Task* previous = nullptr;
+        for(const TaskId dependency : task->dependencies)
+            if(tasks[dependency].ran && (!previous || tasks[dependency].end > previous->end))
+                previous = &tasks[dependency];
+        task = previous;
+    }
+    std::reverse(path.begin(), path.end());
+    
+    out << "startup took " << toMs(last->end) << " ms, its tasks " << busy << " ms in total" << std::endl;
+    out << "critical path:\nstart (ms)\tduration (ms)\ttask" << std::endl;
+    for(const Task* task : path)
+        out << toMs(task->start) << "\t\t" << toMs(task->end) - toMs(task->start) << "\t\t" << task->name
+            << (task->mainThread ? " (main thread)" : "") << std::endl;
+}
+
+} // namespace chimp
@@ -0,0 +1,483 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpJobSystem.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#if defined (__gnu_linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace chimp
+{
+
+static constexpr int64_t DEQUE_SIZE = 256; // initial; grows when full
+static constexpr int IDLE_SPINS = 64;      // times an idle thread yields before it sleeps
+static constexpr int WAIT_SLEEP_US = 50;   // how long a thread waiting on a group sleeps once it's done spinning
+
+static thread_local const ChimpJobSystem* workerJobs = nullptr; // job system this thread works for, if any
+static thread_local void* workerSelf = nullptr;
+static thread_local int jobDepth = 0; // tasks being run on this thread, counting ones run while waiting in a task
+
+/**
+ * @brief ChimpTaskGroup::run()
+ * 
+ * Submits a task to the group's job system. It runs on the calling thread's own deque if that's a worker.
+ */
+void ChimpTaskGroup::run(std::function<void()> task)
+{
+    pending.fetch_add(1, std::memory_order_relaxed);
+    jobs.submit(new ChimpJobSystem::Job{std::move(task), this});
+}
+
+/**
+ * @brief ChimpTaskGroup::then()
+ * 
+ * Adds a task to the group to be submitted once the tasks already in it have finished, or right away if there are
+ * none. wait() waits for continuations too, and they may add continuations of their own.
+ */
+void ChimpTaskGroup::then(std::function<void()> continuation)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if(pending.load(std::memory_order_acquire) != 0)
+    {
+        continuations.push_back(std::move(continuation));
+        return;
+    }
+    lock.unlock();
+    run(std::move(continuation));
+}
+
+/**
+ * @brief ChimpTaskGroup::wait()
+ * 
+ * Returns once every task in the group has finished, running tasks from the job system meanwhile, so waiting from
+ * inside a task doesn't take a worker away.
+ */
+void ChimpTaskGroup::wait()
+{
+    ChimpJobSystem::Worker* const self = ChimpJobSystem::currentWorker(&jobs);
+    int idle = 0;
+    while(pending.load(std::memory_order_acquire) != 0)
+    {
+        if(jobs.runOne(self))
+            idle = 0;
+        else if(++idle < IDLE_SPINS)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(WAIT_SLEEP_US));
+    }
+    std::lock_guard<std::mutex> lock(mutex); // the last task lets go of the group only once it unlocks this
+}
+
+/**
+ * @brief ChimpTaskGroup::finish()
+ * 
+ * Counts a task as done. The last one submits the continuations instead, and reaches zero only while holding mutex,
+ * so then() either sees the group busy and leaves its continuation to it, or sees it done. It keeps its own count
+ * while submitting, then goes round again, so continuations queued meanwhile by the ones submitted aren't lost.
+ */
+void ChimpTaskGroup::finish()
+{
+    size_t count = pending.load(std::memory_order_relaxed);
+    while(true)
+    {
+        if(count > 1)
+        {
+            if(pending.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+                return;
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(mutex);
+        count = pending.load(std::memory_order_relaxed);
+        if(count > 1)
+            continue;
+        if(continuations.empty())
+        {
+            pending.fetch_sub(1, std::memory_order_acq_rel); // an RMW, so wait() syncs with every task, not just this
+            return;
+        }
+        std::vector<std::function<void()>> next;
+        next.swap(continuations);
+        lock.unlock();
+        for(std::function<void()>& continuation : next)
+            run(std::move(continuation));
+        // Still counted, so the continuations may have finished and queued more of their own; check again.
+        count = pending.load(std::memory_order_relaxed);
+    }
+}
+
+ChimpJobSystem::Deque::Deque() : top(0), bottom(0)
+{
+    rings.emplace_back(new Ring(DEQUE_SIZE));
+    ring.store(rings.back().get(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief ChimpJobSystem::Deque::push()
+ * 
+ * Owner only. Adds a job at the bottom, growing the deque if it's full.
+ */
+void ChimpJobSystem::Deque::push(Job* const job)
+{
+    const int64_t b = bottom.load(std::memory_order_relaxed);
+    const int64_t t = top.load(std::memory_order_acquire);
+    Ring* current = ring.load(std::memory_order_relaxed);
+    if(b - t > current->mask)
+    {
+        Ring* const grown = new Ring((current->mask + 1) * 2);
+        for(int64_t i = t; i < b; ++i)
+            grown->put(i, current->get(i));
+        rings.emplace_back(grown);
+        ring.store(grown, std::memory_order_release);
+        current = grown;
+    }
+    current->put(b, job);
+    bottom.store(b + 1, std::memory_order_release);
+}
+
+/**
+ * @brief ChimpJobSystem::Deque::pop()
+ * 
+ * Owner only. Takes the newest job, racing thieves for it if it's the last one.
+ */
+ChimpJobSystem::Job* ChimpJobSystem::Deque::pop()
+{
+    const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Ring* const current = ring.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    if(t > b) // empty
+    {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job* job = current->get(b);
+    if(t == b)
+    {
+        if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr; // stolen
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+/**
+ * @brief ChimpJobSystem::Deque::steal()
+ * 
+ * Any thread. Takes the oldest job.
+ * 
+ * @return nullptr if the deque is empty or another thread took the job first.
+ */
+ChimpJobSystem::Job* ChimpJobSystem::Deque::steal()
+{
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom.load(std::memory_order_acquire);
+    if(t >= b)
+        return nullptr;
+    Job* const job = ring.load(std::memory_order_acquire)->get(t);
+    if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+/**
+ * @brief ChimpJobSystem::ChimpJobSystem()
+ * @param count Number of worker threads. 0 uses one per hardware thread, but for one left to the main thread.
+ * @param pin Keeps each worker on a core of its own, leaving the first to the main thread. Only done on Linux.
+ */
+ChimpJobSystem::ChimpJobSystem(unsigned count, const bool pin)
+    : injectedCount(0), sleeping(0), wakeups(0), stopping(false), statsStart(std::chrono::steady_clock::now())
+{
+    if(count == 0)
+    {
+        count = std::thread::hardware_concurrency();
+        if(count > 1)
+            --count;
+    }
+    if(count == 0)
+        count = 2;
+    for(unsigned i = 0; i < count; ++i)
+    {
+        workers.emplace_back(new Worker);
+        workers.back()->seed = i * 2654435761u + 1;
+    }
+    for(unsigned i = 0; i < count; ++i) // every worker has to exist before any of them looks for one to steal from
+        threads.emplace_back(&ChimpJobSystem::work, this, workers[i].get(), i, pin);
+}
+
+ChimpJobSystem::~ChimpJobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(std::thread& thread : threads)
+        thread.join();
+}
+
+/**
+ * @brief ChimpJobSystem::parallelFor()
+ * 
+ * Splits [0, count) into ranges of grain items, runs body on each range in parallel and waits for all of them. The
+ * calling thread takes the last range itself.
+ * 
+ * @param grain Items per task. 0 makes about four tasks per thread.
+ * @param body Called as body(first, end) for each range.
+ */
+void ChimpJobSystem::parallelFor(const size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+    if(count == 0)
+        return;
+    if(grain == 0)
+        grain = std::max<size_t>(1, count / (4 * (size() + 1)));
+    ChimpTaskGroup group(*this);
+    size_t first = 0;
+    for(; count - first > grain; first += grain)
+        group.run([&body, first, grain] { body(first, first + grain); });
+    body(first, count);
+    group.wait();
+}
+
+/**
+ * @brief ChimpJobSystem::getStats()
+ * 
+ * How much each worker has done since the stats were last reset. Workers with very different utilisation mean the
+ * tasks are too coarse to balance.
+ */
+std::vector<ChimpWorkerStats> ChimpJobSystem::getStats() const
+{
+    const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()
+                                                                     - statsStart).count();
+    std::vector<ChimpWorkerStats> stats;
+    for(const std::unique_ptr<Worker>& worker : workers)
+    {
+        ChimpWorkerStats stat;
+        stat.tasks = worker->tasks.load(std::memory_order_relaxed);
+        stat.steals = worker->steals.load(std::memory_order_relaxed);
+        stat.busyMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::duration(worker->busyTicks.load(std::memory_order_relaxed))).count();
+        stat.utilisation = elapsed > 0 ? stat.busyMs / elapsed : 0;
+        stats.push_back(stat);
+    }
+    return stats;
+}
+
+void ChimpJobSystem::resetStats()
+{
+    for(std::unique_ptr<Worker>& worker : workers)
+    {
+        worker->tasks.store(0, std::memory_order_relaxed);
+        worker->steals.store(0, std::memory_order_relaxed);
+        worker->busyTicks.store(0, std::memory_order_relaxed);
+    }
+    statsStart = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief ChimpJobSystem::report()
+ * 
+ * Prints getStats(), one worker per line.
+ */
+void ChimpJobSystem::report(std::ostream& out) const
+{
+    const std::vector<ChimpWorkerStats> stats = getStats();
+    const std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    out << "worker	tasks		steals		busy ms		utilisation" << std::endl;
+    for(size_t i = 0; i < stats.size(); ++i)
+        out << i << "\t" << stats[i].tasks << "\t\t" << stats[i].steals << "\t\t" << stats[i].busyMs << "\t\t"
+            << stats[i].utilisation * 100 << "%" << std::endl;
+    out.flags(flags);
+}
+
+/**
+ * @brief ChimpJobSystem::submit()
+ * 
+ * Pushes a job onto the calling worker's deque, or into the shared queue from any other thread, and wakes a sleeping
+ * worker if there is one.
+ */
+void ChimpJobSystem::submit(Job* const job)
+{
+    Worker* const self = currentWorker(this);
+    if(self)
+        self->deque.push(job);
+    else
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        injected.push_back(job);
+        injectedCount.fetch_add(1, std::memory_order_seq_cst);
+    }
+    
+    // A worker about to sleep counts itself in sleeping before looking for jobs one last time, so either it finds
+    // this job or this sees it and wakes it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(sleeping.load(std::memory_order_seq_cst) > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            if(wakeups < sleeping.load(std::memory_order_relaxed))
+                ++wakeups;
+        }
+        wake.notify_one();
+    }
+}
+
+/**
+ * @brief ChimpJobSystem::find()
+ * 
+ * Looks for a job: the newest on the worker's own deque, then the shared queue, then the oldest on another worker's
+ * deque, starting from a random one.
+ * 
+ * @param self Worker looking, or nullptr on any other thread.
+ */
+ChimpJobSystem::Job* ChimpJobSystem::find(Worker* const self)
+{
+    if(self)
+        if(Job* const job = self->deque.pop())
+            return job;
+    
+    if(injectedCount.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        if(!injected.empty())
+        {
+            Job* const job = injected.front();
+            injected.pop_front();
+            injectedCount.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    
+    static thread_local uint32_t outsideSeed = 0x9e3779b9u; // threads that aren't workers
+    uint32_t& seed = self ? self->seed : outsideSeed;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    const size_t count = workers.size();
+    const size_t start = seed % count;
+    for(size_t i = 0; i < count; ++i)
+    {
+        Worker* const victim = workers[(start + i) % count].get();
+        if(victim == self)
+            continue;
+        if(Job* const job = victim->deque.steal())
+        {
+            if(self)
+                self->steals.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+bool ChimpJobSystem::runOne(Worker* const self)
+{
+    Job* const job = find(self);
+    if(!job)
+        return false;
+    execute(job);
+    return true;
+}
+
+void ChimpJobSystem::execute(Job* const job)
+{
+    Worker* const self = currentWorker(this);
+    const bool timed = self && jobDepth == 0; // time spent in tasks run while waiting in a task is already counted
+    const std::chrono::steady_clock::time_point start = timed ? std::chrono::steady_clock::now()
+                                                              : std::chrono::steady_clock::time_point();
+    ++jobDepth;
+    job->run();
+    --jobDepth;
+    ChimpTaskGroup* const group = job->group;
+    delete job;
+    if(self)
+    {
+        self->tasks.fetch_add(1, std::memory_order_relaxed);
+        if(timed)
+            self->busyTicks.fetch_add((std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+    }
+    group->finish(); // the group may be gone after this
+}
+
+void ChimpJobSystem::work(Worker* const self, const unsigned index, const bool pin)
+{
+    workerJobs = this;
+    workerSelf = self;
+#if defined (__gnu_linux__)
+    const unsigned cores = std::thread::hardware_concurrency();
+    if(pin && cores > 1)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET((index + 1) % cores, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#else
+    (void)index;
+    (void)pin;
+#endif
+    
+    while(true)
+    {
+        if(runOne(self))
+            continue;
+        bool found = false;
+        for(int spin = 0; spin < IDLE_SPINS && !found; ++spin)
+        {
+            std::this_thread::yield();
+            found = runOne(self);
+        }
+        if(found)
+            continue;
+        
+        sleeping.fetch_add(1, std::memory_order_seq_cst);
+        if(Job* const job = find(self))
+        {
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+            execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || wakeups > 0; });
+        if(wakeups > 0)
+            --wakeups;
+        sleeping.fetch_sub(1, std::memory_order_relaxed);
+        if(stopping)
+        {
+            lock.unlock();
+            while(runOne(self));
+            return;
+        }
+    }
+}
+
+ChimpJobSystem::Worker* ChimpJobSystem::currentWorker(const ChimpJobSystem* const jobs)
+{
+    return workerJobs == jobs ? static_cast<Worker*>(workerSelf) : nullptr;
+}
+
+} // namespace chimp
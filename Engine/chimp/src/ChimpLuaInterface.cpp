@@ -2,6 +2,9 @@
 #include "ChimpGame.h"
 #include "ChimpObject.h"
 
+#include <iostream>
+#include <memory>
+
 namespace chimp
 {
 
@@ -15,6 +18,17 @@ int getWorldTop(lua_State* const state);
 int getWorldBottom(lua_State* const state);
 int getWindowWidth(lua_State* const state);
 int getWindowHeight(lua_State* const state);
+int changeLevel(lua_State* const state);
+int preloadLevel(lua_State* const state);
+int getTileId(lua_State* const state);
+int getSoundId(lua_State* const state);
+int getMusicId(lua_State* const state);
+int setMusic(lua_State* const state);
+int playSound(lua_State* const state);
+int delay(lua_State* const state);
+int cancelDelay(lua_State* const state);
+int setTile(lua_State* const state);
+int playerSetTile(lua_State* const state);
 
 int getX(lua_State* const state);
 int getY(lua_State* const state);
@@ -212,6 +226,140 @@ int getWindowHeight(lua_State* const state)
     return 1;
 }
 
+int changeLevel(lua_State* const state) // takes effect after the current frame
+{
+    if(lua_gettop(state) == 1 && lua_isstring(state, 1))
+        ChimpGame::getGame()->changeLevel(lua_tostring(state, 1));
+    return 0;
+}
+
+int preloadLevel(lua_State* const state)
+{
+    if(lua_gettop(state) == 1 && lua_isstring(state, 1))
+        ChimpGame::getGame()->preloadLevel(lua_tostring(state, 1));
+    return 0;
+}
+
+// asset names are looked up once, e.g. at script load, and the ids are what get passed around afterwards;
+// an unknown name gives nil
+
+static int pushAssetId(lua_State* const state, const AssetId id)
+{
+    if(id == ASSET_NONE)
+        lua_pushnil(state);
+    else
+        lua_pushinteger(state, id);
+    return 1;
+}
+
+int getTileId(lua_State* const state)
+{
+    if(lua_gettop(state) != 1 || !lua_isstring(state, 1))
+        return 0;
+    return pushAssetId(state, ChimpGame::getGame()->getTileId(lua_tostring(state, 1)));
+}
+
+int getSoundId(lua_State* const state)
+{
+    if(lua_gettop(state) != 1 || !lua_isstring(state, 1))
+        return 0;
+    return pushAssetId(state, ChimpGame::getGame()->getSoundId(lua_tostring(state, 1)));
+}
+
+int getMusicId(lua_State* const state)
+{
+    if(lua_gettop(state) != 1 || !lua_isstring(state, 1))
+        return 0;
+    return pushAssetId(state, ChimpGame::getGame()->getMusicId(lua_tostring(state, 1)));
+}
+
+int setMusic(lua_State* const state) // nil stops the music
+{
+    if(lua_gettop(state) != 1)
+        return 0;
+    const AssetId id = lua_isnil(state, 1) ? ASSET_NONE : static_cast<AssetId>(lua_tointeger(state, 1));
+    if(ChimpGame::getGame()->setMusic(id))
+        ChimpGame::getGame()->playMusic();
+    return 0;
+}
+
+int playSound(lua_State* const state)
+{
+    if(lua_gettop(state) != 1)
+        return 0;
+    Mix_Chunk* const sound = ChimpGame::getGame()->getSound(static_cast<AssetId>(lua_tointeger(state, 1)));
+    ChimpGame::getGame()->getAudio().play(sound);
+    return 0;
+}
+
+struct LuaDelay // holds a reference to the function passed to delay() for as long as its timer does
+{
+    lua_State* const state;
+    const int function;
+    
+    explicit LuaDelay(lua_State* const luast) : state(luast), function(luaL_ref(luast, LUA_REGISTRYINDEX)) {}
+    ~LuaDelay() { luaL_unref(state, LUA_REGISTRYINDEX, function); }
+};
+
+int delay(lua_State* const state) // delay(ms, function), runs function as the calling object; returns an id
+{
+    if(lua_gettop(state) != 2 || !lua_isnumber(state, 1) || !lua_isfunction(state, 2))
+        return 0;
+    const lua_Integer ms = lua_tointeger(state, 1);
+    const Uint32 time = ms < 0 ? 0 : static_cast<Uint32>(ms);
+    ChimpObject* const owner = ChimpGame::getCurrentObject();
+    const std::shared_ptr<LuaDelay> function = std::make_shared<LuaDelay>(state); // pops the function
+    
+    ChimpTimerWheel::Callback callback = [owner, function](const TimerId)
+    {
+        ChimpObject* const previous = ChimpGame::getCurrentObject();
+        ChimpGame::setCurrentObject(owner);
+        lua_rawgeti(function->state, LUA_REGISTRYINDEX, function->function);
+        if(lua_pcall(function->state, 0, 0, 0) != LUA_OK)
+        {
+            std::cerr << lua_tostring(function->state, -1) << std::endl;
+            lua_pop(function->state, 1);
+        }
+        ChimpGame::setCurrentObject(previous);
+    };
+    
+    // Timers of an object are cancelled along with it, so owner is still there when the function runs.
+    ChimpGame& game = *ChimpGame::getGame();
+    const TimerId id = owner ? owner->addTimer(game, time, std::move(callback))
+                             : game.getTimers().schedule(time, std::move(callback));
+    lua_pushinteger(state, static_cast<lua_Integer>(id));
+    return 1;
+}
+
+int cancelDelay(lua_State* const state)
+{
+    if(lua_gettop(state) != 1 || !lua_isnumber(state, 1))
+        return 0;
+    const TimerId id = static_cast<TimerId>(lua_tointeger(state, 1));
+    lua_pushboolean(state, ChimpGame::getGame()->getTimers().cancel(id));
+    return 1;
+}
+
+int setTile(lua_State* const state)
+{
+    if(lua_gettop(state) != 1)
+        return 0;
+    const ChimpTile* const tile = ChimpGame::getGame()->getTile(static_cast<AssetId>(lua_tointeger(state, 1)));
+    if(tile)
+        ChimpGame::getCurrentObject()->setChimpTile(*tile);
+    return 0;
+}
+
+int playerSetTile(lua_State* const state)
+{
+    if(lua_gettop(state) != 1)
+        return 0;
+    const ChimpTile* const tile = ChimpGame::getGame()->getTile(static_cast<AssetId>(lua_tointeger(state, 1)));
+    if(tile)
+        ChimpGame::getPlayer()->setChimpTile(*tile);
+    return 0;
+}
+
 int getX(lua_State* const state)
 {
     lua_pushnumber(state, ChimpGame::getCurrentObject()->getX());
@@ -1174,6 +1322,17 @@ void setupLua(lua_State* const state)
     lua_register(state, "getWorldBottom", getWorldBottom);
     lua_register(state, "getWindowWidth", getWindowWidth);
     lua_register(state, "getWindowHeight", getWindowHeight);
+    lua_register(state, "changeLevel", changeLevel);
+    lua_register(state, "preloadLevel", preloadLevel);
+    lua_register(state, "getTileId", getTileId);
+    lua_register(state, "getSoundId", getSoundId);
+    lua_register(state, "getMusicId", getMusicId);
+    lua_register(state, "setMusic", setMusic);
+    lua_register(state, "playSound", playSound);
+    lua_register(state, "delay", delay);
+    lua_register(state, "cancelDelay", cancelDelay);
+    lua_register(state, "setTile", setTile);
+    lua_register(state, "playerSetTile", playerSetTile);
     lua_register(state, "getX", getX);
     lua_register(state, "getY", getY);
     lua_register(state, "getInitialX", getInitialX);
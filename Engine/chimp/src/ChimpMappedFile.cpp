@@ -0,0 +1,94 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpMappedFile.h"
+
+#if defined (_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace chimp
+{
+
+ChimpMappedFile::~ChimpMappedFile()
+{
+    close();
+}
+
+/**
+ * @brief ChimpMappedFile::open()
+ * @return false if the file doesn't exist, is empty or can't be mapped. Nothing is reported, so callers can use this
+ * to probe for optional files.
+ */
+bool ChimpMappedFile::open(const std::string& file)
+{
+    close();
+#if defined (_WIN32)
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    if(!in || in.tellg() <= 0)
+        return false;
+    buffer.resize(in.tellg());
+    in.seekg(0);
+    if(!in.read(buffer.data(), buffer.size()))
+    {
+        buffer.clear();
+        return false;
+    }
+    fileData = buffer.data();
+    fileSize = buffer.size();
+#else
+    const int fd = ::open(file.c_str(), O_RDONLY);
+    struct stat info;
+    if(fd < 0)
+        return false;
+    if(fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void* const mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if(mapped == MAP_FAILED)
+        return false;
+    mapping = mapped;
+    fileData = static_cast<const char*>(mapped);
+    fileSize = info.st_size;
+#endif
+    return true;
+}
+
+void ChimpMappedFile::close()
+{
+#if !defined (_WIN32)
+    if(mapping)
+        munmap(mapping, fileSize);
+#endif
+    mapping = nullptr;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    fileData = nullptr;
+    fileSize = 0;
+}
+
+} // namespace chimp
@@ -19,6 +19,9 @@
 
 #include "ChimpMobile.h"
 #include "ChimpGame.h"
+#include "ChimpAssetPack.h"
+#include "ChimpProfiler.h"
+#include "ChimpStartupTrace.h"
 #include "sys/stat.h"
 
 #include <iostream>
@@ -83,7 +86,11 @@ void ChimpMobile::initialize(const ChimpGame& game)
 {
     coord = coordInitial;
     ChimpObject::initialize(game);
-    runScript(scriptInit, game.getLuaState());
+    if(!scriptInit.empty())
+    {
+        ChimpTraceScope trace("script", scriptInit);
+        runScript(scriptInit, game.getLuaState());
+    }
 }
 
 /**
@@ -194,7 +201,7 @@ void ChimpMobile::reset()
  * 
  * [...]
  */
-void ChimpMobile::update(const ObjectVector& objects, ChimpGame& game, const Uint32 time)
+void ChimpMobile::update(const ObjectVector& objects, ChimpGame& game, const double time)
 {
     ChimpObject::update(objects, game, time);
     
@@ -206,10 +213,11 @@ void ChimpMobile::update(const ObjectVector& objects, ChimpGame& game, const Uin
     if(platform)
     {
         coord.x += platform->getVelocityX() * time;
-        coord.y = platform->getCollisionTop() - height + tile.collisionBox.b;
+        coord.y = platform->getCollisionTop() - height + tile->collisionBox.b;
     }
     if( !jumping && (!platform || !touchesAtBottom(*platform)) )
     {
+        ChimpProfileZone zone("collision");
         if(platform)
             numJumps = 1;
         platform = nullptr;
@@ -231,22 +239,22 @@ void ChimpMobile::update(const ObjectVector& objects, ChimpGame& game, const Uin
     if(boundBox.l && getCollisionLeft() < game.getWorldLeft())
     {
         velocityX = 0;
-        coord.x = game.getWorldLeft() - tile.collisionBox.l;
+        coord.x = game.getWorldLeft() - tile->collisionBox.l;
     }
     else if(boundBox.r && getCollisionRight() > game.getWorldRight())
     {
         velocityX = 0;
-        coord.x = game.getWorldRight() - width + tile.collisionBox.r;
+        coord.x = game.getWorldRight() - width + tile->collisionBox.r;
     }
     else if(boundBox.t && getCollisionTop() < game.getWorldTop())
     {
         velocityY = 0;
-        coord.y = game.getWorldTop() - tile.collisionBox.r;
+        coord.y = game.getWorldTop() - tile->collisionBox.r;
     }
     else if(boundBox.b && getCollisionBottom() > game.getWorldBottom())
     {
         velocityY = 0;
-        coord.y = game.getWorldBottom() - height + tile.collisionBox.b;
+        coord.y = game.getWorldBottom() - height + tile->collisionBox.b;
     }
 }
 
@@ -300,7 +308,7 @@ bool ChimpMobile::setMaxJumps(const int max)
 bool ChimpMobile::setScriptBehavior(const std::string& script)
 {
     struct stat buffer;
-    if(   stat(script.c_str(), &buffer) == 0
+    if(   (ChimpAssetPack::getPack().contains(script) || stat(script.c_str(), &buffer) == 0)
        && ( script.substr(script.size()-4, 4) == ".lua" || script.substr(script.size()-5, 5) == ".luac" ))
     {
         scriptBehavior = script;
@@ -312,7 +320,7 @@ bool ChimpMobile::setScriptBehavior(const std::string& script)
 bool ChimpMobile::setScriptInit(const std::string& script)
 {
     struct stat buffer;
-    if(   stat(script.c_str(), &buffer) == 0
+    if(   (ChimpAssetPack::getPack().contains(script) || stat(script.c_str(), &buffer) == 0)
        && ( script.substr(script.size()-4, 4) == ".lua" || script.substr(script.size()-5, 5) == ".luac" ))
     {
         scriptInit = script;
@@ -352,9 +360,10 @@ void ChimpMobile::runScript(std::string& script, lua_State* const luast)
     if(script.empty())
         return;   
     
+    ChimpProfileZone zone("script");
     ChimpGame::setCurrentObject(this); 
     
-    if(luaL_loadfile(luast, script.c_str()) != LUA_OK)
+    if(ChimpAssetPack::getPack().loadLua(luast, script) != LUA_OK)
     {
         std::cerr << lua_tostring(luast, -1) << std::endl;
         lua_pop(luast, 1);
@@ -0,0 +1,53 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpNameTable.h"
+
+namespace chimp
+{
+
+/**
+ * @brief ChimpNameTable::intern()
+ * @return The name's ID, which is the next unused one if the name is new.
+ */
+AssetId ChimpNameTable::intern(const std::string& name)
+{
+    auto inserted = ids.insert({name, names.size()});
+    if(inserted.second)
+        names.push_back(name);
+    return inserted.first->second;
+}
+
+/**
+ * @brief ChimpNameTable::find()
+ * @return The name's ID, or ASSET_NONE if it was never interned.
+ */
+AssetId ChimpNameTable::find(const std::string& name) const
+{
+    auto found = ids.find(name);
+    return found == ids.end() ? ASSET_NONE : found->second;
+}
+
+void ChimpNameTable::clear()
+{
+    ids.clear();
+    names.clear();
+}
+
+} // namespace chimp
@@ -20,6 +20,7 @@
 #include "ChimpObject.h"
 #include "ChimpGame.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace chimp
@@ -27,7 +28,7 @@ namespace chimp
 
 /**
  * @brief ChimpObject::ChimpObject()
- * @param til Object's ChimpTile
+ * @param til Object's ChimpTile. Not copied, so it must outlive the Object.
  * @param rend SDL renderer that should be drawn to
  * @param pX Object's initial x-position
  * @param pY Object's initial y-position
@@ -38,14 +39,14 @@ namespace chimp
  */
 ChimpObject::ChimpObject(SDL_Renderer* const rend, const ChimpTile& til, const int pX, const int pY, const int tilesX,
                          const int tilesY, Faction frnds, Faction enms)
-    : tile(til), renderer(rend), friends(frnds), enemies(enms)
+    : tile(&til), renderer(rend), friends(frnds), enemies(enms)
 {
     setTilesX(tilesX);
     setTilesY(tilesY);
     coord.x = pX;
     coord.y = SCREEN_HEIGHT - pY - height;
-    center.x = (tile.collisionBox.l + width - tile.collisionBox.r) / 2.0;
-    center.y = (tile.collisionBox.r + height - tile.collisionBox.b) / 2.0;
+    center.x = (tile->collisionBox.l + width - tile->collisionBox.r) / 2.0;
+    center.y = (tile->collisionBox.r + height - tile->collisionBox.b) / 2.0;
     damageBox.l = true;
     damageBox.r = true;
     damageBox.t = true;
@@ -57,6 +58,13 @@ ChimpObject::ChimpObject(SDL_Renderer* const rend, const ChimpTile& til, const i
     active = false;
 }
 
+ChimpObject::~ChimpObject()
+{
+    if(!timers.empty() && ChimpGame::getGame())
+        for(const TimerId id : timers)
+            ChimpGame::getGame()->getTimers().cancel(id);
+}
+
 /**
  * @brief ChimpObject::initialize()
  * 
@@ -90,6 +98,26 @@ bool ChimpObject::touchesAtBottom(const ChimpObject& other) const
            && getCollisionRight()                  >= other.getCollisionLeft();
 }
 
+/**
+ * @brief ChimpObject::addTimer()
+ * 
+ * Schedules a callback on the game's timers that's cancelled if this Object is destroyed first, so the callback may
+ * use it freely.
+ * 
+ * @param delay Milliseconds of game time until callback runs.
+ * @return Id of the timer, for ChimpTimerWheel::cancel().
+ */
+TimerId ChimpObject::addTimer(ChimpGame& game, const Uint32 delay, ChimpTimerWheel::Callback callback)
+{
+    ChimpTimerWheel& wheel = game.getTimers();
+    timers.erase(std::remove_if(timers.begin(), timers.end(),
+                                [&wheel](const TimerId id) { return !wheel.isPending(id); }),
+                 timers.end());
+    const TimerId id = wheel.schedule(delay, std::move(callback));
+    timers.push_back(id);
+    return id;
+}
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 /**
@@ -99,7 +127,7 @@ bool ChimpObject::touchesAtBottom(const ChimpObject& other) const
  * 
  * [...]
  */
-void ChimpObject::update(const ObjectVector& objects, ChimpGame& game, const Uint32 time)
+void ChimpObject::update(const ObjectVector& objects, ChimpGame& game, const double time)
 {
     if(active)
     {
@@ -132,12 +160,36 @@ void ChimpObject::render(const IntBox& screen)
 {
     if(!active)
         return;
-    for(int x = 0; x < width; x += tile.drawRect.w)
-        for(int y = 0; y < height; y += tile.drawRect.h)
+    SDL_Rect drawRect = tile->drawRect;
+    for(int x = 0; x < width; x += drawRect.w)
+        for(int y = 0; y < height; y += drawRect.h)
+        {
+            drawRect.x = coord.x + x - screen.l;
+            drawRect.y = coord.y + y - screen.t;
+            SDL_RenderCopyEx(renderer, tile->texture, &tile->textureRect, &drawRect, 0, NULL, flip);
+        }
+}
+
+/**
+ * @brief ChimpObject::record()
+ * 
+ * Same as render(), but appends draw commands to a render packet instead of drawing. Used when simulation and rendering
+ * run on separate threads.
+ * 
+ * @param screen Current view for this Object's game layer.
+ * @param packet Render packet being built for the next frame.
+ */
+void ChimpObject::record(const IntBox& screen, ChimpRenderPacket& packet)
+{
+    if(!active)
+        return;
+    SDL_Rect drawRect = tile->drawRect;
+    for(int x = 0; x < width; x += drawRect.w)
+        for(int y = 0; y < height; y += drawRect.h)
         {
-            tile.drawRect.x = coord.x + x - screen.l;
-            tile.drawRect.y = coord.y + y - screen.t;
-            SDL_RenderCopyEx(renderer, tile.texture, &tile.textureRect, &tile.drawRect, 0, NULL, flip);
+            drawRect.x = coord.x + x - screen.l;
+            drawRect.y = coord.y + y - screen.t;
+            packet.draws.push_back({ tile->texture, tile->textureRect, drawRect, flip, TINT_NONE });
         }
 }
 
@@ -0,0 +1,185 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpProfiler.h"
+#include "ChimpConstants.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace chimp
+{
+
+static thread_local void* threadBuffer = nullptr; // this thread's ChimpProfiler::ThreadBuffer, once it has one
+
+ChimpProfiler::ChimpProfiler() : size(PROFILE_ZONES), enabled(false), writeRequested(false), origin(0), written(0) {}
+
+ChimpProfiler& ChimpProfiler::getProfiler()
+{
+    static ChimpProfiler profiler;
+    return profiler;
+}
+
+/**
+ * @brief ChimpProfiler::enable()
+ * 
+ * Starts recording. Times in the trace count from here.
+ */
+void ChimpProfiler::enable()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    origin = now();
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief ChimpProfiler::setThreadName()
+ * 
+ * Names the calling thread's track in the trace. Threads that don't are called "thread" and their number.
+ */
+void ChimpProfiler::setThreadName(const std::string& name)
+{
+    ThreadBuffer& buffer = getBuffer();
+    std::lock_guard<std::mutex> lock(mutex);
+    buffer.name = name;
+}
+
+/**
+ * @brief ChimpProfiler::record()
+ * 
+ * Adds a zone to the calling thread's ring buffer, overwriting its oldest zone once the buffer is full.
+ * 
+ * @param name String literal; only the pointer is kept.
+ */
+void ChimpProfiler::record(const char* const name, const Uint64 start, const Uint64 end)
+{
+    ThreadBuffer& buffer = getBuffer();
+    const size_t index = buffer.written.load(std::memory_order_relaxed);
+    Zone& zone = buffer.zones[index % size];
+    // A write() that copies any of the new zone sees written as at least index afterwards, so it leaves the zone out.
+    std::atomic_thread_fence(std::memory_order_release);
+    zone.name.store(name, std::memory_order_relaxed);
+    zone.start.store(start, std::memory_order_relaxed);
+    zone.end.store(end, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief ChimpProfiler::writeIfRequested()
+ * 
+ * Writes the trace to the next numbered PROFILE_FILE if requestWrite() was called since the last time. Meant to be
+ * called once a frame from the main loop.
+ * 
+ * @return false if writing failed.
+ */
+bool ChimpProfiler::writeIfRequested()
+{
+    if(!writeRequested.exchange(false, std::memory_order_relaxed))
+        return true;
+    if(!isEnabled())
+    {
+        std::cerr << "Error: can't write a profile without --profile" << std::endl;
+        return false;
+    }
+    const std::string file = PROFILE_FILE + std::to_string(++written) + ".json";
+    if(!write(file))
+        return false;
+    std::cout << "Wrote profile \"" << file << "\"" << std::endl;
+    return true;
+}
+
+/**
+ * @brief ChimpProfiler::write()
+ * 
+ * Writes every thread's buffered zones as a Chrome trace event JSON file: one complete ("X") event per zone, times in
+ * microseconds since enable(), one track per thread. Threads keep recording meanwhile; zones they overwrite while
+ * being copied are left out.
+ */
+bool ChimpProfiler::write(const std::string& file)
+{
+    std::ofstream out(file);
+    if(!out)
+    {
+        std::cerr << "Error: couldn't write profile \"" << file << "\"" << std::endl;
+        return false;
+    }
+    
+    const double usPerCount = 1000000.0 / SDL_GetPerformanceFrequency();
+    std::vector<const char*> names;
+    std::vector<Uint64> starts, ends;
+    std::lock_guard<std::mutex> lock(mutex);
+    out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+    for(size_t i = 0; i < threads.size(); ++i)
+        out << (i ? ",\n" : "") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i
+            << ",\"args\":{\"name\":\"" << (threads[i]->name.empty() ? "thread " + std::to_string(i) : threads[i]->name)
+            << "\"}}";
+    for(size_t i = 0; i < threads.size(); ++i)
+    {
+        ThreadBuffer& buffer = *threads[i];
+        const size_t end = buffer.written.load(std::memory_order_acquire);
+        const size_t begin = end > size ? end - size : 0;
+        names.clear();
+        starts.clear();
+        ends.clear();
+        for(size_t index = begin; index < end; ++index)
+        {
+            const Zone& zone = buffer.zones[index % size];
+            names.push_back(zone.name.load(std::memory_order_relaxed));
+            starts.push_back(zone.start.load(std::memory_order_relaxed));
+            ends.push_back(zone.end.load(std::memory_order_relaxed));
+        }
+        
+        // Zones the thread has started overwriting since may have been copied half old and half new.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const size_t now = buffer.written.load(std::memory_order_relaxed);
+        const size_t valid = now >= size ? now - size + 1 : 0;
+        for(size_t index = std::max(begin, valid); index < end; ++index)
+        {
+            const size_t at = index - begin;
+            out << ",\n{\"name\":\"" << names[at] << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << i
+                << ",\"ts\":" << (starts[at] - origin) * usPerCount << ",\"dur\":" << (ends[at] - starts[at]) * usPerCount
+                << "}";
+        }
+    }
+    out << "\n]}" << std::endl;
+    if(!out)
+    {
+        std::cerr << "Error: couldn't write profile \"" << file << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ChimpProfiler::ThreadBuffer& ChimpProfiler::getBuffer()
+{
+    if(!threadBuffer)
+    {
+        std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+        buffer->zones.reset(new Zone[size]());
+        buffer->written.store(0, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        threadBuffer = buffer.get();
+        threads.push_back(std::move(buffer));
+    }
+    return *static_cast<ThreadBuffer*>(threadBuffer);
+}
+
+} // namespace chimp
@@ -0,0 +1,98 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpRenderPacket.h"
+#include "ChimpProfiler.h"
+
+namespace chimp
+{
+
+/**
+ * @brief ChimpRenderPacket::submit()
+ *
+ * Issues every recorded draw to the renderer. Must be called from the thread that owns the renderer.
+ *
+ * @param renderer SDL renderer that should be drawn to
+ */
+void ChimpRenderPacket::submit(SDL_Renderer* const renderer) const
+{
+    {
+        ChimpProfileZone zone("render background");
+        submit(renderer, 0, backgroundEnd);
+    }
+    {
+        ChimpProfileZone zone("render middle");
+        submit(renderer, backgroundEnd, middleEnd);
+    }
+    ChimpProfileZone zone("render foreground");
+    submit(renderer, middleEnd, draws.size());
+}
+
+void ChimpRenderPacket::submit(SDL_Renderer* const renderer, const size_t begin, const size_t end) const
+{
+    for(size_t i = begin; i < end; ++i)
+    {
+        const ChimpDrawCommand& draw = draws[i];
+        const bool tinted = draw.tint.r != 255 || draw.tint.g != 255 || draw.tint.b != 255;
+        if(tinted)
+            SDL_SetTextureColorMod(draw.texture, draw.tint.r, draw.tint.g, draw.tint.b);
+        SDL_RenderCopyEx(renderer, draw.texture, &draw.textureRect, &draw.drawRect, 0, NULL, draw.flip);
+        if(tinted)
+            SDL_SetTextureColorMod(draw.texture, 255, 255, 255);
+    }
+}
+
+/**
+ * @brief ChimpRenderPipeline::beginWrite()
+ *
+ * Producer side. Returns the packet owned by the producer, emptied and ready to be recorded into.
+ */
+ChimpRenderPacket& ChimpRenderPipeline::beginWrite()
+{
+    packets[writing].clear();
+    return packets[writing];
+}
+
+/**
+ * @brief ChimpRenderPipeline::publish()
+ *
+ * Producer side. Makes the packet returned by beginWrite() the latest one and takes over whichever packet was
+ * previously waiting. If the consumer never picked that one up it is simply overwritten next frame.
+ */
+void ChimpRenderPipeline::publish()
+{
+    writing = ready.exchange(writing | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+/**
+ * @brief ChimpRenderPipeline::acquire()
+ *
+ * Consumer side. Swaps in the latest published packet, if there is one the consumer hasn't seen yet.
+ *
+ * @return true if current() now refers to a new packet, false if it still refers to the previous one
+ */
+bool ChimpRenderPipeline::acquire()
+{
+    if(!(ready.load(std::memory_order_relaxed) & FRESH))
+        return false;
+    reading = ready.exchange(reading, std::memory_order_acq_rel) & INDEX_MASK;
+    return true;
+}
+
+} // namespace chimp
@@ -0,0 +1,150 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpScreen.h"
+#include "ChimpProfiler.h"
+
+#include <iostream>
+#include <string>
+
+namespace chimp
+{
+
+/**
+ * @brief ChimpScreen::ChimpScreen()
+ * @param rend SDL renderer frames are drawn with
+ * @param viewW Width of the game's view, in world pixels
+ * @param viewH Height of the game's view, in world pixels
+ */
+ChimpScreen::ChimpScreen(SDL_Renderer* const rend, const int viewW, const int viewH)
+    : renderer(rend), target(nullptr), viewWidth(viewW), viewHeight(viewH), internalWidth(viewW),
+      internalHeight(viewH), integerScale(false)
+{
+    outputRect = {0, 0, viewW, viewH};
+}
+
+ChimpScreen::~ChimpScreen()
+{
+    clear();
+}
+
+/**
+ * @brief ChimpScreen::clear()
+ * 
+ * Destroys the offscreen target, going back to drawing straight to the window. Must be called before the renderer is
+ * destroyed if this outlives it.
+ */
+void ChimpScreen::clear()
+{
+    if(target)
+        SDL_DestroyTexture(target);
+    target = nullptr;
+}
+
+/**
+ * @brief ChimpScreen::setInternalResolution()
+ * 
+ * Switches to drawing each frame into an offscreen texture of the given size. The game's view is scaled to fit it once
+ * per frame, so a smaller internal resolution than the view is cheaper to fill.
+ * 
+ * @param width Internal width in pixels.
+ * @param height Internal height in pixels.
+ * @param integer If true, the texture is only ever scaled up by whole numbers, with nearest-neighbour filtering.
+ * @return false if the renderer can't draw to textures.
+ */
+bool ChimpScreen::setInternalResolution(const int width, const int height, const bool integer)
+{
+    if(width <= 0 || height <= 0)
+        return false;
+    clear();
+    
+    const char* const oldQuality = SDL_GetHint(SDL_HINT_RENDER_SCALE_QUALITY);
+    const std::string quality = oldQuality ? oldQuality : "";
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, integer ? "nearest" : "linear"); // only affects textures created now
+    target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, quality.c_str());
+    if(!target)
+    {
+        std::cerr << "CreateTexture error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    
+    internalWidth = width;
+    internalHeight = height;
+    integerScale = integer;
+    int windowWidth, windowHeight;
+    SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+    if(SDL_GetRendererOutputSize(renderer, &windowWidth, &windowHeight) == 0)
+        resize(windowWidth, windowHeight);
+    return true;
+}
+
+/**
+ * @brief ChimpScreen::resize()
+ * 
+ * Recomputes where the offscreen target is drawn in the window. Call only when the window size actually changes.
+ */
+void ChimpScreen::resize(const int windowWidth, const int windowHeight)
+{
+    float scale = (float)windowWidth / internalWidth;
+    if((float)windowHeight / internalHeight < scale)
+        scale = (float)windowHeight / internalHeight;
+    if(integerScale && scale >= 1.0f)
+        scale = (int)scale;
+    
+    outputRect.w = internalWidth * scale;
+    outputRect.h = internalHeight * scale;
+    outputRect.x = (windowWidth - outputRect.w) / 2;
+    outputRect.y = (windowHeight - outputRect.h) / 2;
+}
+
+/**
+ * @brief ChimpScreen::begin()
+ * 
+ * Starts a frame. Everything drawn until present() is drawn in view coordinates.
+ */
+void ChimpScreen::begin()
+{
+    if(target)
+    {
+        SDL_SetRenderTarget(renderer, target);
+        SDL_RenderSetScale(renderer, (float)internalWidth / viewWidth, (float)internalHeight / viewHeight);
+    }
+    SDL_RenderClear(renderer);
+}
+
+/**
+ * @brief ChimpScreen::present()
+ * 
+ * Ends a frame. With an internal resolution, this is where the whole frame is scaled to the window.
+ */
+void ChimpScreen::present()
+{
+    ChimpProfileZone zone("present");
+    if(target)
+    {
+        SDL_SetRenderTarget(renderer, nullptr);
+        SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+        SDL_RenderClear(renderer); // letterbox bars
+        SDL_RenderCopy(renderer, target, nullptr, &outputRect);
+    }
+    SDL_RenderPresent(renderer);
+}
+
+} // namespace chimp
@@ -0,0 +1,157 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpStartupTrace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace chimp
+{
+
+namespace
+{
+    void writeJsonString(std::ostream& out, const std::string& text)
+    {
+        out << '"';
+        for(const char c : text)
+        {
+            if(c == '"' || c == '\\')
+                out << '\\' << c;
+            else if(static_cast<unsigned char>(c) < 0x20)
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec
+                    << std::setfill(' ');
+            else
+                out << c;
+        }
+        out << '"';
+    }
+}
+
+ChimpStartupTrace& ChimpStartupTrace::getTrace()
+{
+    static ChimpStartupTrace trace;
+    return trace;
+}
+
+/**
+ * @brief ChimpStartupTrace::enable()
+ * 
+ * Starts the timeline. Should be called as early as possible, from the main thread, which becomes thread 0.
+ */
+void ChimpStartupTrace::enable()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    origin = now();
+    threads.insert({std::this_thread::get_id(), 0});
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief ChimpStartupTrace::record()
+ * 
+ * Adds a span to the timeline, on the calling thread's track. Does nothing unless enabled.
+ * 
+ * @param category String literal grouping the span, e.g. "startup" for the phases of main().
+ */
+void ChimpStartupTrace::record(const std::string& name, const char* const category, const Uint64 start,
+                               const Uint64 end)
+{
+    if(!isEnabled())
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    const int thread = threads.insert({std::this_thread::get_id(), int(threads.size())}).first->second;
+    spans.push_back({name, category, start, end, thread});
+}
+
+double ChimpStartupTrace::toMs(const Uint64 time) const
+{
+    return (time - origin) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+/**
+ * @brief ChimpStartupTrace::report()
+ * 
+ * Prints the phases of startup in order, then how many spans each category has and how long they took in total.
+ * Spans on different threads overlap, so a category's total can exceed the time startup took.
+ */
+void ChimpStartupTrace::report(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<const Span*> phases;
+    std::map<std::string, std::pair<size_t, double>> categories;
+    for(const Span& span : spans)
+    {
+        if(std::string(span.category) == "startup")
+            phases.push_back(&span);
+        std::pair<size_t, double>& category = categories[span.category];
+        ++category.first;
+        category.second += toMs(span.end) - toMs(span.start);
+    }
+    std::stable_sort(phases.begin(), phases.end(), [](const Span* a, const Span* b) { return a->start < b->start; });
+    
+    out << "start (ms)\tduration (ms)\tthread\tphase" << std::endl;
+    for(const Span* phase : phases)
+        out << toMs(phase->start) << "\t\t" << toMs(phase->end) - toMs(phase->start) << "\t\t" << phase->thread << "\t"
+            << phase->name << std::endl;
+    out << "spans\ttotal (ms)\tcategory" << std::endl;
+    for(const auto& category : categories)
+        out << category.second.first << "\t" << category.second.second << "\t\t" << category.first << std::endl;
+}
+
+/**
+ * @brief ChimpStartupTrace::write()
+ * 
+ * Writes the timeline as a Chrome trace event JSON file: one complete ("X") event per span, times in microseconds
+ * since enable(), one track per thread.
+ */
+bool ChimpStartupTrace::write(const std::string& file) const
+{
+    std::ofstream out(file);
+    if(!out)
+    {
+        std::cerr << "Error: couldn't write startup trace \"" << file << "\"" << std::endl;
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+    for(size_t i = 0; i < threads.size(); ++i)
+        out << (i ? ",\n" : "") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i
+            << ",\"args\":{\"name\":\"" << (i ? "thread " + std::to_string(i) : std::string("main")) << "\"}}";
+    for(const Span& span : spans)
+    {
+        out << ",\n{\"name\":";
+        writeJsonString(out, span.name);
+        out << ",\"cat\":\"" << span.category << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << span.thread
+            << ",\"ts\":" << toMs(span.start) * 1000.0 << ",\"dur\":" << (toMs(span.end) - toMs(span.start)) * 1000.0
+            << "}";
+    }
+    out << "\n]}" << std::endl;
+    if(!out)
+    {
+        std::cerr << "Error: couldn't write startup trace \"" << file << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace chimp
@@ -0,0 +1,288 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpTextRenderer.h"
+#include "ChimpAssetPack.h"
+
+#if defined (__gnu_linux__) || defined (_WIN32)
+#include <SDL2/SDL_ttf.h>
+#endif
+#if defined (__APPLE__) && defined (__MACH__)
+#include <SDL2_ttf/SDL_ttf.h>
+#endif
+
+#include <iostream>
+
+namespace chimp
+{
+
+/**
+ * @brief ChimpTextRenderer::ChimpTextRenderer()
+ * @param rend SDL renderer that should be drawn to. Can be set later with setRenderer() if only rasterizing until then.
+ * @param file TrueType font file. It's only opened when a size is first used.
+ */
+ChimpTextRenderer::ChimpTextRenderer(SDL_Renderer* const rend, const std::string& file)
+    : renderer(rend), fontFile(file) {}
+
+ChimpTextRenderer::~ChimpTextRenderer()
+{
+    clear();
+}
+
+/**
+ * @brief ChimpTextRenderer::clear()
+ * 
+ * Destroys every glyph atlas. Must be called before the renderer is destroyed if this outlives it.
+ */
+void ChimpTextRenderer::clear()
+{
+    for(auto& atlas : atlases)
+    {
+        if(atlas.second.texture)
+            SDL_DestroyTexture(atlas.second.texture);
+        if(atlas.second.sheet)
+            SDL_FreeSurface(atlas.second.sheet);
+    }
+    atlases.clear();
+}
+
+/**
+ * @brief ChimpTextRenderer::loadSize()
+ * 
+ * Builds the glyph atlas for a font size ahead of time, so the first frame that draws at that size doesn't have to.
+ * 
+ * @return false if the font couldn't be opened or rasterized
+ */
+bool ChimpTextRenderer::loadSize(const int size)
+{
+    return getAtlas(size) != nullptr;
+}
+
+/**
+ * @brief ChimpTextRenderer::rasterize()
+ * 
+ * Renders a font size's glyphs into an atlas sheet without touching the renderer, so it can run on any thread as
+ * long as nothing else uses this text renderer meanwhile. The sheet becomes a texture the first time the size is used
+ * or loaded, on the renderer's thread.
+ * 
+ * @return false if the font couldn't be opened or rasterized
+ */
+bool ChimpTextRenderer::rasterize(const int size)
+{
+    auto found = atlases.find(size);
+    if(found != atlases.end())
+        return found->second.texture || found->second.sheet;
+    
+    GlyphAtlas& atlas = atlases[size]; // stays empty on failure, so a bad size is only tried once
+    TTF_Font* const font = TTF_OpenFontRW(ChimpAssetPack::getPack().openRW(fontFile), 1, size);
+    if(!font)
+    {
+        std::cerr << "TTF_OpenFont error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    
+    const SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface* surfaces[LAST_GLYPH - FIRST_GLYPH + 1];
+    int x = 0, y = 0;
+    atlas.height = TTF_FontHeight(font);
+    for(char c = FIRST_GLYPH; c <= LAST_GLYPH; ++c)
+    {
+        Glyph& glyph = atlas.glyphs[c - FIRST_GLYPH];
+        SDL_Surface*& surface = surfaces[c - FIRST_GLYPH];
+        if(TTF_GlyphMetrics(font, c, nullptr, nullptr, nullptr, nullptr, &glyph.advance) != 0)
+            glyph.advance = 0;
+        surface = TTF_RenderGlyph_Blended(font, c, white);
+        glyph.rect.w = surface ? surface->w : 0;
+        glyph.rect.h = surface ? surface->h : 0;
+        if(x + glyph.rect.w > ATLAS_WIDTH)
+        {
+            x = 0;
+            y += atlas.height;
+        }
+        glyph.rect.x = x;
+        glyph.rect.y = y;
+        x += glyph.rect.w;
+    }
+    atlas.textureHeight = y + atlas.height;
+    TTF_CloseFont(font);
+    
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    atlas.sheet = SDL_CreateRGBSurface(0, ATLAS_WIDTH, atlas.textureHeight, 32,
+                                       0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+#else
+    atlas.sheet = SDL_CreateRGBSurface(0, ATLAS_WIDTH, atlas.textureHeight, 32,
+                                       0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+#endif
+    if(atlas.sheet)
+    {
+        SDL_FillRect(atlas.sheet, nullptr, 0);
+        for(char c = FIRST_GLYPH; c <= LAST_GLYPH; ++c)
+        {
+            SDL_Surface* const surface = surfaces[c - FIRST_GLYPH];
+            if(!surface)
+                continue;
+            SDL_Rect rect = atlas.glyphs[c - FIRST_GLYPH].rect;
+            SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE); // copy alpha straight into the sheet
+            SDL_BlitSurface(surface, nullptr, atlas.sheet, &rect);
+        }
+    }
+    for(SDL_Surface* const surface : surfaces)
+        if(surface)
+            SDL_FreeSurface(surface);
+    
+    if(!atlas.sheet)
+    {
+        std::cerr << "Glyph atlas error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief ChimpTextRenderer::measure()
+ * @return Width in pixels text would take up if drawn at the given size.
+ */
+int ChimpTextRenderer::measure(const char* const text, const int size)
+{
+    const GlyphAtlas* const atlas = getAtlas(size);
+    if(!atlas)
+        return 0;
+    int width = 0;
+    for(const char* c = text; *c; ++c)
+        if(*c >= FIRST_GLYPH && *c <= LAST_GLYPH)
+            width += atlas->glyphs[*c - FIRST_GLYPH].advance;
+    return width;
+}
+
+int ChimpTextRenderer::getLineHeight(const int size)
+{
+    const GlyphAtlas* const atlas = getAtlas(size);
+    return atlas ? atlas->height : 0;
+}
+
+/**
+ * @brief ChimpTextRenderer::draw()
+ * 
+ * Adds a line of text to this frame's batch. Nothing is drawn until flush(). Characters outside printable ASCII are
+ * skipped.
+ * 
+ * @param text Text to draw.
+ * @param x Left edge of the text.
+ * @param y Top edge of the text.
+ * @param size Font size.
+ * @param color Text color.
+ */
+void ChimpTextRenderer::draw(const char* const text, const int x, const int y, const int size, const SDL_Color color)
+{
+    GlyphAtlas* const atlas = getAtlas(size);
+    if(!atlas)
+        return;
+    
+    int penX = x;
+    for(const char* c = text; *c; ++c)
+    {
+        if(*c < FIRST_GLYPH || *c > LAST_GLYPH)
+            continue;
+        const Glyph& glyph = atlas->glyphs[*c - FIRST_GLYPH];
+        if(glyph.rect.w > 0)
+        {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+            const float u0 = (float)glyph.rect.x / ATLAS_WIDTH;
+            const float u1 = (float)(glyph.rect.x + glyph.rect.w) / ATLAS_WIDTH;
+            const float v0 = (float)glyph.rect.y / atlas->textureHeight;
+            const float v1 = (float)(glyph.rect.y + glyph.rect.h) / atlas->textureHeight;
+            const float left = penX, right = penX + glyph.rect.w, top = y, bottom = y + glyph.rect.h;
+            const int first = atlas->vertices.size();
+            
+            atlas->vertices.push_back({ {left, top}, color, {u0, v0} });
+            atlas->vertices.push_back({ {right, top}, color, {u1, v0} });
+            atlas->vertices.push_back({ {left, bottom}, color, {u0, v1} });
+            atlas->vertices.push_back({ {right, bottom}, color, {u1, v1} });
+            for(const int corner : {0, 1, 2, 2, 1, 3})
+                atlas->indices.push_back(first + corner);
+#else
+            SDL_Rect drawRect = { penX, y, glyph.rect.w, glyph.rect.h };
+            SDL_SetTextureColorMod(atlas->texture, color.r, color.g, color.b);
+            SDL_RenderCopy(renderer, atlas->texture, &glyph.rect, &drawRect);
+#endif
+        }
+        penX += glyph.advance;
+    }
+}
+
+/**
+ * @brief ChimpTextRenderer::flush()
+ * 
+ * Draws all text added since the last flush, one render call per font size.
+ */
+void ChimpTextRenderer::flush()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    for(auto& entry : atlases)
+    {
+        GlyphAtlas& atlas = entry.second;
+        if(atlas.indices.empty())
+            continue;
+        SDL_RenderGeometry(renderer, atlas.texture, atlas.vertices.data(), atlas.vertices.size(),
+                           atlas.indices.data(), atlas.indices.size());
+        atlas.vertices.clear();
+        atlas.indices.clear();
+    }
+#endif
+}
+
+/**
+ * @brief ChimpTextRenderer::getAtlas()
+ * 
+ * Returns the glyph atlas for a font size, rasterizing and uploading it first if this is the first time the size is
+ * used. Glyphs are packed left to right in rows of the font's line height.
+ * 
+ * @return nullptr on error
+ */
+ChimpTextRenderer::GlyphAtlas* ChimpTextRenderer::getAtlas(const int size)
+{
+    auto found = atlases.find(size);
+    if(found != atlases.end() && found->second.texture)
+        return &found->second;
+    if(!rasterize(size))
+        return nullptr;
+    GlyphAtlas& atlas = atlases[size];
+    return upload(atlas) ? &atlas : nullptr;
+}
+
+/**
+ * @brief ChimpTextRenderer::upload()
+ * 
+ * Turns a rasterized atlas sheet into a texture and frees the sheet, failed or not.
+ */
+bool ChimpTextRenderer::upload(GlyphAtlas& atlas)
+{
+    atlas.texture = SDL_CreateTextureFromSurface(renderer, atlas.sheet);
+    SDL_FreeSurface(atlas.sheet);
+    atlas.sheet = nullptr;
+    if(!atlas.texture)
+    {
+        std::cerr << "Glyph atlas error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+} // namespace chimp
@@ -0,0 +1,237 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpTimerWheel.h"
+
+#include <algorithm>
+
+namespace chimp
+{
+
+constexpr uint32_t ChimpTimerWheel::NONE;
+
+ChimpTimerWheel::ChimpTimerWheel() : freeTimers(NONE), current(0), pending(0)
+{
+    std::fill(std::begin(heads), std::end(heads), NONE);
+}
+
+/**
+ * @brief ChimpTimerWheel::schedule()
+ * 
+ * Runs a callback once, delay milliseconds from now. A delay of 0 runs it on the next millisecond advanced.
+ * 
+ * @return Id for cancel(), valid until the callback has run or the timer is cancelled.
+ */
+TimerId ChimpTimerWheel::schedule(const uint32_t delay, Callback callback)
+{
+    uint32_t index = freeTimers;
+    if(index == NONE)
+    {
+        index = static_cast<uint32_t>(timers.size());
+        timers.emplace_back();
+    }
+    else
+        freeTimers = timers[index].next;
+    
+    Timer& timer = timers[index];
+    timer.expires = current + std::max<uint32_t>(delay, 1) - 1;
+    timer.callback = std::move(callback);
+    insert(index);
+    ++pending;
+    return static_cast<TimerId>(timer.generation) << 32 | (index + 1);
+}
+
+/**
+ * @brief ChimpTimerWheel::cancel()
+ * 
+ * @return false if the timer already ran or was cancelled.
+ */
+bool ChimpTimerWheel::cancel(const TimerId id)
+{
+    const Timer* const timer = find(id);
+    if(!timer)
+        return false;
+    const uint32_t index = static_cast<uint32_t>(timer - timers.data());
+    unlink(index);
+    release(index);
+    return true;
+}
+
+/**
+ * @brief ChimpTimerWheel::isPending()
+ * 
+ * @return true if the timer hasn't run or been cancelled yet.
+ */
+bool ChimpTimerWheel::isPending(const TimerId id) const
+{
+    return find(id) != nullptr;
+}
+
+/**
+ * @brief ChimpTimerWheel::advance()
+ * 
+ * Moves time forward, running every timer that comes due, in the order they're due. Callbacks may schedule and cancel
+ * timers.
+ * 
+ * @param time Milliseconds of game time passed.
+ */
+void ChimpTimerWheel::advance(const uint32_t time)
+{
+    for(uint32_t i = 0; i < time; ++i)
+        run(current);
+}
+
+/**
+ * @brief ChimpTimerWheel::clear()
+ * 
+ * Cancels every timer. The pool keeps its size.
+ */
+void ChimpTimerWheel::clear()
+{
+    for(uint32_t slot = 0; slot <= SLOTS; ++slot)
+        while(heads[slot] != NONE)
+        {
+            const uint32_t index = heads[slot];
+            unlink(index);
+            release(index);
+        }
+}
+
+void ChimpTimerWheel::insert(const uint32_t index)
+{
+    const uint64_t expires = timers[index].expires;
+    uint64_t delta = expires > current ? expires - current : 0;
+    if(delta < ROOT_SLOTS)
+    {
+        link(index, static_cast<uint32_t>(std::max(expires, current) & (ROOT_SLOTS - 1)));
+        return;
+    }
+    
+    // Timers beyond the top level are kept in its furthest slot, and placed again each time it comes round.
+    const uint64_t span = uint64_t(1) << (ROOT_BITS + (LEVELS - 1) * LEVEL_BITS);
+    const uint64_t at = delta < span ? expires : current + span - 1;
+    delta = at - current;
+    int level = 1;
+    while(delta >= uint64_t(1) << (ROOT_BITS + level * LEVEL_BITS))
+        ++level;
+    const int shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+    link(index, ROOT_SLOTS + (level - 1) * LEVEL_SLOTS + ((at >> shift) & (LEVEL_SLOTS - 1)));
+}
+
+void ChimpTimerWheel::link(const uint32_t index, const uint32_t slot)
+{
+    Timer& timer = timers[index];
+    timer.slot = slot;
+    timer.prev = NONE;
+    timer.next = heads[slot];
+    if(timer.next != NONE)
+        timers[timer.next].prev = index;
+    heads[slot] = index;
+}
+
+void ChimpTimerWheel::unlink(const uint32_t index)
+{
+    Timer& timer = timers[index];
+    if(timer.prev != NONE)
+        timers[timer.prev].next = timer.next;
+    else
+        heads[timer.slot] = timer.next;
+    if(timer.next != NONE)
+        timers[timer.next].prev = timer.prev;
+}
+
+void ChimpTimerWheel::release(const uint32_t index)
+{
+    Timer& timer = timers[index];
+    timer.callback = nullptr;
+    timer.slot = NONE;
+    ++timer.generation;
+    if(timer.generation == 0) // never gives an id of 0
+        timer.generation = 1;
+    timer.next = freeTimers;
+    freeTimers = index;
+    --pending;
+}
+
+/**
+ * @brief ChimpTimerWheel::cascade()
+ * 
+ * Places the timers of a slot above the first level again, which moves them down a level or more now that the level
+ * below has come round to them.
+ */
+void ChimpTimerWheel::cascade(const int level, const uint32_t slot)
+{
+    const uint32_t head = ROOT_SLOTS + (level - 1) * LEVEL_SLOTS + slot;
+    uint32_t index = heads[head];
+    heads[head] = NONE;
+    while(index != NONE)
+    {
+        const uint32_t next = timers[index].next;
+        insert(index);
+        index = next;
+    }
+}
+
+/**
+ * @brief ChimpTimerWheel::run()
+ * 
+ * Runs the timers due at time, which is current, and moves current past it.
+ */
+void ChimpTimerWheel::run(const uint64_t time)
+{
+    const uint32_t root = static_cast<uint32_t>(time & (ROOT_SLOTS - 1));
+    for(int level = 1; level < LEVELS; ++level)
+    {
+        // When a level wraps, the next slot of the level above comes due.
+        const int shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+        if((time & ((uint64_t(1) << shift) - 1)) != 0)
+            break;
+        cascade(level, static_cast<uint32_t>((time >> shift) & (LEVEL_SLOTS - 1)));
+    }
+    
+    // Timers scheduled by the callbacks count from the next millisecond, and cancelling one still waiting here
+    // unlinks it from FIRING.
+    heads[FIRING] = heads[root];
+    heads[root] = NONE;
+    for(uint32_t index = heads[FIRING]; index != NONE; index = timers[index].next)
+        timers[index].slot = FIRING;
+    current = time + 1;
+    while(heads[FIRING] != NONE)
+    {
+        const uint32_t index = heads[FIRING];
+        unlink(index);
+        const TimerId id = static_cast<TimerId>(timers[index].generation) << 32 | (index + 1);
+        Callback callback = std::move(timers[index].callback);
+        release(index);
+        callback(id);
+    }
+}
+
+const ChimpTimerWheel::Timer* ChimpTimerWheel::find(const TimerId id) const
+{
+    const uint64_t index = (id & UINT32_MAX) - 1;
+    if(index >= timers.size())
+        return nullptr;
+    const Timer& timer = timers[index];
+    if(timer.slot == NONE || timer.generation != id >> 32)
+        return nullptr;
+    return &timer;
+}
+
+} // namespace chimp
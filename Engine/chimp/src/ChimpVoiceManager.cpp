@@ -0,0 +1,183 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpVoiceManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace chimp
+{
+
+/**
+ * @brief ChimpVoiceManager::ChimpVoiceManager()
+ * @param count Number of voices, played on mixer channels 0 to count - 1.
+ */
+ChimpVoiceManager::ChimpVoiceManager(const int count) : voices(count), plays(0)
+{
+}
+
+/**
+ * @brief ChimpVoiceManager::play()
+ * 
+ * Plays a sound once on a free voice, or on one taken from a less important sound.
+ * 
+ * @param gain Volume from 0 to 1.
+ * @param pan Stereo position from -1 (left) to 1 (right).
+ * @param id Names the sound for stop() and setPosition() while it plays.
+ * @return The channel the sound plays on, or -1 if it isn't played.
+ */
+int ChimpVoiceManager::play(Mix_Chunk* const chunk, const VoicePriority priority, const float gain, const float pan,
+                            const VoiceId id)
+{
+    if(!chunk || gain <= 0)
+        return -1;
+    const int channel = findVoice(priority, gain);
+    if(channel < 0)
+        return -1;
+    
+    Mix_HaltChannel(channel); // if the voice is stolen
+    place(channel, gain, pan);
+    if(Mix_PlayChannel(channel, chunk, 0) < 0)
+    {
+        std::cerr << "Mix_PlayChannel error: " << SDL_GetError() << std::endl;
+        return -1;
+    }
+    voices[channel].priority = priority;
+    voices[channel].gain = gain;
+    voices[channel].started = plays++;
+    voices[channel].id = id;
+    return channel;
+}
+
+/**
+ * @brief ChimpVoiceManager::stop()
+ * 
+ * Stops a sound started with an id, if it's still playing.
+ */
+void ChimpVoiceManager::stop(const VoiceId id)
+{
+    const int channel = findChannel(id);
+    if(channel >= 0)
+        Mix_HaltChannel(channel);
+}
+
+/**
+ * @brief ChimpVoiceManager::stopAll()
+ */
+void ChimpVoiceManager::stopAll()
+{
+    for(int channel = 0; channel < size(); ++channel)
+        Mix_HaltChannel(channel);
+}
+
+/**
+ * @brief ChimpVoiceManager::setPosition()
+ * 
+ * Changes the volume and stereo position of a sound started with an id, if it's still playing. It keeps its place
+ * among the voices by the gain it started with.
+ */
+void ChimpVoiceManager::setPosition(const VoiceId id, const float gain, const float pan)
+{
+    const int channel = findChannel(id);
+    if(channel >= 0)
+        place(channel, gain, pan);
+}
+
+/**
+ * @brief ChimpVoiceManager::locate()
+ * 
+ * Works out how a sound made by something in the world is heard: at full volume if it's in view, fading out linearly
+ * with distance from the view, and panned by its horizontal position.
+ * 
+ * @param source Bounds of what makes the sound.
+ * @param view Bounds of what's on screen.
+ * @param zone Distance from the view at which sounds become inaudible.
+ * @param gain Set to the volume, from 0 to 1.
+ * @param pan Set to the stereo position, from -1 (left) to 1 (right).
+ * @return false if the sound is too far away to hear.
+ */
+bool ChimpVoiceManager::locate(const Box<float>& source, const IntBox& view, const int zone, float& gain, float& pan)
+{
+    const float horiz = std::max(view.l - source.r, source.l - view.r);
+    const float vert = std::max(view.t - source.b, source.t - view.b);
+    float distance = 0;
+    if(horiz > 0 && vert > 0)
+        distance = std::sqrt(horiz*horiz + vert*vert);
+    else
+        distance = std::max(0.0f, std::max(horiz, vert));
+    if(zone <= 0 || distance >= zone)
+        return false;
+    
+    const float offset = (source.l + source.r - view.l - view.r) / 2;
+    const float halfWidth = (view.r - view.l) / 2.0f + zone;
+    gain = 1 - distance / zone;
+    pan = offset / halfWidth;
+    return true;
+}
+
+/**
+ * @brief ChimpVoiceManager::findVoice()
+ * 
+ * @return A free channel if there is one, else the channel of the least important sound if it's less important than
+ * a new one with priority and gain, else -1.
+ */
+int ChimpVoiceManager::findVoice(const VoicePriority priority, const float gain) const
+{
+    int weakest = -1;
+    for(int channel = 0; channel < size(); ++channel)
+    {
+        if(!Mix_Playing(channel))
+            return channel;
+        const Voice& voice = voices[channel];
+        if(weakest < 0)
+        {
+            weakest = channel;
+            continue;
+        }
+        const Voice& weak = voices[weakest];
+        if(voice.priority != weak.priority ? voice.priority < weak.priority
+           : voice.gain != weak.gain ? voice.gain < weak.gain : voice.started < weak.started)
+            weakest = channel;
+    }
+    if(weakest < 0)
+        return -1;
+    const Voice& weak = voices[weakest];
+    return priority > weak.priority || (priority == weak.priority && gain > weak.gain) ? weakest : -1;
+}
+
+int ChimpVoiceManager::findChannel(const VoiceId id) const
+{
+    if(id == 0)
+        return -1;
+    for(int channel = 0; channel < size(); ++channel)
+        if(voices[channel].id == id)
+            return Mix_Playing(channel) ? channel : -1;
+    return -1;
+}
+
+void ChimpVoiceManager::place(const int channel, const float gain, const float pan)
+{
+    Mix_Volume(channel, static_cast<int>(std::lround(std::max(0.0f, std::min(gain, 1.0f)) * MIX_MAX_VOLUME)));
+    const float angle = 90 * std::max(-1.0f, std::min(pan, 1.0f)); // degrees clockwise from straight ahead
+    Mix_SetPosition(channel, static_cast<Sint16>(angle < 0 ? angle + 360 : angle), 0);
+}
+
+} // namespace chimp
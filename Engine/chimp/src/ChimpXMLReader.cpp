@@ -0,0 +1,309 @@
+/*
+    Copyright 2016 Jeffrey Thomas Piercy
+
+    This file is part of Chimp Engine.
+
+    Chimp Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Chimp Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Chimp Engine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChimpXMLReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace chimp
+{
+
+namespace
+{
+    inline bool isWhiteSpace(const char c)
+    {
+        return static_cast<unsigned char>(c) < 128 && std::isspace(static_cast<unsigned char>(c));
+    }
+    
+    inline bool isNameStart(const char c)
+    {
+        const unsigned char u = static_cast<unsigned char>(c);
+        return u >= 128 || std::isalpha(u) || c == ':' || c == '_';
+    }
+    
+    inline bool isNameChar(const char c)
+    {
+        return isNameStart(c) || std::isdigit(static_cast<unsigned char>(c)) || c == '.' || c == '-';
+    }
+    
+    void appendUtf8(std::string& out, const unsigned long code)
+    {
+        if(code < 0x80)
+            out += char(code);
+        else if(code < 0x800)
+        {
+            out += char(0xC0 | (code >> 6));
+            out += char(0x80 | (code & 0x3F));
+        }
+        else if(code < 0x10000)
+        {
+            out += char(0xE0 | (code >> 12));
+            out += char(0x80 | ((code >> 6) & 0x3F));
+            out += char(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += char(0xF0 | (code >> 18));
+            out += char(0x80 | ((code >> 12) & 0x3F));
+            out += char(0x80 | ((code >> 6) & 0x3F));
+            out += char(0x80 | (code & 0x3F));
+        }
+    }
+    
+    /*
+     * Decodes the entity starting at from, which points at '&'. Returns where it ends, or from if it isn't an entity
+     * tinyxml2 would decode, in which case the '&' is kept as is.
+     */
+    const char* decodeEntity(const char* const from, const char* const to, std::string& out)
+    {
+        static const struct { const char* name; char value; } named[] =
+            { {"&quot;", '"'}, {"&amp;", '&'}, {"&apos;", '\''}, {"&lt;", '<'}, {"&gt;", '>'} };
+        for(const auto& entity : named)
+        {
+            const size_t length = std::strlen(entity.name);
+            if(size_t(to - from) >= length && std::memcmp(from, entity.name, length) == 0)
+            {
+                out += entity.value;
+                return from + length;
+            }
+        }
+        
+        if(to - from < 4 || from[1] != '#')
+            return from;
+        const bool hex = from[2] == 'x';
+        const char* digit = from + (hex ? 3 : 2);
+        unsigned long code = 0;
+        for(; digit < to && *digit != ';'; ++digit)
+        {
+            const unsigned char c = static_cast<unsigned char>(*digit);
+            if(hex && std::isxdigit(c))
+                code = code * 16 + (std::isdigit(c) ? c - '0' : std::tolower(c) - 'a' + 10);
+            else if(!hex && std::isdigit(c))
+                code = code * 10 + (c - '0');
+            else
+                return from;
+            if(code > 0x10FFFF)
+                return from;
+        }
+        if(digit == to || digit == from + (hex ? 3 : 2))
+            return from;
+        appendUtf8(out, code);
+        return digit + 1;
+    }
+}
+
+/**
+ * @brief ChimpXMLReader::ChimpXMLReader()
+ * @param data XML to read. Doesn't need to be NUL terminated, but has to outlive the reader.
+ */
+ChimpXMLReader::ChimpXMLReader(const char* const data, const size_t size)
+    : begin(data), end(data + size), p(data), attributeCount(0), openCount(0), closePending(false)
+{
+    if(size >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0) // UTF-8 BOM
+        p += 3;
+}
+
+/**
+ * @brief ChimpXMLReader::next()
+ * 
+ * Reads the next event. After XML_DONE or XML_ERROR, keeps returning XML_DONE.
+ */
+ChimpXMLReader::Event ChimpXMLReader::next()
+{
+    if(closePending)
+    {
+        closePending = false;
+        --openCount;
+        return XML_END;
+    }
+    
+    const char* const textStart = p;
+    while(p < end && isWhiteSpace(*p))
+        ++p;
+    if(p == end)
+        return openCount ? fail(("<" + open[openCount - 1] + "> is never closed").c_str()) : XML_DONE;
+    if(*p != '<') // text keeps its leading whitespace, like tinyxml2
+    {
+        const char* const stop = std::find(p, end, '<');
+        readText(textStart, stop, textValue, true);
+        p = stop;
+        return XML_TEXT;
+    }
+    if(startsWith("<?"))
+        return skipPast("?>") ? XML_OTHER : fail("unterminated declaration");
+    if(startsWith("<!--"))
+        return skipPast("-->") ? XML_OTHER : fail("unterminated comment");
+    if(startsWith("<![CDATA["))
+    {
+        static const char terminator[] = "]]>";
+        p += 9;
+        const char* const stop = std::search(p, end, terminator, terminator + 3);
+        if(stop == end)
+            return fail("unterminated CDATA section");
+        readText(p, stop, textValue, false);
+        p = stop + 3;
+        return XML_TEXT;
+    }
+    if(startsWith("<!"))
+        return skipPast(">") ? XML_OTHER : fail("unterminated DTD");
+    if(startsWith("</"))
+        return readEnd();
+    return readStart();
+}
+
+/**
+ * @brief ChimpXMLReader::attribute()
+ * @return The decoded value of the current element's attribute, or nullptr if it doesn't have one by that name.
+ */
+const char* ChimpXMLReader::attribute(const char* const attributeName) const
+{
+    for(size_t i = 0; i < attributeCount; ++i)
+        if(attributes[i].first == attributeName)
+            return attributes[i].second.c_str();
+    return nullptr;
+}
+
+ChimpXMLReader::Event ChimpXMLReader::readStart()
+{
+    ++p; // '<'
+    if(!readName(elementName))
+        return fail("malformed element name");
+    attributeCount = 0;
+    while(true)
+    {
+        while(p < end && isWhiteSpace(*p))
+            ++p;
+        if(p == end)
+            return fail("unterminated element");
+        if(*p == '>' || startsWith("/>"))
+        {
+            closePending = *p == '/';
+            p += closePending ? 2 : 1;
+            if(openCount == open.size())
+                open.emplace_back();
+            open[openCount++] = elementName;
+            return XML_START;
+        }
+        
+        if(attributeCount == attributes.size())
+            attributes.emplace_back();
+        std::pair<std::string, std::string>& attr = attributes[attributeCount];
+        if(!readName(attr.first))
+            return fail("malformed attribute name");
+        while(p < end && isWhiteSpace(*p))
+            ++p;
+        if(p == end || *p != '=')
+            return fail("attribute without a value");
+        ++p;
+        while(p < end && isWhiteSpace(*p))
+            ++p;
+        if(p == end || (*p != '"' && *p != '\''))
+            return fail("attribute value not in quotes");
+        const char* const stop = std::find(p + 1, end, *p);
+        if(stop == end)
+            return fail("unterminated attribute value");
+        readText(p + 1, stop, attr.second, true);
+        p = stop + 1;
+        ++attributeCount;
+    }
+}
+
+ChimpXMLReader::Event ChimpXMLReader::readEnd()
+{
+    p += 2; // "</"
+    if(!readName(elementName))
+        return fail("malformed end tag");
+    while(p < end && isWhiteSpace(*p))
+        ++p;
+    if(p == end || *p != '>')
+        return fail("unterminated end tag");
+    ++p;
+    if(openCount == 0 || open[openCount - 1] != elementName)
+        return fail(("unexpected </" + elementName + ">").c_str());
+    --openCount;
+    return XML_END;
+}
+
+bool ChimpXMLReader::readName(std::string& out)
+{
+    if(p == end || !isNameStart(*p))
+        return false;
+    const char* const start = p;
+    while(p < end && isNameChar(*p))
+        ++p;
+    out.assign(start, p);
+    return true;
+}
+
+/*
+ * Copies [from, to) into out, turning "\r\n" and lone '\r' into '\n' and, if decode is set, decoding entities.
+ */
+void ChimpXMLReader::readText(const char* from, const char* const to, std::string& out, const bool decode)
+{
+    out.clear();
+    while(from < to)
+    {
+        if(*from == '\r')
+        {
+            out += '\n';
+            from += from + 1 < to && from[1] == '\n' ? 2 : 1;
+        }
+        else if(decode && *from == '&')
+        {
+            const char* const next = decodeEntity(from, to, out);
+            if(next == from)
+                out += *from++;
+            else
+                from = next;
+        }
+        else
+            out += *from++;
+    }
+}
+
+bool ChimpXMLReader::startsWith(const char* const prefix) const
+{
+    const size_t length = std::strlen(prefix);
+    return size_t(end - p) >= length && std::memcmp(p, prefix, length) == 0;
+}
+
+bool ChimpXMLReader::skipPast(const char* const terminator)
+{
+    const char* const found = std::search(p, end, terminator, terminator + std::strlen(terminator));
+    if(found == end)
+        return false;
+    p = found + std::strlen(terminator);
+    return true;
+}
+
+/*
+ * Stops reading and records where it went wrong.
+ */
+ChimpXMLReader::Event ChimpXMLReader::fail(const char* const message)
+{
+    errorMessage = "line " + std::to_string(1 + std::count(begin, p, '\n')) + ": " + message;
+    p = end;
+    openCount = 0;
+    closePending = false;
+    return XML_ERROR;
+}
+
+} // namespace chimp
@@ -9,6 +9,7 @@ static constexpr int
     SCREEN_HEIGHT              = 690,
     ACTIVE_ZONE                = 750,   // Mobiles activate when this far from the screen.
     INACTIVE_ZONE              = 1500,  // Mobiles deactivate when this far from the screen
+    STREAM_DISTANCE            = SCREEN_WIDTH, // default distance from the screen that level sections load within
     FOLLOW_ZONE_X              = 375,   // minimum horizontal distance from player to screen edge
     FOLLOW_ZONE_Y              = SCREEN_HEIGHT / 4, // maximum vertical distance from player to screen edge
     JOYSTICK_DEAD_ZONE         = 8000,
@@ -21,7 +22,17 @@ static constexpr int
     DAMAGE                     = 10,   // default damage dealt
     MAX_JUMPS                  = 1,    // default maximum number of Mobile jumps before landing
     MS_PER_ACCEL               = 17,   // miliseconds between accelerate() calls
-    MAX_FRAME_TIME             = 50;
+    MAX_FRAME_TIME             = 50,
+    FRAME_SPIN_TIME            = 2,    // last miliseconds the frame limiter spins, at most a quarter of the frame
+    SIMULATION_RATE            = 1000, // most updates per second --pipelined runs without --fps
+    HEADLESS_FRAMES            = 600,  // default number of frames run by --headless
+    HEADLESS_FRAME_TIME        = 17,   // fixed miliseconds per frame in headless mode
+    PROFILE_ZONES              = 65536, // zones --profile keeps per thread, oldest overwritten first
+    JOB_THREADS                = 0,    // job system workers; 0 is one per core, less one left to the main thread
+    AUDIO_VOICES               = 16,   // mixer channels sounds play on; the least important is stolen when all are busy
+    AUDIO_QUEUE_SIZE           = 256,  // audio commands waiting for the audio thread at most; more are dropped
+    BENCH_OBJECTS              = 100000, // objects in the synthetic level timed by --bench-xml
+    BENCH_RUNS                 = 5;    // --bench-xml reports the best of this many runs
 
 static const Uint32
     TIME_PER_IDLE              = 600;  // miliseconds per idle animation frame
@@ -49,10 +60,16 @@ static const std::string
     TILES_FILE                 = ASSETS_PATH + "tiles",
     FONT_FILE                  = "LiberationSans-Bold.ttf",
     CONTROLLER_MAP_FILE        = "gamecontrollerdb",
+    PACK_FILE                  = "assets.pak",  // used instead of loose asset files when present
+    STARTUP_REPORT_FILE        = "startup_trace.json", // timeline written by --startup-report
+    PROFILE_FILE               = "profile_", // numbered and written by --profile on F9 or SIGUSR1
+    BENCH_LEVEL_FILE           = "bench_level.xml", // scratch file written and removed by --bench-xml
     TEXT_HEALTH                = "Health: ",
     GAME_OVER_TEXT             = "GAME OVER";
 
 static const SDL_Color
-    FONT_COLOR                 = {0, 0, 0, 255}; // HUD font color
+    FONT_COLOR                 = {0, 0, 0, 255},       // HUD font color
+    TINT_NONE                  = {255, 255, 255, 255},
+    TINT_DAMAGED               = {255, 0, 0, 255};     // Character color while invulnerable
 
 #endif // CHIMPCONSTANTS_H
@@ -18,7 +18,15 @@
 */
 
 #include "cleanup.h"
+#include "ChimpAssetPack.h"
+#include "ChimpCookedLevel.h"
+#include "ChimpFrameClock.h"
 #include "ChimpGame.h"
+#include "ChimpInitGraph.h"
+#include "ChimpProfiler.h"
+#include "ChimpScreen.h"
+#include "ChimpStartupTrace.h"
+#include "ChimpTextRenderer.h"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_gamecontroller.h>
@@ -33,14 +41,63 @@
 #include <SDL2_mixer/SDL_mixer.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <tinyxml2.h>
 #include <lua.hpp>
 
 typedef chimp::Coordinate Dimensions;
 
+struct SimulationInput // events handed from the main thread to the simulation thread in pipelined mode
+{
+    std::mutex mutex;
+    std::vector<SDL_Event> events;
+    bool levelSwitchRequested = false; // set by the simulation thread, which waits until the main thread clears it
+    std::condition_variable levelSwitched;
+};
+
+struct ScriptedEvent // input fed to the game at the start of a given frame in headless mode
+{
+    int frame;
+    SDL_Event event;
+};
+
+struct HeadlessOptions
+{
+    bool enabled = false;
+    int frames = HEADLESS_FRAMES;
+    std::string inputScript;
+    std::vector<int> captureFrames; // sorted
+    std::string capturePrefix = "frame_";
+};
+
+void runSequential(SDL_Window* const window, chimp::ChimpScreen& screen, chimp::ChimpTextRenderer& hud,
+                   chimp::ChimpGame& game, std::vector<SDL_GameController*>& controllers,
+                   Dimensions& windowDimensions, const double frameRate);
+void runPipelined(SDL_Window* const window, chimp::ChimpScreen& screen, chimp::ChimpTextRenderer& hud,
+                  chimp::ChimpGame& game, std::vector<SDL_GameController*>& controllers,
+                  Dimensions& windowDimensions, const double frameRate);
+void runHeadless(SDL_Surface* const frame, chimp::ChimpScreen& screen, chimp::ChimpTextRenderer& hud,
+                 chimp::ChimpGame& game, const HeadlessOptions& options, const std::vector<ScriptedEvent>& script);
+void simulate(chimp::ChimpGame& game, chimp::ChimpRenderPipeline& pipeline, SimulationInput& input,
+              const std::atomic<bool>& quit, const double frameRate);
+
 inline void addController(const int id, std::vector<SDL_GameController*>& controllers);
+inline void handleInput(const SDL_Event& event, chimp::ChimpGame& game, bool& keyJumpPressed);
 inline void keyDown(const SDL_Event& event, chimp::ChimpGame& game, bool& keyJumpPressed);
 inline void keyUp(const SDL_Event& event, chimp::ChimpGame& game, bool& keyJumpPressed);
 inline void buttonDown(const SDL_Event& event, chimp::ChimpGame& game, bool& keyJumpPressed);
@@ -48,163 +105,552 @@ inline void buttonUp(const SDL_Event& event, chimp::ChimpGame& game, bool& keyJu
 inline void axisMotion(const SDL_Event& event, chimp::ChimpGame& game);
 
 inline void controllerAdded(const SDL_Event& event, std::vector<SDL_GameController*>& controllers);
-void renderTexture(SDL_Texture* const tex, SDL_Renderer* const renderer, const int x, const int y,
-                   SDL_Rect* const clip = nullptr);
-SDL_Texture* renderText(const std::string& message, TTF_Font* const font, const SDL_Color color,
-                        SDL_Renderer* const renderer);
-void drawHUD(chimp::ChimpGame& game, SDL_Renderer* const renderer, TTF_Font* font, SDL_Texture* const healthTex);
+void drawHUD(const int health, const bool gameOver, chimp::ChimpTextRenderer& hud);
+inline Uint64 endPhase(const char* const name, const Uint64 start);
+void requestProfile(int);
 
+bool createRenderer(const bool headless, const bool upscale, SDL_Window*& window, SDL_Renderer*& renderer,
+                    SDL_Surface*& frameSurface);
+bool cookLevel(const std::string& levelFile, const std::string& cookedFile);
+bool packAssets(const std::string& levelFile, const std::string& packFile, const bool compress);
+bool benchXML(const std::string& levelFile);
+bool parseResolution(const std::string& arg, Dimensions& resolution);
+bool parseFrameList(const std::string& arg, std::vector<int>& frames);
+bool loadInputScript(const std::string& file, std::vector<ScriptedEvent>& script);
+void windowResized(SDL_Event& event, SDL_Window* const window, chimp::ChimpScreen& screen,
+                   Dimensions& windowDimensions, const chimp::ChimpGame& game);
 void resize(SDL_Event& event, Dimensions& windowDimensions, SDL_Renderer* const renderer, const chimp::ChimpGame& game);
 
 int main(const int argc, char** argv) // Don't mess with the signature, or else suffer "undefined reference to `SDL_main'" errors on Windows
 {
-    SDL_Window* window;
-    SDL_Renderer* renderer;
-    TTF_Font* font;
+    SDL_Window* window = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    SDL_Surface* frameSurface = nullptr; // headless render target
     std::vector<SDL_GameController*> controllers;
+    std::vector<ScriptedEvent> script;
+    HeadlessOptions headless;
+    std::string levelFile = ASSETS_PATH + DEFAULT_LEVEL;
+    std::string cookedFile, packFile;
+    bool compressPack = false;
+    bool pipelined = false;
+    bool upscale = false, integerScale = false;
+    bool assetTimings = false;
+    bool startupReport = false;
+    bool benchmarkXML = false;
+    bool jobReport = false;
+    bool profile = false;
+    int jobThreads = JOB_THREADS;
+    double frameRate = 0; // unlimited
+    Dimensions resolution = { SCREEN_WIDTH, SCREEN_HEIGHT };
+    const char* const valueFlags[] = { "--cook", "--pack", "--threads", "--fps", "--frames", "--input", "--capture",
+                                       "--capture-prefix", "--resolution" };
     
-    if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER | SDL_INIT_TIMER) < 0)
+    for(int i = 1; i < argc; ++i)
     {
-        std::cerr << "SDL_Init error: " << SDL_GetError() << std::endl;
-        return 1;
+        const std::string arg = argv[i];
+        if(i + 1 >= argc && std::find(std::begin(valueFlags), std::end(valueFlags), arg) != std::end(valueFlags))
+        {
+            std::cerr << "Missing value for " << arg << std::endl; // rather than taking it for the level file
+            return 1;
+        }
+        if(arg == "--pipelined")
+            pipelined = true;
+        else if(arg == "--upscale")
+            upscale = true;
+        else if(arg == "--integer-scale")
+            upscale = integerScale = true;
+        else if(arg == "--cook")
+            cookedFile = argv[++i];
+        else if(arg == "--pack")
+            packFile = argv[++i];
+        else if(arg == "--lz4")
+            compressPack = true;
+        else if(arg == "--asset-timings")
+            assetTimings = true;
+        else if(arg == "--startup-report")
+            startupReport = true;
+        else if(arg == "--bench-xml")
+            benchmarkXML = true;
+        else if(arg == "--threads")
+            jobThreads = std::max(0, std::atoi(argv[++i]));
+        else if(arg == "--job-report")
+            jobReport = true;
+        else if(arg == "--fps")
+            frameRate = std::atof(argv[++i]);
+        else if(arg == "--profile")
+            profile = true;
+        else if(arg == "--headless")
+            headless.enabled = true;
+        else if(arg == "--frames")
+            headless.frames = std::atoi(argv[++i]);
+        else if(arg == "--input")
+            headless.inputScript = argv[++i];
+        else if(arg == "--capture")
+        {
+            if(!parseFrameList(argv[++i], headless.captureFrames))
+            {
+                std::cerr << "--capture expects a comma separated list of frame numbers, e.g. --capture 1,60,600"
+                          << std::endl;
+                return 1;
+            }
+        }
+        else if(arg == "--capture-prefix")
+            headless.capturePrefix = argv[++i];
+        else if(arg == "--resolution")
+        {
+            if(!parseResolution(argv[++i], resolution))
+            {
+                std::cerr << "--resolution expects WIDTHxHEIGHT, e.g. --resolution 600x345" << std::endl;
+                return 1;
+            }
+            upscale = true;
+        }
+        else
+        {
+            levelFile = arg;
+            if(levelFile[0] != '/' && !( levelFile[0] == '.' && (levelFile[1] == '.' || levelFile[1] == '/') )) //TODO: make Windows version of this
+                levelFile = ASSETS_PATH + levelFile;
+        }
     }
-    window = SDL_CreateWindow("Chimp Engine", 100, 100, SCREEN_WIDTH, SCREEN_HEIGHT,
-                              SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
-    if(window == nullptr)
+    
+    if(!cookedFile.empty()) // cooking needs neither SDL nor a window
+        return cookLevel(levelFile, cookedFile) ? 0 : 1;
+    if(!packFile.empty())
+        return packAssets(levelFile, packFile, compressPack) ? 0 : 1;
+    if(benchmarkXML)
+        return benchXML(levelFile) ? 0 : 1;
+    
+    chimp::ChimpStartupTrace& trace = chimp::ChimpStartupTrace::getTrace();
+    if(startupReport)
     {
-        std::cerr << "CreateWindow error: " << SDL_GetError() << std::endl;
-        SDL_Quit();
-        return 1;
+        trace.enable();
+        headless.frames = 1;
     }
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    //SDL_ShowCursor(false);
-    if(renderer == nullptr)
+    Uint64 phase = trace.now();
+    chimp::ChimpAssetPack::getPack().mount(PACK_FILE);
+    phase = endPhase("mount asset pack", phase);
+    
+    if(headless.enabled)
     {
-        std::cerr << "CreateRenderer error: " << SDL_GetError() << std::endl;
-        cleanup(window);
-        SDL_Quit();
-        return 1;
+        if(!headless.inputScript.empty() && !loadInputScript(headless.inputScript, script))
+            return 1;
+        // no display or sound card needed; must be set before SDL_Init
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
     }
-    if((IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) != IMG_INIT_PNG)
+    
+    // SDL's subsystems can't be initialized concurrently, so they all come up here first. Everything after that is a
+    // graph of tasks, so the independent parts of startup overlap.
+    if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER | SDL_INIT_TIMER | SDL_INIT_AUDIO) < 0)
     {
-        std::cerr << "IMG_Init error: " << SDL_GetError() << std::endl;
-        cleanup(window, renderer);
-        SDL_Quit();
+        std::cerr << "SDL_Init error: " << SDL_GetError() << std::endl;
         return 1;
     }
-    if(TTF_Init() != 0)
+    phase = endPhase("SDL_Init", phase);
+    if(profile)
     {
-        std::cerr << "TTF_Init error: " << SDL_GetError() << std::endl;
-        cleanup(window, renderer);
-        SDL_Quit();
-        return 1;
+        chimp::ChimpProfiler::getProfiler().enable();
+        chimp::ChimpProfiler::getProfiler().setThreadName("main");
+#if defined (__gnu_linux__) || (defined (__APPLE__) && defined (__MACH__))
+        std::signal(SIGUSR1, requestProfile); // kill -USR1 <pid> writes a profile, like F9
+#endif
     }
-    font = TTF_OpenFont( (ASSETS_PATH + FONT_FILE).c_str(), FONT_SIZE );
-    if(font == nullptr)
+    
+    chimp::ChimpJobSystem jobs(jobThreads); // runs startup tasks, then decodes assets and builds level sections
+    chimp::ChimpTextRenderer hud(nullptr, ASSETS_PATH + FONT_FILE);
+    chimp::ChimpGame game(nullptr, SCREEN_WIDTH, SCREEN_HEIGHT, jobs);
+    bool mappingsLoaded = false;
+    game.setSynchronousStreaming(headless.enabled); // keeps headless runs deterministic
+    
+    chimp::ChimpInitGraph init;
+    typedef chimp::ChimpInitGraph::TaskId TaskId;
+    const TaskId video = init.add("create window and renderer", [&]
     {
-        std::cerr << "TTF_OpenFont error: " << SDL_GetError() << std::endl;
-        cleanup(window, renderer, font);
-        SDL_Quit();
-        return 1;
-    }
-    if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
+        if(!createRenderer(headless.enabled, upscale, window, renderer, frameSurface))
+            return false;
+        game.setRenderer(renderer);
+        hud.setRenderer(renderer);
+        return true;
+    }, {}, true);
+    const TaskId image = init.add("IMG_Init", []
+    {
+        if((IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) == IMG_INIT_PNG)
+            return true;
+        std::cerr << "IMG_Init error: " << SDL_GetError() << std::endl;
+        return false;
+    });
+    const TaskId ttf = init.add("TTF_Init", []
+    {
+        if(TTF_Init() == 0)
+            return true;
+        std::cerr << "TTF_Init error: " << SDL_GetError() << std::endl;
+        return false;
+    });
+    const TaskId font = init.add("rasterize font", [&hud] { return hud.rasterize(FONT_SIZE); }, {ttf});
+    init.add("upload font", [&hud] { return hud.loadSize(FONT_SIZE); }, {video, font}, true);
+    const TaskId audio = init.add("Mix_OpenAudio", []
     {
+        if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) == 0)
+        {
+            Mix_AllocateChannels(AUDIO_VOICES); // played on by the game's ChimpAudioService
+            return true;
+        }
         std::cerr << "Mix_OpenAudio error: " << SDL_GetError() << std::endl;
-        cleanup(window, renderer, font);
+        return false;
+    });
+    const TaskId mappings = init.add("controller mappings", [&mappingsLoaded]
+    {
+        mappingsLoaded = SDL_GameControllerAddMappingsFromRW(
+            chimp::ChimpAssetPack::getPack().openRW(CONTROLLER_MAP_FILE), 1) != -1;
+        if(!mappingsLoaded)
+            std::cerr << "GameControllerAddMappingsFromRW error: " << SDL_GetError() << std::endl;
+        return true; // playable without controllers
+    });
+    init.add("open controllers", [&mappingsLoaded, &controllers]
+    {
+        if(mappingsLoaded)
+            for(int i = 0; i < SDL_NumJoysticks(); ++i)
+                addController(i, controllers);
+        return true;
+    }, {mappings}, true);
+    const TaskId level = init.add("read level", [&game, &levelFile]
+    {
+        if(game.openLevel(levelFile) == tinyxml2::XML_SUCCESS)
+            return true;
+        std::cerr << "Couldn't load level file \"" << levelFile << "\"." << std::endl;
+        return false;
+    });
+    const TaskId decode = init.add("decode level assets", [&game] { game.decodeOpenedLevel(); return true; },
+                                   {level, image, audio});
+    const TaskId build = init.add("build level", [&game, &levelFile]
+    {
+        if(game.buildOpenedLevel() == tinyxml2::XML_SUCCESS)
+            return true;
+        std::cerr << "Couldn't load level file \"" << levelFile << "\"." << std::endl;
+        return false;
+    }, {video, decode}, true);
+    init.add("initialize", [&game, assetTimings]
+    {
+        if(assetTimings)
+            chimp::ChimpAssetLoader::report(game.getAssetTimings(), std::cout);
+        game.initialize();
+        return true;
+    }, {build}, true);
+    
+    if(!init.run(jobs))
+    {
+        hud.clear();
+        cleanup(window, renderer, frameSurface, &controllers);
         SDL_Quit();
         return 1;
     }
-    if(SDL_GameControllerAddMappingsFromFile(CONTROLLER_MAP_FILE.c_str()) == -1)
-        std::cerr << "GameControllerAddMappingsFromFile error: " << SDL_GetError() << std::endl;
-    else
-        for(int i = 0; i < SDL_NumJoysticks(); ++i)
-            addController(i, controllers);
+    phase = trace.now();
     
-    SDL_Event event;
-    bool quit = false;
-    bool keyJumpPressed = false;
-    chimp::ChimpGame game(renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
-    SDL_Texture* healthTex = renderText(TEXT_HEALTH, font, FONT_COLOR, renderer);
-    decltype(SDL_GetTicks()) timeLast, timeNow;
-    std::string levelFile = ASSETS_PATH + DEFAULT_LEVEL;
+    chimp::ChimpScreen screen(renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
     Dimensions windowDimensions = { SCREEN_WIDTH, SCREEN_HEIGHT };
+    if(upscale && !screen.setInternalResolution(resolution.x, resolution.y, integerScale))
+        std::cerr << "Couldn't create internal render target, drawing straight to the window." << std::endl;
+    phase = endPhase("create screen", phase);
+    
+    if(headless.enabled)
+        runHeadless(frameSurface, screen, hud, game, headless, script);
+    else if(pipelined)
+        runPipelined(window, screen, hud, game, controllers, windowDimensions, frameRate);
+    else
+        runSequential(window, screen, hud, game, controllers, windowDimensions, frameRate);
     
-    if(argc > 1)
+    if(startupReport)
     {
-        levelFile = argv[1];
-        if(levelFile[0] != '/' && !( levelFile[0] == '.' && (levelFile[1] == '.' || levelFile[1] == '/') )) //TODO: make Windows version of this
-            levelFile = ASSETS_PATH + levelFile;
+        endPhase("first frame", phase);
+        trace.report(std::cout);
+        init.report(std::cout);
+        trace.write(STARTUP_REPORT_FILE);
     }
-    if(game.loadLevel(levelFile) != tinyxml2::XML_SUCCESS)
+    if(jobReport)
+        jobs.report(std::cout);
+    if(profile && headless.enabled) // headless runs can't press F9, so they always write one at the end
     {
-        std::cerr << "Couldn't load level file \"" << levelFile << "\"." << std::endl;
-        cleanup(window, renderer, font);
-        SDL_Quit();
-        return 1;
+        chimp::ChimpProfiler::getProfiler().requestWrite();
+        chimp::ChimpProfiler::getProfiler().writeIfRequested();
     }
+    screen.clear();
+    hud.clear();
+    cleanup(window, renderer, frameSurface, &controllers);
+    SDL_Quit();
+    return 0;
+}
+
+/**
+ * Default main loop: poll, update, render and present, one after another on the main thread, at most frameRate times
+ * a second (--fps) if it isn't 0.
+ */
+void runSequential(SDL_Window* const window, chimp::ChimpScreen& screen, chimp::ChimpTextRenderer& hud,
+                   chimp::ChimpGame& game, std::vector<SDL_GameController*>& controllers,
+                   Dimensions& windowDimensions, const double frameRate)
+{
+    SDL_Event event;
+    bool quit = false;
+    bool keyJumpPressed = false;
+    chimp::ChimpFrameClock clock(frameRate);
     
-    game.initialize();
-    
-    timeLast = SDL_GetTicks();
     while(!quit)
     {
-        while(SDL_PollEvent(&event))
+        chimp::ChimpProfiler::getProfiler().writeIfRequested();
+        chimp::ChimpProfileZone frame("frame");
         {
-            switch(event.type)
+            chimp::ChimpProfileZone zone("poll");
+            while(SDL_PollEvent(&event))
             {
-            case SDL_QUIT:
-                quit = true;
-                continue;
-            case SDL_KEYDOWN:
-                keyDown(event, game, keyJumpPressed);
-                break;
-            case SDL_KEYUP:
-                keyUp(event, game, keyJumpPressed);
-                break;
-            case SDL_CONTROLLERBUTTONDOWN:
-                buttonDown(event, game, keyJumpPressed);
-                break;
-            case SDL_CONTROLLERBUTTONUP:
-                buttonUp(event, game, keyJumpPressed);
-                break;
-            case SDL_CONTROLLERAXISMOTION:
-                axisMotion(event, game);
-                break;
-            case SDL_CONTROLLERDEVICEADDED:
-                addController(event.cdevice.which, controllers);
-                break;
-            case SDL_WINDOWEVENT:
-                if(event.window.event == SDL_WINDOWEVENT_RESIZED)
-                    resize(event, windowDimensions, renderer, game);
-                break;
+                switch(event.type)
+                {
+                case SDL_QUIT:
+                    quit = true;
+                    continue;
+                case SDL_CONTROLLERDEVICEADDED:
+                    addController(event.cdevice.which, controllers);
+                    break;
+                case SDL_WINDOWEVENT:
+                    if(event.window.event == SDL_WINDOWEVENT_RESIZED)
+                        windowResized(event, window, screen, windowDimensions, game);
+                    break;
+                default:
+                    handleInput(event, game, keyJumpPressed);
+                }
             }
         }
         
-        SDL_RenderClear(renderer);
+        screen.begin();
         
-        timeNow = SDL_GetTicks();
+        const double frameTime = clock.tick();
         /*static double numframes = 0;
         ++numframes;
-        std::cout << "FPS current: " << 1000 / float(timeNow-timeLast)
+        std::cout << "FPS current: " << 1000 / frameTime
                   << "\tFPS average: " << 1000 * numframes / SDL_GetTicks() << std::endl;*/
-        game.update(timeNow - timeLast);
-        timeLast = timeNow;
+        {
+            chimp::ChimpProfileZone zone("update");
+            game.update(frameTime);
+        }
+        if(game.isLevelChangePending())
+        {
+            if(game.switchLevel() != tinyxml2::XML_SUCCESS)
+            {
+                std::cerr << "Couldn't switch level." << std::endl;
+                return;
+            }
+            clock.restart();
+        }
         
         game.render();
-        drawHUD(game, renderer, font, healthTex);
-        SDL_RenderPresent(renderer);
+        drawHUD(game.getPlayer()->getHealth(), !game.getPlayer()->isActive(), hud);
+        screen.present();
+        if(chimp::ChimpStartupTrace::getTrace().isEnabled()) // --startup-report ends at the first frame
+            return;
         if(!game.getPlayer()->isActive())
         {
             SDL_Delay(GAME_OVER_TIME);
             game.reset();
         }
+        clock.limit();
+    }
+}
+
+/**
+ * Pipelined main loop (--pipelined). The simulation runs on its own thread and records each frame into a render
+ * packet, while this thread polls events and submits the most recent packet through SDL. Input events are forwarded to
+ * the simulation thread, which is the only thread that touches the game after this point, except while it waits for
+ * this thread to switch levels.
+ */
+void runPipelined(SDL_Window* const window, chimp::ChimpScreen& screen, chimp::ChimpTextRenderer& hud,
+                  chimp::ChimpGame& game, std::vector<SDL_GameController*>& controllers,
+                  Dimensions& windowDimensions, const double frameRate)
+{
+    SDL_Event event;
+    std::atomic<bool> quit(false);
+    SimulationInput input;
+    chimp::ChimpRenderPipeline pipeline;
+    std::thread simulation(simulate, std::ref(game), std::ref(pipeline), std::ref(input), std::cref(quit),
+                           frameRate);
+    
+    while(!quit)
+    {
+        chimp::ChimpProfiler::getProfiler().writeIfRequested();
+        chimp::ChimpProfileZone frame("frame");
+        {
+            chimp::ChimpProfileZone zone("poll");
+            while(SDL_PollEvent(&event))
+            {
+                switch(event.type)
+                {
+                case SDL_QUIT:
+                    quit = true;
+                    continue;
+                case SDL_CONTROLLERDEVICEADDED:
+                    addController(event.cdevice.which, controllers);
+                    break;
+                case SDL_WINDOWEVENT:
+                    if(event.window.event == SDL_WINDOWEVENT_RESIZED)
+                        windowResized(event, window, screen, windowDimensions, game);
+                    break;
+                default:
+                {
+                    std::lock_guard<std::mutex> lock(input.mutex);
+                    input.events.push_back(event);
+                }
+                }
+            }
+        }
         
-        SDL_SetWindowSize(window, windowDimensions.x, windowDimensions.y);
+        {
+            std::lock_guard<std::mutex> lock(input.mutex);
+            if(input.levelSwitchRequested) // the simulation thread is waiting, so the game is ours until it's woken
+            {
+                if(game.switchLevel() != tinyxml2::XML_SUCCESS)
+                {
+                    std::cerr << "Couldn't switch level." << std::endl;
+                    quit = true;
+                }
+                pipeline.acquire(); // drops any packet still referring to the old level's textures
+                input.levelSwitchRequested = false;
+                input.levelSwitched.notify_one();
+            }
+        }
+        
+        if(!pipeline.acquire()) // nothing new to draw yet
+        {
+            SDL_Delay(1);
+            continue;
+        }
+        
+        const chimp::ChimpRenderPacket& packet = pipeline.current();
+        screen.begin();
+        {
+            chimp::ChimpProfileZone zone("submit");
+            packet.submit(screen.getRenderer());
+        }
+        drawHUD(packet.health, packet.gameOver, hud);
+        screen.present();
+        if(chimp::ChimpStartupTrace::getTrace().isEnabled()) // --startup-report ends at the first frame
+            quit = true;
     }
     
-    cleanup(window, renderer, font, &controllers);
-    SDL_Quit();
-    return 0;
+    {
+        std::lock_guard<std::mutex> lock(input.mutex);
+        input.levelSwitched.notify_one(); // in case the simulation thread is waiting on a level switch
+    }
+    simulation.join();
+}
+
+/**
+ * Headless main loop (--headless). Renders into a software surface instead of a window, runs a fixed number of frames
+ * with a fixed frame time, feeds in scripted input, optionally saves chosen frames as PNGs and finally prints how long
+ * updating and rendering took. Nothing waits on wall clock time, so the same level and script always produce the same
+ * frames.
+ */
+void runHeadless(SDL_Surface* const frame, chimp::ChimpScreen& screen, chimp::ChimpTextRenderer& hud,
+                 chimp::ChimpGame& game, const HeadlessOptions& options, const std::vector<ScriptedEvent>& script)
+{
+    const double msPerCount = 1000.0 / SDL_GetPerformanceFrequency();
+    bool keyJumpPressed = false;
+    size_t nextEvent = 0, nextCapture = 0;
+    double updateTotal = 0, updateWorst = 0, renderTotal = 0, renderWorst = 0;
+    Uint64 start, end;
+    
+    const Uint64 runStart = SDL_GetPerformanceCounter();
+    for(int i = 1; i <= options.frames; ++i)
+    {
+        for(; nextEvent < script.size() && script[nextEvent].frame <= i; ++nextEvent)
+            handleInput(script[nextEvent].event, game, keyJumpPressed);
+        
+        chimp::ChimpProfileZone frameZone("frame");
+        start = SDL_GetPerformanceCounter();
+        game.update(HEADLESS_FRAME_TIME);
+        if(game.isLevelChangePending() && game.switchLevel() != tinyxml2::XML_SUCCESS)
+        {
+            std::cerr << "Couldn't switch level." << std::endl;
+            return;
+        }
+        end = SDL_GetPerformanceCounter();
+        const double updateTime = (end - start) * msPerCount;
+        updateTotal += updateTime;
+        updateWorst = std::max(updateWorst, updateTime);
+        
+        start = SDL_GetPerformanceCounter();
+        screen.begin();
+        game.render();
+        drawHUD(game.getPlayer()->getHealth(), !game.getPlayer()->isActive(), hud);
+        screen.present();
+        end = SDL_GetPerformanceCounter();
+        const double renderTime = (end - start) * msPerCount;
+        renderTotal += renderTime;
+        renderWorst = std::max(renderWorst, renderTime);
+        
+        for(; nextCapture < options.captureFrames.size() && options.captureFrames[nextCapture] <= i; ++nextCapture)
+        {
+            if(options.captureFrames[nextCapture] != i)
+                continue;
+            const std::string file = options.capturePrefix + std::to_string(i) + ".png";
+            if(IMG_SavePNG(frame, file.c_str()) != 0)
+                std::cerr << "IMG_SavePNG error: " << SDL_GetError() << std::endl;
+        }
+        
+        if(!game.getPlayer()->isActive())
+            game.reset();
+    }
+    const double runTime = (SDL_GetPerformanceCounter() - runStart) * msPerCount;
+    
+    if(options.frames > 0)
+        std::cout << "frames: " << options.frames << "\ttotal: " << runTime << " ms"
+                  << "\tfps: " << 1000.0 * options.frames / runTime << "\n"
+                  << "update: avg " << updateTotal / options.frames << " ms\tworst " << updateWorst << " ms\n"
+                  << "render: avg " << renderTotal / options.frames << " ms\tworst " << renderWorst << " ms"
+                  << std::endl;
+}
+
+/**
+ * Simulation thread body for the pipelined main loop. Applies forwarded input, updates the game and publishes a render
+ * packet for every frame, at most frameRate times a second, or SIMULATION_RATE if that's 0.
+ */
+void simulate(chimp::ChimpGame& game, chimp::ChimpRenderPipeline& pipeline, SimulationInput& input,
+              const std::atomic<bool>& quit, const double frameRate)
+{
+    std::vector<SDL_Event> events;
+    bool keyJumpPressed = false;
+    chimp::ChimpFrameClock clock(frameRate > 0 ? frameRate : SIMULATION_RATE);
+    chimp::ChimpProfiler::getProfiler().setThreadName("simulation");
+    
+    while(!quit)
+    {
+        chimp::ChimpProfileZone frame("frame");
+        {
+            std::lock_guard<std::mutex> lock(input.mutex);
+            events.swap(input.events);
+        }
+        for(const SDL_Event& event : events)
+            handleInput(event, game, keyJumpPressed);
+        events.clear();
+        
+        {
+            chimp::ChimpProfileZone zone("update");
+            game.update(clock.tick());
+        }
+        if(game.isLevelChangePending()) // textures can only be created on the main thread, so let it switch
+        {
+            std::unique_lock<std::mutex> lock(input.mutex);
+            input.levelSwitchRequested = true;
+            input.levelSwitched.wait(lock, [&input, &quit] { return !input.levelSwitchRequested || quit; });
+            clock.restart();
+            continue;
+        }
+        
+        game.record(pipeline.beginWrite());
+        pipeline.publish();
+        if(!game.getPlayer()->isActive())
+        {
+            SDL_Delay(GAME_OVER_TIME);
+            game.reset();
+        }
+        clock.limit();
+    }
 }
 
 inline void addController(const int id, std::vector<SDL_GameController*>& controllers)
@@ -213,6 +659,28 @@ inline void addController(const int id, std::vector<SDL_GameController*>& contro
         controllers.push_back(SDL_GameControllerOpen(id));
 }
 
+inline void handleInput(const SDL_Event& event, chimp::ChimpGame& game, bool& keyJumpPressed)
+{
+    switch(event.type)
+    {
+    case SDL_KEYDOWN:
+        keyDown(event, game, keyJumpPressed);
+        break;
+    case SDL_KEYUP:
+        keyUp(event, game, keyJumpPressed);
+        break;
+    case SDL_CONTROLLERBUTTONDOWN:
+        buttonDown(event, game, keyJumpPressed);
+        break;
+    case SDL_CONTROLLERBUTTONUP:
+        buttonUp(event, game, keyJumpPressed);
+        break;
+    case SDL_CONTROLLERAXISMOTION:
+        axisMotion(event, game);
+        break;
+    }
+}
+
 inline void keyDown(const SDL_Event& event, chimp::ChimpGame& game, bool& keyJumpPressed)
 {
     switch(event.key.keysym.sym)
@@ -234,6 +702,9 @@ inline void keyDown(const SDL_Event& event, chimp::ChimpGame& game, bool& keyJum
     case SDLK_x:
         game.getPlayer()->sprint();
         break;
+    case SDLK_F9: // picked up by the main loop at the start of the next frame
+        chimp::ChimpProfiler::getProfiler().requestWrite();
+        break;
     }
 }
 
@@ -293,78 +764,360 @@ inline void axisMotion(const SDL_Event& event, chimp::ChimpGame& game)
     }
 }
 
+void drawHUD(const int health, const bool gameOver, chimp::ChimpTextRenderer& hud)
+{
+    chimp::ChimpProfileZone zone("HUD");
+    static const int healthLabelWidth = hud.measure(TEXT_HEALTH.c_str(), FONT_SIZE);
+    static const int x = (SCREEN_WIDTH>>1) - healthLabelWidth;
+    static const int gameOverX = (SCREEN_WIDTH - hud.measure(GAME_OVER_TEXT.c_str(), FONT_SIZE)) >> 1;
+    static const int gameOverY = (SCREEN_HEIGHT - hud.getLineHeight(FONT_SIZE)) >> 1;
+    char healthText[16];
+    
+    snprintf(healthText, sizeof(healthText), "%d", health);
+    hud.draw(TEXT_HEALTH, x, 10, FONT_SIZE, FONT_COLOR);
+    hud.draw(healthText, x + healthLabelWidth, 10, FONT_SIZE, FONT_COLOR);
+    if(gameOver)
+        hud.draw(GAME_OVER_TEXT, gameOverX, gameOverY, FONT_SIZE, FONT_COLOR);
+    hud.flush();
+}
+
 /**
-* Draw an SDL_Texture to an SDL_Renderer at position x, y, preserving
-* the texture's width and height and taking a clip of the texture if desired
-* If a clip is passed, the clip's width and height will be used instead of
-*	the texture's
-* @param tex The source texture we want to draw
-* @param ren The renderer we want to draw to
-* @param x The x coordinate to draw to
-* @param y The y coordinate to draw to
-* @param clip The sub-section of the texture to draw (clipping rect)
-*		default of nullptr draws the entire texture
-*/
-void renderTexture(SDL_Texture* const tex, SDL_Renderer* const renderer, const int x, const int y,
-                   SDL_Rect* const clip)
+ * Records a phase of startup that began at start and ends now, for --startup-report.
+ * 
+ * @return The end of the phase, which is where the next one starts.
+ */
+inline Uint64 endPhase(const char* const name, const Uint64 start)
+{
+    const Uint64 end = chimp::ChimpStartupTrace::now();
+    chimp::ChimpStartupTrace::getTrace().record(name, "startup", start, end);
+    return end;
+}
+
+/**
+ * SIGUSR1 handler (--profile). Only sets a flag, so the profile is written by the main loop at the start of the next
+ * frame.
+ */
+void requestProfile(int)
+{
+    chimp::ChimpProfiler::getProfiler().requestWrite();
+}
+
+/**
+ * Creates the window and its renderer, or in headless mode a software renderer drawing into frameSurface. Whatever was
+ * created is left for the caller to clean up, even on failure.
+ */
+bool createRenderer(const bool headless, const bool upscale, SDL_Window*& window, SDL_Renderer*& renderer,
+                    SDL_Surface*& frameSurface)
+{
+    if(headless)
+    {
+        frameSurface = SDL_CreateRGBSurface(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+        if(frameSurface == nullptr)
+        {
+            std::cerr << "CreateRGBSurface error: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        renderer = SDL_CreateSoftwareRenderer(frameSurface);
+    }
+    else
+    {
+        window = SDL_CreateWindow("Chimp Engine", 100, 100, SCREEN_WIDTH, SCREEN_HEIGHT,
+                                  SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+        if(window == nullptr)
+        {
+            std::cerr << "CreateWindow error: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        renderer = SDL_CreateRenderer(window, -1,
+                                      SDL_RENDERER_ACCELERATED | (upscale ? SDL_RENDERER_TARGETTEXTURE : 0));
+    }
+    //SDL_ShowCursor(false);
+    if(renderer == nullptr)
+    {
+        std::cerr << "CreateRenderer error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Converts a level XML file into a cooked level file (--cook), which loads without any parsing. Cooked levels can be
+ * passed anywhere a level XML file can.
+ */
+bool cookLevel(const std::string& levelFile, const std::string& cookedFile)
+{
+    chimp::ChimpCookedLevel cooked;
+    
+    if(!cooked.cookFile(levelFile))
+    {
+        std::cerr << "Couldn't load level file \"" << levelFile << "\"." << std::endl;
+        return false;
+    }
+    return cooked.write(cookedFile);
+}
+
+/**
+ * Packs a level and every file it and the engine load into one asset pack (--pack), optionally LZ4 compressed (--lz4).
+ * The pack is used instead of loose files when it's found at PACK_FILE.
+ */
+bool packAssets(const std::string& levelFile, const std::string& packFile, const bool compress)
+{
+    chimp::ChimpCookedLevel level;
+    std::vector<std::string> files = { levelFile, ASSETS_PATH + FONT_FILE, CONTROLLER_MAP_FILE };
+    
+    if(chimp::ChimpCookedLevel::isCooked(levelFile))
+    {
+        if(!level.map(levelFile))
+            return false;
+    }
+    else if(!level.cookFile(levelFile))
+    {
+        std::cerr << "Couldn't load level file \"" << levelFile << "\"." << std::endl;
+        return false;
+    }
+    level.listFiles(files);
+    return chimp::ChimpAssetPack::write(packFile, files, compress);
+}
+
+/**
+ * Times reading level XML (--bench-xml) on a synthetic level with BENCH_OBJECTS objects: converting every number in
+ * it with tinyxml2's XMLUtil and with sscanf, then parsing it into a tinyxml2 document, fresh and reused, and cooking
+ * it, which are also timed on levelFile. Parsing and cooking are reported in MB/s; levelFile is parsed repeatedly to
+ * cover as many bytes as the synthetic level. Loading a file with tinyxml2 is timed on the synthetic level written to
+ * BENCH_LEVEL_FILE. Each time is the best of BENCH_RUNS runs. Needs no SDL.
+ * 
+ * @return false if XMLUtil and sscanf disagree on any number, or anything fails to parse.
+ */
+bool benchXML(const std::string& levelFile)
 {
-    SDL_Rect dst;
-    dst.x = x;
-    dst.y = y;
-    if (clip != nullptr)
+    typedef std::chrono::steady_clock Clock;
+    std::vector<std::string> ints, floats; // every number in the level, as written
+    std::string xml;
+    unsigned seed = 1;
+    auto random = [&seed](const unsigned range) { seed = seed * 1103515245 + 12345; return (seed >> 8) % range; };
+    auto integer = [&ints](const int value) { ints.push_back(std::to_string(value)); return ints.back(); };
+    auto real = [&floats](const float value)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%g", value);
+        floats.push_back(text);
+        return floats.back();
+    };
+    auto best = [](const std::function<void()>& run)
+    {
+        double fastest = 0;
+        for(int i = 0; i < BENCH_RUNS; ++i)
+        {
+            const Clock::time_point start = Clock::now();
+            run();
+            const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            fastest = i == 0 ? ms : std::min(fastest, ms);
+        }
+        return fastest;
+    };
+    
+    xml = "<chimptexture name=\"tex\" file=\"tex.png\"/>\n<chimptile name=\"tile\"><texture name=\"tex\" x=\""
+        + integer(0) + "\" y=\"" + integer(0) + "\" width=\"" + integer(32) + "\" height=\"" + integer(32)
+        + "\"/></chimptile>\n<chimplevel>\n    <sectionwidth>" + integer(2000) + "</sectionwidth>\n";
+    for(int i = 0; i < BENCH_OBJECTS; ++i)
+    {
+        xml += "    <object type=\"character\"><tile>tile</tile><position x=\"" + integer(i * 40) + "\" y=\""
+             + integer(int(random(SCREEN_HEIGHT))) + "\"/><tiles x=\"" + integer(1 + int(random(4))) + "\" y=\""
+             + integer(1) + "\"/><maxhealth>" + integer(1 + int(random(100))) + "</maxhealth><stopfactor>"
+             + real(random(1000) / 1000.0f) + "</stopfactor><acceleration type=\"run\">"
+             + real(random(100000) / 7919.0f) + "</acceleration><impulse type=\"jump\">"
+             + real(-1.0f - random(20000) / 1000.0f) + "</impulse><resistance type=\"run\" mode=\"scale\">"
+             + real(random(1u << 20) * 1e-6f) + "</resistance></object>\n";
+    }
+    xml += "</chimplevel>\n";
+    
+    std::vector<int> intValues(ints.size()), intReference(ints.size());
+    std::vector<float> floatValues(floats.size()), floatReference(floats.size());
+    const double toInt = best([&]()
+        { for(size_t i = 0; i < ints.size(); ++i) tinyxml2::XMLUtil::ToInt(ints[i].c_str(), &intValues[i]); });
+    const double toFloat = best([&]()
+        { for(size_t i = 0; i < floats.size(); ++i) tinyxml2::XMLUtil::ToFloat(floats[i].c_str(), &floatValues[i]); });
+    const double scanInt = best([&]()
+        { for(size_t i = 0; i < ints.size(); ++i) std::sscanf(ints[i].c_str(), "%d", &intReference[i]); });
+    const double scanFloat = best([&]()
+        { for(size_t i = 0; i < floats.size(); ++i) std::sscanf(floats[i].c_str(), "%f", &floatReference[i]); });
+    size_t mismatches = 0;
+    for(size_t i = 0; i < ints.size(); ++i)
+        mismatches += intValues[i] != intReference[i];
+    for(size_t i = 0; i < floats.size(); ++i)
+        mismatches += std::memcmp(&floatValues[i], &floatReference[i], sizeof(float)) != 0;
+    
+    bool parsed = true, cooked = true;
+    std::ifstream in(levelFile, std::ios::binary);
+    std::stringstream levelContents;
+    levelContents << in.rdbuf();
+    const std::string levelXML = in ? levelContents.str() : "";
+    auto parse = [](const std::string& text)
+    {
+        tinyxml2::XMLDocument doc;
+        return doc.Parse(text.c_str(), text.size()) == tinyxml2::XML_SUCCESS;
+    };
+    tinyxml2::XMLDocument reused; // keeps its pools and buffer between parses, as a reloading tool would
+    auto parseReused = [&reused](const std::string& text)
+        { return reused.Parse(text.c_str(), text.size()) == tinyxml2::XML_SUCCESS; };
+    auto cook = [](const std::string& text)
+    {
+        chimp::ChimpCookedLevel level;
+        return level.cook(text.c_str(), text.size());
+    };
+    auto throughput = [&](const std::string& text, const std::function<bool(const std::string&)>& run, bool& ok)
+    {
+        const size_t repeats = std::max<size_t>(1, xml.size() / std::max<size_t>(1, text.size()));
+        const double ms = best([&]() { for(size_t i = 0; i < repeats; ++i) ok &= run(text); });
+        return text.size() * repeats / (ms * 1000.0);
+    };
+    const double parseSynthetic = throughput(xml, parse, parsed);
+    const double parseSyntheticReused = throughput(xml, parseReused, parsed);
+    tinyxml2::XMLPoolStats pools[4];
+    reused.GetPoolStats(&pools[0], &pools[1], &pools[2], &pools[3]);
+    size_t poolBytes = 0;
+    for(const tinyxml2::XMLPoolStats& pool : pools)
+        poolBytes += size_t(pool.blocks) * pool.itemsPerBlock * pool.itemSize;
+    const double cookSynthetic = throughput(xml, cook, cooked);
+    const double parseLevel = levelXML.empty() ? 0 : throughput(levelXML, parse, parsed);
+    const double cookLevel = levelXML.empty() ? 0 : throughput(levelXML, cook, cooked);
+    
+    double load = 0, loadMapped = 0;
+    std::ofstream levelFileOut(BENCH_LEVEL_FILE, std::ios::binary | std::ios::trunc);
+    const bool written = levelFileOut.write(xml.data(), xml.size()) && levelFileOut.flush();
+    if(written)
     {
-        dst.w = clip->w;
-        dst.h = clip->h;
+        load = best([&]()
+            { tinyxml2::XMLDocument doc; parsed &= doc.LoadFile(BENCH_LEVEL_FILE.c_str()) == tinyxml2::XML_SUCCESS; });
+        loadMapped = best([&]()
+        {
+            tinyxml2::XMLDocument doc;
+            parsed &= doc.LoadFileMapped(BENCH_LEVEL_FILE.c_str()) == tinyxml2::XML_SUCCESS;
+        });
     }
+    levelFileOut.close();
+    std::remove(BENCH_LEVEL_FILE.c_str());
+    
+    std::cout << "Synthetic level: " << BENCH_OBJECTS << " objects, " << xml.size() / (1024.0 * 1024.0) << " MB\n"
+              << "  XMLUtil:  " << ints.size() << " ints " << toInt << " ms, " << floats.size() << " floats "
+              << toFloat << " ms\n"
+              << "  sscanf:   " << ints.size() << " ints " << scanInt << " ms, " << floats.size() << " floats "
+              << scanFloat << " ms\n"
+              << "  mismatches: " << mismatches << "\n"
+              << "  tinyxml2 parse (" << tinyxml2::XMLUtil::SimdName() << " scanning): " << parseSynthetic << " MB/s\n"
+              << "  tinyxml2 parse, reusing the document: " << parseSyntheticReused << " MB/s, keeping "
+              << poolBytes / (1024.0 * 1024.0) << " MB of pools and " << reused.CharBufferCapacity() / (1024.0 * 1024.0)
+              << " MB of text buffer\n"
+              << "  cook: " << cookSynthetic << " MB/s" << std::endl;
+    if(written)
+        std::cout << "  tinyxml2 LoadFile: " << load << " ms, LoadFileMapped: " << loadMapped << " ms" << std::endl;
+    else
+        std::cerr << "Couldn't write \"" << BENCH_LEVEL_FILE << "\", so file loading wasn't timed." << std::endl;
+    if(levelXML.empty())
+        std::cerr << "Couldn't read level file \"" << levelFile << "\"." << std::endl;
     else
-        SDL_QueryTexture(tex, NULL, NULL, &dst.w, &dst.h);
-    SDL_RenderCopy(renderer, tex, clip, &dst);
+        std::cout << levelFile << ": " << levelXML.size() / 1024.0 << " KB\n"
+                  << "  tinyxml2 parse: " << parseLevel << " MB/s\n"
+                  << "  cook: " << cookLevel << " MB/s" << std::endl;
+    if(!parsed || !cooked)
+        std::cerr << "Parsing or cooking failed." << std::endl;
+    return mismatches == 0 && parsed && cooked;
+}
+
+/**
+ * Parses a "WIDTHxHEIGHT" command line argument.
+ */
+bool parseResolution(const std::string& arg, Dimensions& resolution)
+{
+    const size_t x = arg.find('x');
+    if(x == std::string::npos)
+        return false;
+    const int width = std::atoi(arg.substr(0, x).c_str());
+    const int height = std::atoi(arg.substr(x + 1).c_str());
+    if(width <= 0 || height <= 0)
+        return false;
+    resolution.x = width;
+    resolution.y = height;
+    return true;
 }
 
-SDL_Texture* renderText(const std::string& message, TTF_Font* font, SDL_Color color,
-                        SDL_Renderer* const renderer)
+/**
+ * Parses a comma separated list of frame numbers, e.g. "1,60,600".
+ */
+bool parseFrameList(const std::string& arg, std::vector<int>& frames)
 {
-    SDL_Surface* surf = TTF_RenderText_Blended(font, message.c_str(), color);
-    if (surf == nullptr)
+    std::istringstream list(arg);
+    std::string item;
+    while(std::getline(list, item, ','))
     {
-        std::cerr << "TTF_RenderText error: " << SDL_GetError() << std::endl;
-        return nullptr;
+        const int frame = std::atoi(item.c_str());
+        if(frame <= 0)
+            return false;
+        frames.push_back(frame);
     }
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surf);
-    if (texture == nullptr)
-        std::cerr << "CreateTexture error: " << SDL_GetError() << std::endl;
-    SDL_FreeSurface(surf);
-    return texture;
+    std::sort(frames.begin(), frames.end());
+    return !frames.empty();
 }
 
-void drawHUD(chimp::ChimpGame& game, SDL_Renderer* const renderer, TTF_Font* font, SDL_Texture* const healthTex)
+/**
+ * Reads a headless input script. Each line is "<frame> <down|up> <key name>", where the key name is anything
+ * SDL_GetKeyFromName() accepts (Left, Right, Up, Space, X, ...). Blank lines and lines starting with # are skipped.
+ */
+bool loadInputScript(const std::string& file, std::vector<ScriptedEvent>& script)
 {
-    static int oldHealth = -1, w1, w2, h, x;
-    static int gameOverX, gameOverY;
-    static SDL_Texture* currentHealthTex;
-    static SDL_Texture* gameOverTex = [renderer, font]()
-    {
-        SDL_Texture* tex = renderText(GAME_OVER_TEXT, font, FONT_COLOR, renderer);
-        SDL_QueryTexture(tex, nullptr, nullptr, &gameOverX, &gameOverY);
-        gameOverX = (SCREEN_WIDTH - gameOverX) >> 1;
-        gameOverY = (SCREEN_HEIGHT - gameOverY) >> 1;
-        return tex;
-    }();
+    std::ifstream in(file);
+    if(!in)
+    {
+        std::cerr << "Couldn't open input script \"" << file << "\"." << std::endl;
+        return false;
+    }
     
-    if(oldHealth != game.getPlayer()->getHealth())
+    std::string line;
+    for(int lineNumber = 1; std::getline(in, line); ++lineNumber)
+    {
+        std::istringstream fields(line);
+        ScriptedEvent scripted;
+        std::string direction, key;
+        if(!(fields >> direction) || direction[0] == '#')
+            continue;
+        scripted.frame = std::atoi(direction.c_str());
+        std::getline(fields >> direction >> std::ws, key);
+        
+        const SDL_Keycode code = SDL_GetKeyFromName(key.c_str());
+        if(scripted.frame <= 0 || (direction != "down" && direction != "up") || code == SDLK_UNKNOWN)
+        {
+            std::cerr << file << ":" << lineNumber << ": expected \"<frame> <down|up> <key>\"" << std::endl;
+            return false;
+        }
+        SDL_memset(&scripted.event, 0, sizeof(scripted.event));
+        scripted.event.type = direction == "down" ? SDL_KEYDOWN : SDL_KEYUP;
+        scripted.event.key.keysym.sym = code;
+        script.push_back(scripted);
+    }
+    std::stable_sort(script.begin(), script.end(),
+                     [](const ScriptedEvent& a, const ScriptedEvent& b) { return a.frame < b.frame; });
+    return true;
+}
+
+/**
+ * Called only when the window has actually been resized. With an internal resolution the window is left at whatever
+ * size the user chose and the frame is letterboxed into it. Otherwise the window is snapped back to the view's aspect
+ * ratio, once, here rather than every frame.
+ */
+void windowResized(SDL_Event& event, SDL_Window* const window, chimp::ChimpScreen& screen,
+                   Dimensions& windowDimensions, const chimp::ChimpGame& game)
+{
+    if(screen.hasInternalResolution())
     {
-        SDL_DestroyTexture(currentHealthTex);
-        oldHealth = game.getPlayer()->getHealth();
-        currentHealthTex = renderText(std::to_string(oldHealth), font, FONT_COLOR, renderer);
-        SDL_QueryTexture(healthTex, nullptr, nullptr, &w1, &h);
-        SDL_QueryTexture(currentHealthTex, nullptr, nullptr, &w2, &h);
-        x = (SCREEN_WIDTH>>1) - w1;
+        windowDimensions.x = event.window.data1;
+        windowDimensions.y = event.window.data2;
+        screen.resize(windowDimensions.x, windowDimensions.y);
+        return;
     }
     
-    renderTexture(healthTex, renderer, x, 10);
-    renderTexture(currentHealthTex, renderer, x + w1, 10);
-    if(!game.getPlayer()->isActive())
-        renderTexture(gameOverTex, renderer, gameOverX, gameOverY);
+    resize(event, windowDimensions, screen.getRenderer(), game);
+    if(windowDimensions.x != event.window.data1 || windowDimensions.y != event.window.data2)
+        SDL_SetWindowSize(window, windowDimensions.x, windowDimensions.y);
 }
 
 void resize(SDL_Event& event, Dimensions& windowDimensions, SDL_Renderer* const renderer, const chimp::ChimpGame& game)
@@ -300,6 +300,21 @@ private:
 };
 
 
+/*
+	Statistics of a memory pool, from XMLDocument::GetPoolStats().
+*/
+struct XMLPoolStats
+{
+    int itemSize;       // bytes per item
+    int itemsPerBlock;
+    int blocks;         // blocks allocated
+    int currentAllocs;  // items in use
+    int maxAllocs;      // most items in use at once
+    int nAllocs;        // items handed out since the blocks were allocated
+    int nUntracked;     // items allocated but not linked into the document
+};
+
+
 /*
 	Parent virtual class of a pool for fast allocation
 	and deallocation of objects.
@@ -343,6 +358,17 @@ public:
         _nUntracked = 0;
     }
 
+    // Like Clear(), but keeps the blocks: every item in them is free again.
+    // Any item still in use is lost.
+    void Reset() {
+        _root = 0;
+        for( int i = _blockPtrs.Size() - 1; i >= 0; --i ) {
+            _root = LinkItems( _blockPtrs[i], _root );
+        }
+        _currentAllocs = 0;
+        _nUntracked = 0;
+    }
+
     virtual int ItemSize() const	{
         return ITEM_SIZE;
     }
@@ -355,13 +381,7 @@ public:
             // Need a new block.
             Block* block = new Block();
             _blockPtrs.Push( block );
-
-            Item* blockItems = block->items;
-            for( int i = 0; i < ITEMS_PER_BLOCK - 1; ++i ) {
-                blockItems[i].next = &(blockItems[i + 1]);
-            }
-            blockItems[ITEMS_PER_BLOCK - 1].next = 0;
-            _root = blockItems;
+            _root = LinkItems( block, 0 );
         }
         Item* const result = _root;
         TIXMLASSERT( result != 0 );
@@ -402,6 +422,16 @@ public:
         return _nUntracked;
     }
 
+    void GetStats( XMLPoolStats* stats ) const {
+        stats->itemSize = ITEM_SIZE;
+        stats->itemsPerBlock = ITEMS_PER_BLOCK;
+        stats->blocks = _blockPtrs.Size();
+        stats->currentAllocs = _currentAllocs;
+        stats->maxAllocs = _maxAllocs;
+        stats->nAllocs = _nAllocs;
+        stats->nUntracked = _nUntracked;
+    }
+
 	// This number is perf sensitive. 4k seems like a good tradeoff on my machine.
 	// The test file is large, 170k.
 	// Release:		VS2010 gcc(no opt)
@@ -426,6 +456,16 @@ private:
     struct Block {
         Item items[ITEMS_PER_BLOCK];
     };
+
+    // Chains the items of a block into a free list ending with next.
+    static Item* LinkItems( Block* block, Item* next ) {
+        Item* blockItems = block->items;
+        for( int i = 0; i < ITEMS_PER_BLOCK - 1; ++i ) {
+            blockItems[i].next = &(blockItems[i + 1]);
+        }
+        blockItems[ITEMS_PER_BLOCK - 1].next = next;
+        return blockItems;
+    }
     DynArray< Block*, 10 > _blockPtrs;
     Item* _root;
 
@@ -532,12 +572,16 @@ class XMLUtil
 public:
     static const char* SkipWhiteSpace( const char* p )	{
         TIXMLASSERT( p );
-        while( IsWhiteSpace(*p) ) {
-            ++p;
+        if ( IsWhiteSpace(*p) ) {
+            p = SkipWhiteSpaceRun( p + 1 );
         }
         TIXMLASSERT( p );
         return p;
     }
+    // The out of line part of SkipWhiteSpace(), which scans a block of bytes at a time where it can.
+    static const char* SkipWhiteSpaceRun( const char* p );
+    // The instruction set byte scanning uses: "AVX2", "SSE2", or "none" for a byte at a time.
+    static const char* SimdName();
     static char* SkipWhiteSpace( char* p )				{
         return const_cast<char*>( SkipWhiteSpace( const_cast<const char*>(p) ) );
     }
@@ -1185,6 +1229,7 @@ private:
 class TINYXML2_LIB XMLElement : public XMLNode
 {
     friend class XMLDocument;
+    friend class XMLNode;
 public:
     /// Get the name of an element (which is the Value() of the node.)
     const char* Name() const		{
@@ -1568,17 +1613,27 @@ private:
     XMLAttribute* FindAttribute( const char* name ) {
         return const_cast<XMLAttribute*>(const_cast<const XMLElement*>(this)->FindAttribute( name ));
     }
+    const XMLAttribute* ScanAttributes( const char* name ) const;
     XMLAttribute* FindOrCreateAttribute( const char* name );
     //void LinkAttribute( XMLAttribute* attrib );
     char* ParseAttributes( char* p );
     static void DeleteAttribute( XMLAttribute* attribute );
 
+    // Lookups by name, if the document indexes elements (see XMLDocument::SetIndexElements()).
+    // They return false if this element has too few children or attributes to be indexed.
+    struct Index;
+    const Index* GetIndex() const;	// builds or rebuilds _index, so it isn't safe to call from two threads at once
+    bool FindIndexedChild( const char* name, const XMLElement** first, const XMLElement** last ) const;
+    bool FindIndexedAttribute( const char* name, const XMLAttribute** attribute ) const;
+
     enum { BUF_SIZE = 200 };
+    enum { INDEX_MIN_ENTRIES = 8 };  // fewer children or attributes are faster to scan
     int _closingType;
     // The attribute list is ordered; there is no 'lastAttribute'
     // because the list needs to be scanned for dupes before adding
     // a new attribute.
     XMLAttribute* _rootAttribute;
+    mutable Index* _index;
 };
 
 
@@ -1596,6 +1651,7 @@ enum Whitespace {
 class TINYXML2_LIB XMLDocument : public XMLNode
 {
     friend class XMLElement;
+    friend class XMLNode;
 public:
     /// constructor
     XMLDocument( bool processEntities = true, Whitespace = PRESERVE_WHITESPACE );
@@ -1642,6 +1698,22 @@ public:
     */
     XMLError LoadFile( FILE* );
 
+    /**
+    	Load an XML file from disk by mapping it into memory
+    	instead of reading it into a buffer. The mapping is
+    	private and copy-on-write, so the parser writes its
+    	terminators into the mapped pages without touching the
+    	file, and only the pages it writes to get copied. Pages
+    	are read from disk lazily as the parser reaches them.
+    	The mapping lives until the document is cleared.
+
+    	Falls back to LoadFile() where mmap isn't available.
+
+    	Returns XML_NO_ERROR (0) on success, or
+    	an errorID.
+    */
+    XMLError LoadFileMapped( const char* filename );
+
     /**
     	Save the XML file to disk.
     	Returns XML_NO_ERROR (0) on success, or
@@ -1665,6 +1737,27 @@ public:
         return _whitespace;
     }
 
+    /**
+    	Index the child elements and attributes of elements by name, so
+    	FindAttribute(), Attribute(), FirstChildElement( name ) and
+    	LastChildElement( name ) take constant time on elements with many
+    	of them. An element's index is built by its first lookup. Any
+    	change to the document makes indexes rebuild on their next lookup,
+    	so this suits documents that are read more than they are edited.
+    	Off by default.
+
+    	Building an index writes to the element even when it's looked up
+    	through a const pointer. With indexing on, a document read from
+    	several threads at once therefore needs a lock, where without it
+    	concurrent const reads are safe.
+    */
+    void SetIndexElements( bool index ) {
+        _indexElements = index;
+    }
+    bool IndexElements() const {
+        return _indexElements;
+    }
+
     /**
     	Returns true if this document has a leading Byte Order Mark of UTF8.
     */
@@ -1770,9 +1863,36 @@ public:
     /// If there is an error, print it to stdout.
     void PrintError() const;
     
-    /// Clear the document, resetting it to the initial state.
+    /**
+    	Clear the document, resetting it to the initial state, and
+    	release its memory: the buffer holding the text, and the blocks
+    	of each pool that no node is allocated from any more (nodes made
+    	with NewElement() and the like, but not inserted, still are).
+    */
     void Clear();
 
+    /**
+    	Clear the document like Clear(), but keep the memory it has
+    	allocated: the blocks of the node pools and the buffer the text
+    	is parsed in. Parse() and LoadFile() start with a Reset(), so a
+    	document reused for text of similar size stops allocating once
+    	it has grown. Clear() or the destructor releases the memory.
+    */
+    void Reset();
+
+    /**
+    	Statistics of the memory pools that nodes are allocated from,
+    	for sizing a document that is reused. Comments, declarations
+    	and unknowns share a pool. Any of the pointers may be null.
+    */
+    void GetPoolStats( XMLPoolStats* elements, XMLPoolStats* attributes, XMLPoolStats* texts,
+                       XMLPoolStats* comments ) const;
+
+    /// Bytes kept for the text of the document; 0 if it was mapped by LoadFileMapped().
+    size_t CharBufferCapacity() const {
+        return _charBufferCapacity;
+    }
+
     // internal
     char* Identify( char* p, XMLNode** node );
 
@@ -1789,11 +1909,15 @@ private:
 
     bool        _writeBOM;
     bool        _processEntities;
+    bool        _indexElements;
+    size_t      _modifications; // of the tree, to tell when element indexes are stale
     XMLError    _errorID;
     Whitespace  _whitespace;
     mutable StrPair		_errorStr1;
     mutable StrPair		_errorStr2;
     char*       _charBuffer;
+    size_t      _mappedSize;    // non-zero if _charBuffer is mapped by LoadFileMapped()
+    size_t      _charBufferCapacity;    // of _charBuffer, if it's allocated; kept by Reset()
 
     MemPoolT< sizeof(XMLElement) >	 _elementPool;
     MemPoolT< sizeof(XMLAttribute) > _attributePool;
@@ -1803,6 +1927,10 @@ private:
 	static const char* _errorNames[XML_ERROR_COUNT];
 
     void Parse();
+    char* AllocCharBuffer( size_t size );
+    void Modified() {
+        ++_modifications;
+    }
 };
 
 
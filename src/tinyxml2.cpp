@@ -27,9 +27,19 @@ distribution.
 #if defined(ANDROID_NDK) || defined(__BORLANDC__) || defined(__QNXNTO__)
 #   include <stddef.h>
 #   include <stdarg.h>
+#   include <float.h>
+#   include <locale.h>
 #else
 #   include <cstddef>
 #   include <cstdarg>
+#   include <cfloat>
+#   include <clocale>
+#endif
+#if !defined(_WIN32)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
 #endif
 
 #if defined(_MSC_VER) && (_MSC_VER >= 1400 ) && (!defined WINCE)
@@ -135,6 +145,159 @@ static const Entity entities[NUM_ENTITIES] = {
 };
 
 
+/*
+	Byte scanning. The parser's inner loops look for the next byte of some small set: the first
+	character of an end tag, the end of a name, the end of a run of white space, or a character
+	GetStr() has to rewrite. With SSE2 (16 bytes) or AVX2 (32 bytes) available at compile time,
+	a whole block is compared at once. Blocks are read aligned, so a read never crosses into the
+	next page even though the buffer's length isn't known, only that it ends in a null; the null
+	is always one of the bytes searched for. Those reads can still run past the end of the
+	allocation inside the block, which AddressSanitizer would report, so it is switched off for
+	the scanning functions. Define TIXML_NO_SIMD to use the byte at a time loops instead.
+*/
+#if !defined( TIXML_NO_SIMD ) && defined( __AVX2__ )
+#   include <immintrin.h>
+#   define TIXML_SIMD "AVX2"
+    typedef __m256i Block;
+    static const size_t BLOCK_SIZE = 32;
+    static const uint32_t ALL_BYTES = 0xffffffffU;
+    static inline Block Splat( char c )                 { return _mm256_set1_epi8( c ); }
+    static inline Block Equal( Block a, Block b )       { return _mm256_cmpeq_epi8( a, b ); }
+    static inline Block Or( Block a, Block b )          { return _mm256_or_si256( a, b ); }
+    static inline Block SubtractSaturate( Block a, Block b )   { return _mm256_subs_epu8( a, b ); }
+    static inline Block Subtract( Block a, Block b )    { return _mm256_sub_epi8( a, b ); }
+    static inline Block Zero()                          { return _mm256_setzero_si256(); }
+    static inline uint32_t Mask( Block a )              { return static_cast<uint32_t>( _mm256_movemask_epi8( a ) ); }
+#elif !defined( TIXML_NO_SIMD ) && ( defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+#   include <emmintrin.h>
+#   define TIXML_SIMD "SSE2"
+    typedef __m128i Block;
+    static const size_t BLOCK_SIZE = 16;
+    static const uint32_t ALL_BYTES = 0xffffU;
+    static inline Block Splat( char c )                 { return _mm_set1_epi8( c ); }
+    static inline Block Equal( Block a, Block b )       { return _mm_cmpeq_epi8( a, b ); }
+    static inline Block Or( Block a, Block b )          { return _mm_or_si128( a, b ); }
+    static inline Block SubtractSaturate( Block a, Block b )   { return _mm_subs_epu8( a, b ); }
+    static inline Block Subtract( Block a, Block b )    { return _mm_sub_epi8( a, b ); }
+    static inline Block Zero()                          { return _mm_setzero_si128(); }
+    static inline uint32_t Mask( Block a )              { return static_cast<uint32_t>( _mm_movemask_epi8( a ) ); }
+#endif
+
+#if defined( TIXML_SIMD )
+#   if defined( _MSC_VER ) && !defined( __clang__ )
+#       include <intrin.h>
+    static inline int FirstBit( uint32_t mask )
+    {
+        unsigned long index;
+        _BitScanForward( &index, mask );
+        return static_cast<int>( index );
+    }
+#       define TIXML_NO_SANITIZE_ADDRESS
+#   else
+    static inline int FirstBit( uint32_t mask )         { return __builtin_ctz( mask ); }
+#       define TIXML_NO_SANITIZE_ADDRESS __attribute__(( no_sanitize_address ))
+#   endif
+
+// Bytes with lo <= byte <= hi, compared unsigned.
+static inline Block InRange( Block bytes, char lo, char hi )
+{
+    return Equal( SubtractSaturate( Subtract( bytes, Splat( lo ) ), Splat( static_cast<char>( hi - lo ) ) ), Zero() );
+}
+
+struct MatchAny {   // any of three bytes or null; repeat one to look for fewer
+    Block a, b, c;
+    MatchAny( char ca, char cb, char cc ) : a( Splat( ca ) ), b( Splat( cb ) ), c( Splat( cc ) ) {}
+    uint32_t operator()( Block bytes ) const {
+        return Mask( Or( Or( Equal( bytes, a ), Equal( bytes, b ) ), Or( Equal( bytes, c ), Equal( bytes, Zero() ) ) ) );
+    }
+};
+
+struct MatchNotWhiteSpace {     // same white space as XMLUtil::IsWhiteSpace()
+    uint32_t operator()( Block bytes ) const {
+        return ~Mask( Or( Equal( bytes, Splat( ' ' ) ), InRange( bytes, '\t', '\r' ) ) ) & ALL_BYTES;
+    }
+};
+
+struct MatchNotNameChar {       // same name characters as XMLUtil::IsNameChar()
+    uint32_t operator()( Block bytes ) const {
+        const Block name = Or( Or( InRange( Or( bytes, Splat( 0x20 ) ), 'a', 'z' ), InRange( bytes, '0', ':' ) ),
+                               Or( InRange( bytes, '-', '.' ), Equal( bytes, Splat( '_' ) ) ) );
+        return ~( Mask( name ) | Mask( bytes ) ) & ALL_BYTES;   // Mask( bytes ) has the bytes >= 128
+    }
+};
+
+// Returns the first byte at or after p that match finds.
+template< class Match > TIXML_NO_SANITIZE_ADDRESS
+static inline const char* Scan( const char* p, const Match& match )
+{
+    const size_t offset = reinterpret_cast<uintptr_t>( p ) % BLOCK_SIZE;
+    const char* block = p - offset;
+    uint32_t found = match( *reinterpret_cast<const Block*>( block ) ) >> offset;
+    if ( found ) {
+        return p + FirstBit( found );
+    }
+    for ( ;; ) {
+        block += BLOCK_SIZE;
+        found = match( *reinterpret_cast<const Block*>( block ) );
+        if ( found ) {
+            return block + FirstBit( found );
+        }
+    }
+}
+#endif
+
+
+// Returns the first of a, b, c or the null terminator at or after p.
+static inline char* FindAny( char* p, char a, char b, char c )
+{
+#if defined( TIXML_SIMD )
+    return const_cast<char*>( Scan( p, MatchAny( a, b, c ) ) );
+#else
+    while ( *p && *p != a && *p != b && *p != c ) {
+        ++p;
+    }
+    return p;
+#endif
+}
+
+
+const char* XMLUtil::SkipWhiteSpaceRun( const char* p )
+{
+#if defined( TIXML_SIMD )
+    return Scan( p, MatchNotWhiteSpace() );
+#else
+    while( IsWhiteSpace(*p) ) {
+        ++p;
+    }
+    return p;
+#endif
+}
+
+
+const char* XMLUtil::SimdName()
+{
+#if defined( TIXML_SIMD )
+    return TIXML_SIMD;
+#else
+    return "none";
+#endif
+}
+
+
+// Returns the first byte at or after p that isn't a name character.
+static inline char* SkipNameChars( char* p )
+{
+#if defined( TIXML_SIMD )
+    return const_cast<char*>( Scan( p, MatchNotNameChar() ) );
+#else
+    while ( *p && XMLUtil::IsNameChar( *p ) ) {
+        ++p;
+    }
+    return p;
+#endif
+}
+
+
 StrPair::~StrPair()
 {
     Reset();
@@ -198,12 +361,11 @@ char* StrPair::ParseText( char* p, const char* endTag, int strFlags )
     size_t length = strlen( endTag );
 
     // Inner loop of text parsing.
-    while ( *p ) {
-        if ( *p == endChar && strncmp( p, endTag, length ) == 0 ) {
+    for ( p = FindAny( p, endChar, endChar, endChar ); *p; p = FindAny( p + 1, endChar, endChar, endChar ) ) {
+        if ( strncmp( p, endTag, length ) == 0 ) {
             Set( start, p, strFlags );
             return p + length;
         }
-        ++p;
     }
     return 0;
 }
@@ -219,10 +381,7 @@ char* StrPair::ParseName( char* p )
     }
 
     char* const start = p;
-    ++p;
-    while ( *p && XMLUtil::IsNameChar( *p ) ) {
-        ++p;
-    }
+    p = SkipNameChars( p + 1 );
 
     Set( start, p, 0 );
     return p;
@@ -267,10 +426,27 @@ const char* StrPair::GetStr()
         _flags ^= NEEDS_FLUSH;
 
         if ( _flags ) {
-            const char* p = _start;	// the read pointer
+            char* p = _start;	// the read pointer
             char* q = _start;	// the write pointer
+            // The characters that may need rewriting. The ones not needed are searched for as null,
+            // which the terminator at _end already stops the search at.
+            const char cr = ( _flags & NEEDS_NEWLINE_NORMALIZATION ) ? CR : 0;
+            const char lf = ( _flags & NEEDS_NEWLINE_NORMALIZATION ) ? LF : 0;
+            const char amp = ( _flags & NEEDS_ENTITY_PROCESSING ) ? '&' : 0;
 
             while( p < _end ) {
+                // Move the run of characters that stay as they are in one go.
+                char* const run = FindAny( p, cr, lf, amp );
+                if ( run != p ) {
+                    if ( q != p ) {
+                        memmove( q, p, run - p );
+                    }
+                    q += run - p;
+                    p = run;
+                    if ( p >= _end ) {
+                        break;
+                    }
+                }
                 if ( (_flags & NEEDS_NEWLINE_NORMALIZATION) && *p == CR ) {
                     // CR-LF pair becomes LF
                     // CR alone becomes LF
@@ -566,20 +742,167 @@ void XMLUtil::ToStr(int64_t v, char* buffer, int bufferSize)
 }
 
 
-bool XMLUtil::ToInt( const char* str, int* value )
+/*
+	String to number conversions used to go through sscanf, which is slow and depends on the
+	C locale's decimal point. They now parse by hand. Like sscanf they skip leading white space
+	and stop at the first character that isn't part of the number, but integers that don't fit
+	are rejected instead of wrapping.
+
+	Decimal floats are converted with a single correctly rounded multiply or divide when both
+	the digits and the power of ten are exact in the target type (Clinger's fast path), which
+	covers the numbers documents are normally written with. Anything else (long mantissas, big
+	exponents, hex, inf, nan) goes to strtod/strtof with '.' swapped for the locale's decimal
+	point. Either way the result is the correctly rounded value, so ToStr() output reads back
+	exactly, and it never depends on the locale.
+*/
+static bool ReadInteger( const char* p, uint64_t maxPositive, uint64_t maxNegative, bool* negative, uint64_t* magnitude )
+{
+    p = XMLUtil::SkipWhiteSpace( p );
+    *negative = ( *p == '-' );
+    if ( *p == '-' || *p == '+' ) {
+        ++p;
+    }
+    if ( *p < '0' || *p > '9' ) {
+        return false;
+    }
+    const uint64_t limit = *negative ? maxNegative : maxPositive;
+    uint64_t v = 0;
+    for ( ; *p >= '0' && *p <= '9'; ++p ) {
+        const unsigned digit = *p - '0';
+        if ( v > ( limit - digit ) / 10 ) {
+            return false;
+        }
+        v = v * 10 + digit;
+    }
+    *magnitude = v;
+    return true;
+}
+
+
+// Splits a plain decimal number into mantissa * 10^exponent. Returns false if it has to take the slow path.
+static bool ReadDecimal( const char* p, bool* negative, uint64_t* mantissa, int* exponent )
+{
+    static const int MAX_DIGITS = 19;   // always fits in a uint64_t
+    p = XMLUtil::SkipWhiteSpace( p );
+    *negative = ( *p == '-' );
+    if ( *p == '-' || *p == '+' ) {
+        ++p;
+    }
+    if ( p[0] == '0' && ( p[1] == 'x' || p[1] == 'X' ) ) {
+        return false;
+    }
+
+    uint64_t m = 0;
+    int digits = 0;
+    int e = 0;
+    bool any = false;
+    for ( ; *p >= '0' && *p <= '9'; ++p ) {
+        any = true;
+        if ( m == 0 && *p == '0' ) {
+            continue;
+        }
+        if ( digits == MAX_DIGITS ) {
+            return false;
+        }
+        m = m * 10 + ( *p - '0' );
+        ++digits;
+    }
+    if ( *p == '.' ) {
+        for ( ++p; *p >= '0' && *p <= '9'; ++p ) {
+            any = true;
+            if ( m == 0 && *p == '0' ) {
+                --e;
+                continue;
+            }
+            if ( digits == MAX_DIGITS ) {
+                return false;
+            }
+            m = m * 10 + ( *p - '0' );
+            ++digits;
+            --e;
+        }
+    }
+    if ( !any ) {
+        return false;
+    }
+    if ( *p == 'e' || *p == 'E' ) {
+        const char* q = p + 1;
+        const bool negativeExponent = ( *q == '-' );
+        if ( *q == '-' || *q == '+' ) {
+            ++q;
+        }
+        int x = 0;
+        for ( ; *q >= '0' && *q <= '9'; ++q ) {
+            if ( x > 10000 ) {
+                return false;
+            }
+            x = x * 10 + ( *q - '0' );
+        }
+        e += negativeExponent ? -x : x;
+    }
+    *mantissa = m;
+    *exponent = e;
+    return true;
+}
+
+
+// strtod/strtof, but reading '.' as the decimal point whatever the locale.
+template< class T > static bool ReadFloatSlow( const char* str, T ( *convert )( const char*, char** ), T* value )
 {
-    if ( TIXML_SSCANF( str, "%d", value ) == 1 ) {
+    const char point = *localeconv()->decimal_point;
+    const char* p = XMLUtil::SkipWhiteSpace( str );
+    char* end = 0;
+    if ( point == '.' ) {
+        const T v = convert( p, &end );
+        if ( end == p ) {
+            return false;
+        }
+        *value = v;
         return true;
     }
-    return false;
+
+    size_t length = 0;
+    while ( isalnum( static_cast<unsigned char>( p[length] ) ) || p[length] == '.' || p[length] == '+' || p[length] == '-' ) {
+        ++length;
+    }
+    char local[64];
+    char* buffer = ( length < sizeof( local ) ) ? local : new char[length + 1];
+    for ( size_t i = 0; i < length; ++i ) {
+        buffer[i] = ( p[i] == '.' ) ? point : p[i];
+    }
+    buffer[length] = 0;
+    const T v = convert( buffer, &end );
+    const bool read = end != buffer;
+    if ( read ) {
+        *value = v;
+    }
+    if ( buffer != local ) {
+        delete [] buffer;
+    }
+    return read;
+}
+
+
+bool XMLUtil::ToInt( const char* str, int* value )
+{
+    bool negative;
+    uint64_t v;
+    if ( !ReadInteger( str, INT_MAX, uint64_t( INT_MAX ) + 1, &negative, &v ) ) {
+        return false;
+    }
+    *value = negative ? static_cast<int>( -static_cast<int64_t>( v ) ) : static_cast<int>( v );
+    return true;
 }
 
 bool XMLUtil::ToUnsigned( const char* str, unsigned *value )
 {
-    if ( TIXML_SSCANF( str, "%u", value ) == 1 ) {
-        return true;
+    bool negative;
+    uint64_t v;
+    if ( !ReadInteger( str, UINT_MAX, UINT_MAX, &negative, &v ) ) {
+        return false;
     }
-    return false;
+    *value = negative ? 0U - static_cast<unsigned>( v ) : static_cast<unsigned>( v );  // wraps like sscanf's %u
+    return true;
 }
 
 bool XMLUtil::ToBool( const char* str, bool* value )
@@ -603,30 +926,48 @@ bool XMLUtil::ToBool( const char* str, bool* value )
 
 bool XMLUtil::ToFloat( const char* str, float* value )
 {
-    if ( TIXML_SSCANF( str, "%f", value ) == 1 ) {
+    static const float POW10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+    bool negative;
+    uint64_t m;
+    int e;
+#if defined( FLT_EVAL_METHOD ) && FLT_EVAL_METHOD == 0   // no excess precision, so each operation rounds once
+    if ( ReadDecimal( str, &negative, &m, &e ) && m <= ( uint64_t( 1 ) << 24 ) && e >= -10 && e <= 10 ) {
+        const float f = ( e < 0 ) ? float( m ) / POW10[-e] : float( m ) * POW10[e];
+        *value = negative ? -f : f;
         return true;
     }
-    return false;
+#endif
+    return ReadFloatSlow( str, strtof, value );
 }
 
 
 bool XMLUtil::ToDouble( const char* str, double* value )
 {
-    if ( TIXML_SSCANF( str, "%lf", value ) == 1 ) {
+    static const double POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    bool negative;
+    uint64_t m;
+    int e;
+#if defined( FLT_EVAL_METHOD ) && FLT_EVAL_METHOD == 0
+    if ( ReadDecimal( str, &negative, &m, &e ) && m <= ( uint64_t( 1 ) << 53 ) && e >= -22 && e <= 22 ) {
+        const double d = ( e < 0 ) ? double( m ) / POW10[-e] : double( m ) * POW10[e];
+        *value = negative ? -d : d;
         return true;
     }
-    return false;
+#endif
+    return ReadFloatSlow( str, strtod, value );
 }
 
 
 bool XMLUtil::ToInt64(const char* str, int64_t* value)
 {
-	long long v = 0;	// horrible syntax trick to make the compiler happy about %lld
-	if (TIXML_SSCANF(str, "%lld", &v) == 1) {
-		*value = (int64_t)v;
-		return true;
+	bool negative;
+	uint64_t v;
+	if (!ReadInteger(str, INT64_MAX, uint64_t(INT64_MAX) + 1, &negative, &v)) {
+		return false;
 	}
-	return false;
+	*value = static_cast<int64_t>(negative ? 0 - v : v);
+	return true;
 }
 
 
@@ -749,6 +1090,7 @@ const char* XMLNode::Value() const
 
 void XMLNode::SetValue( const char* str, bool staticMem )
 {
+    _document->Modified();
     if ( staticMem ) {
         _value.SetInternedStr( str );
     }
@@ -787,6 +1129,7 @@ void XMLNode::Unlink( XMLNode* child )
         child->_next->_prev = child->_prev;
     }
 	child->_parent = 0;
+    _document->Modified();
 }
 
 
@@ -894,6 +1237,11 @@ XMLNode* XMLNode::InsertAfterChild( XMLNode* afterThis, XMLNode* addThis )
 
 const XMLElement* XMLNode::FirstChildElement( const char* name ) const
 {
+    const XMLElement* first = 0;
+    const XMLElement* last = 0;
+    if ( name && _document->IndexElements() && ToElement() && ToElement()->FindIndexedChild( name, &first, &last ) ) {
+        return first;
+    }
     for( const XMLNode* node = _firstChild; node; node = node->_next ) {
         const XMLElement* element = node->ToElement();
         if ( element ) {
@@ -908,6 +1256,11 @@ const XMLElement* XMLNode::FirstChildElement( const char* name ) const
 
 const XMLElement* XMLNode::LastChildElement( const char* name ) const
 {
+    const XMLElement* first = 0;
+    const XMLElement* last = 0;
+    if ( name && _document->IndexElements() && ToElement() && ToElement()->FindIndexedChild( name, &first, &last ) ) {
+        return last;
+    }
     for( const XMLNode* node = _lastChild; node; node = node->_prev ) {
         const XMLElement* element = node->ToElement();
         if ( element ) {
@@ -1047,6 +1400,7 @@ void XMLNode::InsertChildPreamble( XMLNode* insertThis ) const
 {
     TIXMLASSERT( insertThis );
     TIXMLASSERT( insertThis->_document == _document );
+    _document->Modified();
 
     if ( insertThis->_parent )
         insertThis->_parent->Unlink( insertThis );
@@ -1410,9 +1764,113 @@ void XMLAttribute::SetAttribute( float v )
 
 
 // --------- XMLElement ---------- //
+/*
+	Open addressing hash tables of the names of an element's child
+	elements and attributes. The children table keeps the first and last
+	child of each name. A table is left out if it would have fewer than
+	INDEX_MIN_ENTRIES entries.
+*/
+struct XMLElement::Index {
+    struct ChildSlot {
+        unsigned            hash;
+        const char*         name;   // null if the slot is empty
+        const XMLElement*   first;
+        const XMLElement*   last;
+    };
+    struct AttributeSlot {
+        unsigned            hash;
+        const XMLAttribute* attribute;  // null if the slot is empty
+    };
+
+    size_t          modifications;  // of the document when it was built
+    ChildSlot*      children;
+    AttributeSlot*  attributes;
+    unsigned        childMask;
+    unsigned        attributeMask;
+
+    Index() : modifications( 0 ), children( 0 ), attributes( 0 ), childMask( 0 ), attributeMask( 0 ) {}
+    ~Index() {
+        delete [] children;
+        delete [] attributes;
+    }
+
+    static unsigned Hash( const char* name ) {
+        // FNV-1a
+        unsigned hash = 2166136261u;
+        for( const unsigned char* p = reinterpret_cast<const unsigned char*>( name ); *p; ++p ) {
+            hash = ( hash ^ *p ) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Empties a table with room for entries at most half full, reusing it if it's the right size.
+    template< class Slot >
+    static Slot* ResetTable( Slot* table, unsigned* mask, int entries ) {
+        if ( entries < INDEX_MIN_ENTRIES ) {
+            delete [] table;
+            *mask = 0;
+            return 0;
+        }
+        unsigned size = 2 * INDEX_MIN_ENTRIES;
+        while ( size < 2 * (unsigned)entries ) {
+            size *= 2;
+        }
+        if ( !table || *mask != size - 1 ) {
+            delete [] table;
+            table = new Slot[size];
+            *mask = size - 1;
+        }
+        memset( table, 0, size * sizeof( Slot ) );
+        return table;
+    }
+
+    void Build( const XMLElement* element ) {
+        int nChildren = 0;
+        int nAttributes = 0;
+        for( const XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement() ) {
+            ++nChildren;
+        }
+        for( const XMLAttribute* a = element->FirstAttribute(); a; a = a->Next() ) {
+            ++nAttributes;
+        }
+        children = ResetTable( children, &childMask, nChildren );
+        attributes = ResetTable( attributes, &attributeMask, nAttributes );
+
+        if ( children ) {
+            for( const XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement() ) {
+                const char* name = child->Name();
+                const unsigned hash = Hash( name );
+                ChildSlot* slot = &children[hash & childMask];
+                while ( slot->name && !( slot->hash == hash && XMLUtil::StringEqual( slot->name, name ) ) ) {
+                    slot = &children[( slot - children + 1 ) & childMask];
+                }
+                if ( !slot->name ) {
+                    slot->hash = hash;
+                    slot->name = name;
+                    slot->first = child;
+                }
+                slot->last = child;
+            }
+        }
+        if ( attributes ) {
+            for( const XMLAttribute* a = element->FirstAttribute(); a; a = a->Next() ) {
+                const unsigned hash = Hash( a->Name() );
+                AttributeSlot* slot = &attributes[hash & attributeMask];
+                while ( slot->attribute ) {
+                    slot = &attributes[( slot - attributes + 1 ) & attributeMask];
+                }
+                slot->hash = hash;
+                slot->attribute = a;
+            }
+        }
+    }
+};
+
+
 XMLElement::XMLElement( XMLDocument* doc ) : XMLNode( doc ),
     _closingType( 0 ),
-    _rootAttribute( 0 )
+    _rootAttribute( 0 ),
+    _index( 0 )
 {
 }
 
@@ -1424,10 +1882,76 @@ XMLElement::~XMLElement()
         DeleteAttribute( _rootAttribute );
         _rootAttribute = next;
     }
+    delete _index;
+}
+
+
+const XMLElement::Index* XMLElement::GetIndex() const
+{
+    TIXMLASSERT( _document->IndexElements() );
+    if ( !_index ) {
+        _index = new Index();
+    }
+    else if ( _index->modifications == _document->_modifications ) {
+        return _index;
+    }
+    _index->Build( this );
+    _index->modifications = _document->_modifications;
+    return _index;
+}
+
+
+bool XMLElement::FindIndexedChild( const char* name, const XMLElement** first, const XMLElement** last ) const
+{
+    const Index* index = GetIndex();
+    if ( !index->children ) {
+        return false;
+    }
+    const unsigned hash = Index::Hash( name );
+    for( unsigned i = hash & index->childMask; index->children[i].name; i = ( i + 1 ) & index->childMask ) {
+        const Index::ChildSlot& slot = index->children[i];
+        if ( slot.hash == hash && XMLUtil::StringEqual( slot.name, name ) ) {
+            *first = slot.first;
+            *last = slot.last;
+            return true;
+        }
+    }
+    *first = *last = 0;
+    return true;
+}
+
+
+bool XMLElement::FindIndexedAttribute( const char* name, const XMLAttribute** attribute ) const
+{
+    const Index* index = GetIndex();
+    if ( !index->attributes ) {
+        return false;
+    }
+    const unsigned hash = Index::Hash( name );
+    const unsigned mask = index->attributeMask;
+    for( unsigned i = hash & mask; index->attributes[i].attribute; i = ( i + 1 ) & mask ) {
+        const Index::AttributeSlot& slot = index->attributes[i];
+        if ( slot.hash == hash && XMLUtil::StringEqual( slot.attribute->Name(), name ) ) {
+            *attribute = slot.attribute;
+            return true;
+        }
+    }
+    *attribute = 0;
+    return true;
 }
 
 
 const XMLAttribute* XMLElement::FindAttribute( const char* name ) const
+{
+    const XMLAttribute* attribute = 0;
+    if ( _document->IndexElements() && FindIndexedAttribute( name, &attribute ) ) {
+        return attribute;
+    }
+    return ScanAttributes( name );
+}
+
+
+const XMLAttribute* XMLElement::ScanAttributes( const char* name ) const
 {
     for( XMLAttribute* a = _rootAttribute; a; a = a->_next ) {
         if ( XMLUtil::StringEqual( a->Name(), name ) ) {
@@ -1621,6 +2145,7 @@ XMLAttribute* XMLElement::FindOrCreateAttribute( const char* name )
         }
         attrib->SetName( name );
         attrib->_memPool->SetTracked(); // always created and linked.
+        _document->Modified();
     }
     return attrib;
 }
@@ -1638,6 +2163,7 @@ void XMLElement::DeleteAttribute( const char* name )
                 _rootAttribute = a->_next;
             }
             DeleteAttribute( a );
+            _document->Modified();
             break;
         }
         prev = a;
@@ -1666,7 +2192,7 @@ char* XMLElement::ParseAttributes( char* p )
 			attrib->_memPool->SetTracked();
 
             p = attrib->ParseDeep( p, _document->ProcessEntities() );
-            if ( !p || Attribute( attrib->Name() ) ) {
+            if ( !p || ScanAttributes( attrib->Name() ) ) {
                 DeleteAttribute( attrib );
                 _document->SetError( XML_ERROR_PARSING_ATTRIBUTE, start, p );
                 return 0;
@@ -1829,9 +2355,13 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespace ) :
     XMLNode( 0 ),
     _writeBOM( false ),
     _processEntities( processEntities ),
+    _indexElements( false ),
+    _modifications( 0 ),
     _errorID(XML_SUCCESS),
     _whitespace( whitespace ),
-    _charBuffer( 0 )
+    _charBuffer( 0 ),
+    _mappedSize( 0 ),
+    _charBufferCapacity( 0 )
 {
     // avoid VC++ C4355 warning about 'this' in initializer list (C4355 is off by default in VS2012+)
     _document = this;
@@ -1845,6 +2375,28 @@ XMLDocument::~XMLDocument()
 
 
 void XMLDocument::Clear()
+{
+    Reset();
+
+    delete [] _charBuffer;
+    _charBuffer = 0;
+    _charBufferCapacity = 0;
+    if ( _elementPool.CurrentAllocs() == 0 ) {
+        _elementPool.Clear();
+    }
+    if ( _attributePool.CurrentAllocs() == 0 ) {
+        _attributePool.Clear();
+    }
+    if ( _textPool.CurrentAllocs() == 0 ) {
+        _textPool.Clear();
+    }
+    if ( _commentPool.CurrentAllocs() == 0 ) {
+        _commentPool.Clear();
+    }
+}
+
+
+void XMLDocument::Reset()
 {
     DeleteChildren();
 
@@ -1855,8 +2407,13 @@ void XMLDocument::Clear()
 	_errorStr1.Reset();
 	_errorStr2.Reset();
 
-    delete [] _charBuffer;
-    _charBuffer = 0;
+#if !defined(_WIN32)
+    if ( _mappedSize ) {
+        munmap( _charBuffer, _mappedSize );
+        _charBuffer = 0;
+        _mappedSize = 0;
+    }
+#endif
 
 #if 0
     _textPool.Trace( "text" );
@@ -1876,6 +2433,37 @@ void XMLDocument::Clear()
 }
 
 
+void XMLDocument::GetPoolStats( XMLPoolStats* elements, XMLPoolStats* attributes, XMLPoolStats* texts,
+                                XMLPoolStats* comments ) const
+{
+    if ( elements ) {
+        _elementPool.GetStats( elements );
+    }
+    if ( attributes ) {
+        _attributePool.GetStats( attributes );
+    }
+    if ( texts ) {
+        _textPool.GetStats( texts );
+    }
+    if ( comments ) {
+        _commentPool.GetStats( comments );
+    }
+}
+
+
+char* XMLDocument::AllocCharBuffer( size_t size )
+{
+    // Room for size characters and the null terminator, reusing the buffer kept by Reset() if it's big enough.
+    TIXMLASSERT( _mappedSize == 0 );
+    if ( size >= _charBufferCapacity ) {
+        delete [] _charBuffer;
+        _charBuffer = new char[size+1];
+        _charBufferCapacity = size+1;
+    }
+    return _charBuffer;
+}
+
+
 XMLElement* XMLDocument::NewElement( const char* name )
 {
     TIXMLASSERT( sizeof( XMLElement ) == _elementPool.ItemSize() );
@@ -1961,7 +2549,7 @@ void XMLDocument::DeleteNode( XMLNode* node )	{
 
 XMLError XMLDocument::LoadFile( const char* filename )
 {
-    Clear();
+    Reset();
     FILE* fp = callfopen( filename, "rb" );
     if ( !fp ) {
         SetError( XML_ERROR_FILE_NOT_FOUND, filename, 0 );
@@ -1997,7 +2585,7 @@ struct LongFitsIntoSizeTMinusOne<false> {
 
 XMLError XMLDocument::LoadFile( FILE* fp )
 {
-    Clear();
+    Reset();
 
     fseek( fp, 0, SEEK_SET );
     if ( fgetc( fp ) == EOF && ferror( fp ) != 0 ) {
@@ -2026,8 +2614,7 @@ XMLError XMLDocument::LoadFile( FILE* fp )
     }
 
     const size_t size = filelength;
-    TIXMLASSERT( _charBuffer == 0 );
-    _charBuffer = new char[size+1];
+    AllocCharBuffer( size );
     size_t read = fread( _charBuffer, 1, size, fp );
     if ( read != size ) {
         SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
@@ -2041,6 +2628,61 @@ XMLError XMLDocument::LoadFile( FILE* fp )
 }
 
 
+XMLError XMLDocument::LoadFileMapped( const char* filename )
+{
+#if defined(_WIN32)
+    return LoadFile( filename );
+#else
+    Reset();
+    delete [] _charBuffer;  // the text is parsed in the mapping instead
+    _charBuffer = 0;
+    _charBufferCapacity = 0;
+    const int fd = open( filename, O_RDONLY );
+    if ( fd < 0 ) {
+        SetError( XML_ERROR_FILE_NOT_FOUND, filename, 0 );
+        return _errorID;
+    }
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 || info.st_size < 0 ) {
+        close( fd );
+        SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
+        return _errorID;
+    }
+    if ( info.st_size == 0 ) {
+        close( fd );
+        SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
+        return _errorID;
+    }
+
+    // The parser needs a null terminator after the text. Past the end of the file the rest of its last page reads
+    // as zeros, unless the file ends exactly on a page boundary; then the file is mapped over the start of a zeroed
+    // anonymous mapping one page longer.
+    const size_t size = info.st_size;
+    const size_t page = sysconf( _SC_PAGESIZE );
+    const size_t mappedSize = ( size % page ) ? size : size + page;
+    void* mapped = mmap( 0, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( mapped != MAP_FAILED ) {
+        if ( mmap( mapped, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0 ) == MAP_FAILED ) {
+            munmap( mapped, mappedSize );
+            mapped = MAP_FAILED;
+        }
+    }
+    close( fd );    // the mapping keeps the file open
+    if ( mapped == MAP_FAILED ) {
+        SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
+        return _errorID;
+    }
+    madvise( mapped, size, MADV_SEQUENTIAL );
+
+    TIXMLASSERT( _charBuffer == 0 );
+    _charBuffer = static_cast<char*>( mapped );
+    _mappedSize = mappedSize;
+    Parse();
+    return _errorID;
+#endif
+}
+
+
 XMLError XMLDocument::SaveFile( const char* filename, bool compact )
 {
     FILE* fp = callfopen( filename, "w" );
@@ -2067,7 +2709,7 @@ XMLError XMLDocument::SaveFile( FILE* fp, bool compact )
 
 XMLError XMLDocument::Parse( const char* p, size_t len )
 {
-    Clear();
+    Reset();
 
     if ( len == 0 || !p || !*p ) {
         SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
@@ -2076,8 +2718,7 @@ XMLError XMLDocument::Parse( const char* p, size_t len )
     if ( len == (size_t)(-1) ) {
         len = strlen( p );
     }
-    TIXMLASSERT( _charBuffer == 0 );
-    _charBuffer = new char[ len+1 ];
+    AllocCharBuffer( len );
     memcpy( _charBuffer, p, len );
     _charBuffer[len] = 0;
 
@@ -2087,10 +2728,10 @@ XMLError XMLDocument::Parse( const char* p, size_t len )
         // and the parse fail can put objects in the
         // pools that are dead and inaccessible.
         DeleteChildren();
-        _elementPool.Clear();
-        _attributePool.Clear();
-        _textPool.Clear();
-        _commentPool.Clear();
+        _elementPool.Reset();
+        _attributePool.Reset();
+        _textPool.Reset();
+        _commentPool.Reset();
     }
     return _errorID;
 }